@@ -1,15 +1,11 @@
+#include <string.h>
+
 #include "fmi3Functions.h"
 #include "Custom.h"
+#include "model_variables.h"
+#include "ControllerVariables.h"
 #define MAX_MSG_SIZE 100
 
-typedef enum {
-	vr_r = 1,   // Clock
-	vr_ur = 3,      // Discrete state/output
-	vr_pre_ur = 4,  // Previous ur
-	vr_as = 5,      // Local var
-	vr_s = 6        // Clock from supervisor
-} ValueReference;
-
 typedef enum {
 	Instantiated = 1,
 	EventMode,
@@ -17,7 +13,9 @@ typedef enum {
 	Terminated
 } ModelState;
 
+// The fields are named after the variables in the modelDescription.xml
 typedef struct {
+	double time;    // Simulation time
 	bool r;         // Clock
 	double ur;      // Discrete state/output
 	double pre_ur;  // Previous ur
@@ -25,17 +23,37 @@ typedef struct {
 	bool s;         // Clock from supervisor
 } ControllerData;
 
+#define MODEL_DATA ControllerData
+
+static const VariableInfo variables[N_VALUE_REFERENCES] = { MODEL_VARIABLES(VARIABLE_INFO) };
+
+// Number of FMU states that can be stored at the same time
+#define N_FMU_STATES 8
+
+typedef struct {
+	bool used;
+	ControllerData data;
+} ControllerState;
+
 typedef struct {
 
 	const char* instanceName;
 
 	// callback functions
 	fmi3LogMessageCallback logMessage;
+	bool logCategories[N_LOG_CATEGORIES];  // enabled categories of LOG()
+
+	// Scheduled Execution: guard the data that the partitions share with the importer
+	fmi3LockPreemptionCallback lockPreemption;
+	fmi3UnlockPreemptionCallback unlockPreemption;
 
 	void* componentEnvironment;
 
 	ControllerData data;
 
+	// preallocated FMU states, so fmi3GetFMUState does not allocate
+	ControllerState fmuStates[N_FMU_STATES];
+
 	ModelState state;
 
 } ControllerInstance;
@@ -55,6 +73,7 @@ fmi3Instance fmi3InstantiateModelExchange(
 
 	comp->instanceName = instanceName;
 	comp->logMessage = logMessage;
+	initLogCategories(comp->logCategories, logMessage, loggingOn);
 	comp->componentEnvironment = instanceEnvironment;
 
 	fmi3Reset((fmi3Instance)comp);
@@ -82,6 +101,7 @@ fmi3Instance fmi3InstantiateCoSimulation(
 
 	comp->instanceName = instanceName;
 	comp->logMessage = logMessage;
+	initLogCategories(comp->logCategories, logMessage, loggingOn);
 	comp->componentEnvironment = instanceEnvironment;
 
 	fmi3Reset((fmi3Instance)comp);
@@ -89,10 +109,85 @@ fmi3Instance fmi3InstantiateCoSimulation(
 	return (fmi3Instance)comp;
 }
 
+fmi3Instance fmi3InstantiateScheduledExecution(
+    fmi3String                     instanceName,
+    fmi3String                     instantiationToken,
+    fmi3String                     resourcePath,
+    fmi3Boolean                    visible,
+    fmi3Boolean                    loggingOn,
+    fmi3InstanceEnvironment        instanceEnvironment,
+    fmi3LogMessageCallback         logMessage,
+    fmi3ClockUpdateCallback        clockUpdate,
+    fmi3LockPreemptionCallback     lockPreemption,
+    fmi3UnlockPreemptionCallback   unlockPreemption) {
+
+	// The controller has no output clocks, so clockUpdate is never called
+	ControllerInstance* comp = (ControllerInstance*)calloc(1, sizeof(ControllerInstance));
+
+	if (!comp) return NULL;
+
+	comp->instanceName = instanceName;
+	comp->logMessage = logMessage;
+	initLogCategories(comp->logCategories, logMessage, loggingOn);
+	comp->componentEnvironment = instanceEnvironment;
+	comp->lockPreemption = lockPreemption;
+	comp->unlockPreemption = unlockPreemption;
+
+	fmi3Reset((fmi3Instance)comp);
+
+	return (fmi3Instance)comp;
+}
+
+fmi3Status fmi3SetDebugLogging(fmi3Instance instance,
+    fmi3Boolean loggingOn,
+    size_t nCategories,
+    const fmi3String categories[]) {
+
+	ControllerInstance* comp = (ControllerInstance*)instance;
+
+	const size_t i = setLogCategories(comp->logCategories, comp->logMessage, loggingOn, nCategories, categories);
+
+	if (i < nCategories) {
+		LOG(comp, LogStatusError, fmi3Error, "Unknown log category: %s.", categories[i]);
+		return fmi3Error;
+	}
+
+	return fmi3OK;
+}
+
+// Model Exchange and Co-Simulation instances have no preemption callbacks
+static void lockData(ControllerInstance* comp) {
+	if (comp->lockPreemption) comp->lockPreemption();
+}
+
+static void unlockData(ControllerInstance* comp) {
+	if (comp->unlockPreemption) comp->unlockPreemption();
+}
+
+// Logs the first value reference that cannot be accessed
+static bool checkValueReferences(ControllerInstance* comp, VariableType type, bool set,
+	const fmi3ValueReference valueReferences[], size_t nValueReferences, size_t nValues) {
+
+	if (nValues != nValueReferences) {
+		LOG(comp, LogStatusError, fmi3Error, "Expected nValues = %zu but was %zu.", nValueReferences, nValues);
+		return false;
+	}
+
+	const size_t i = findInvalidValueReference(variables, N_VALUE_REFERENCES, type, set, valueReferences, nValueReferences);
+
+	if (i < nValueReferences) {
+		LOG(comp, LogStatusError, fmi3Error, "Unexpected value reference: %d.", valueReferences[i]);
+		return false;
+	}
+
+	return true;
+}
+
 fmi3Status fmi3Reset(fmi3Instance instance) {
 	fmi3Status status = fmi3OK;
 	ControllerInstance* comp = (ControllerInstance*)instance;
 
+	comp->data.time = 0.0;
 	comp->data.r = false;       // Clock
 	comp->data.ur = 0.0;                    // Discrete state/output
 	comp->data.pre_ur = 0.0;                // Previous ur
@@ -129,8 +224,6 @@ fmi3Status fmi3GetIntervalDecimal(fmi3Instance instance,
     fmi3Float64 intervals[],
     fmi3IntervalQualifier qualifiers[]) {
 
-	char msg_buff[MAX_MSG_SIZE];
-
 	ControllerInstance* comp = (ControllerInstance*)instance;
 
 	fmi3Status status = fmi3OK;
@@ -149,8 +242,7 @@ fmi3Status fmi3GetIntervalDecimal(fmi3Instance instance,
 				s = fmi3OK;
 				break;
 			default:
-				snprintf(msg_buff, MAX_MSG_SIZE, "Unexpected value reference: %d.", vr);
-				comp->logMessage(comp->componentEnvironment, status, "Error", msg_buff);
+				LOG(comp, LogStatusError, status, "Unexpected value reference: %d.", vr);
 				s = fmi3Error;
 		}
 		status = max(status, s);
@@ -166,8 +258,6 @@ fmi3Status fmi3GetIntervalFraction(fmi3Instance instance,
     fmi3UInt64 resolutions[],
     fmi3IntervalQualifier qualifiers[]) {
 
-    char msg_buff[MAX_MSG_SIZE];
-
 	ControllerInstance* comp = (ControllerInstance*)instance;
 
 	fmi3Status status = fmi3OK;
@@ -187,8 +277,7 @@ fmi3Status fmi3GetIntervalFraction(fmi3Instance instance,
 				s = fmi3OK;
 				break;
 			default:
-				snprintf(msg_buff, MAX_MSG_SIZE, "Unexpected value reference: %d.", vr);
-				comp->logMessage(comp->componentEnvironment, status, "Error", msg_buff);
+				LOG(comp, LogStatusError, status, "Unexpected value reference: %d.", vr);
 				s = fmi3Error;
 		}
 		status = max(status, s);
@@ -202,8 +291,6 @@ fmi3Status fmi3GetShiftDecimal(fmi3Instance instance,
     size_t nValueReferences,
     fmi3Float64 shifts[]) {
 
-	char msg_buff[MAX_MSG_SIZE];
-
 	ControllerInstance* comp = (ControllerInstance*)instance;
 
 	fmi3Status status = fmi3OK;
@@ -221,8 +308,7 @@ fmi3Status fmi3GetShiftDecimal(fmi3Instance instance,
 				s = fmi3OK;
 				break;
 			default:
-				snprintf(msg_buff, MAX_MSG_SIZE, "Unexpected value reference: %d.", vr);
-				comp->logMessage(comp->componentEnvironment, status, "Error", msg_buff);
+				LOG(comp, LogStatusError, status, "Unexpected value reference: %d.", vr);
 				s = fmi3Error;
 		}
 		status = max(status, s);
@@ -237,8 +323,6 @@ fmi3Status fmi3GetShiftFraction(fmi3Instance instance,
     fmi3UInt64 counters[],
     fmi3UInt64 resolutions[]) {
     
-	char msg_buff[MAX_MSG_SIZE];
-
 	ControllerInstance* comp = (ControllerInstance*)instance;
 
 	fmi3Status status = fmi3OK;
@@ -257,8 +341,7 @@ fmi3Status fmi3GetShiftFraction(fmi3Instance instance,
 				s = fmi3OK;
 				break;
 			default:
-				snprintf(msg_buff, MAX_MSG_SIZE, "Unexpected value reference: %d.", vr);
-				comp->logMessage(comp->componentEnvironment, status, "Error", msg_buff);
+				LOG(comp, LogStatusError, status, "Unexpected value reference: %d.", vr);
 				s = fmi3Error;
 		}
 		status = max(status, s);
@@ -277,8 +360,6 @@ fmi3Status fmi3GetEventIndicators(fmi3Instance instance,
     fmi3Float64 eventIndicators[],
     size_t nEventIndicators) {
     
-	char msg_buff[MAX_MSG_SIZE];
-
 	ControllerInstance* comp = (ControllerInstance*)instance;
 
 	fmi3Status status = fmi3OK;
@@ -286,8 +367,7 @@ fmi3Status fmi3GetEventIndicators(fmi3Instance instance,
 	if (nEventIndicators == 0) return status;
 
 	if (nEventIndicators != 0) {
-		snprintf(msg_buff, MAX_MSG_SIZE, "Unexpected nEventIndicators: %zd.", nEventIndicators);
-		comp->logMessage(comp->componentEnvironment, status, "Error", msg_buff);
+		LOG(comp, LogStatusError, status, "Unexpected nEventIndicators: %zd.", nEventIndicators);
 		status = fmi3Error;
 	}
 
@@ -304,8 +384,6 @@ fmi3Status fmi3GetContinuousStateDerivatives(fmi3Instance instance,
     fmi3Float64 derivatives[],
     size_t nContinuousStates) {
 
-    char msg_buff[MAX_MSG_SIZE];
-
 	ControllerInstance* comp = (ControllerInstance*)instance;
 
 	fmi3Status status = fmi3OK;
@@ -313,8 +391,7 @@ fmi3Status fmi3GetContinuousStateDerivatives(fmi3Instance instance,
 	if (nContinuousStates == 0) return status;
 
 	if (nContinuousStates != 0) {
-		snprintf(msg_buff, MAX_MSG_SIZE, "Unexpected nContinuousStates: %zd.", nContinuousStates);
-		comp->logMessage(comp->componentEnvironment, status, "Error", msg_buff);
+		LOG(comp, LogStatusError, status, "Unexpected nContinuousStates: %zd.", nContinuousStates);
 		status = fmi3Error;
 	}
 	
@@ -325,8 +402,6 @@ fmi3Status fmi3GetContinuousStates(fmi3Instance instance,
     fmi3Float64 continuousStates[],
     size_t nContinuousStates) {
 	
-	char msg_buff[MAX_MSG_SIZE];
-
 	ControllerInstance* comp = (ControllerInstance*)instance;
 
 	fmi3Status status = fmi3OK;
@@ -334,8 +409,7 @@ fmi3Status fmi3GetContinuousStates(fmi3Instance instance,
 	if (nContinuousStates == 0) return status;
 
 	if (nContinuousStates != 0) {
-		snprintf(msg_buff, MAX_MSG_SIZE, "Unexpected nContinuousStates: %zd.", nContinuousStates);
-		comp->logMessage(comp->componentEnvironment, status, "Error", msg_buff);
+		LOG(comp, LogStatusError, status, "Unexpected nContinuousStates: %zd.", nContinuousStates);
 		status = fmi3Error;
 	}
 
@@ -348,51 +422,26 @@ fmi3Status fmi3GetFloat64(fmi3Instance instance,
 	fmi3Float64 values[],
 	size_t nValues) {
 
-	char msg_buff[MAX_MSG_SIZE];
-
 	ControllerInstance* comp = (ControllerInstance*)instance;
 
-	fmi3Status status = fmi3OK;
+	if (!checkValueReferences(comp, VariableFloat64, false, valueReferences, nValueReferences, nValues)) return fmi3Error;
 
-	if (nValueReferences == 0) return status;
+	lockData(comp);
 
-	size_t i;
+	getFloat64Variables(variables, &comp->data, valueReferences, nValueReferences, values);
 
-	for (i = 0; i < nValueReferences; i++) {
-		fmi3Status s;
-		ValueReference vr = valueReferences[i];
-		switch (vr) {
-		case vr_ur:
-			if (comp->data.r == true) {
-				values[i] = comp->data.ur + comp->data.as;
+	// While clock r ticks, ur already has the value of fmi3UpdateDiscreteStates
+	if (comp->data.r) {
+		for (size_t i = 0; i < nValueReferences; i++) {
+			if (valueReferences[i] == vr_ur) {
+				values[i] += comp->data.as;
 			}
-			else {
-				values[i] = comp->data.ur;
-			}
-			s = fmi3OK;
-			break;
-		case vr_pre_ur:
-			values[i] = comp->data.pre_ur;
-			s = fmi3OK;
-			break;
-		case vr_as:
-			values[i] = comp->data.as;
-			s = fmi3OK;
-			break;
-		default:
-			snprintf(msg_buff, MAX_MSG_SIZE, "Unexpected value reference: %d.", vr);
-			comp->logMessage(comp->componentEnvironment, status, "Error", msg_buff);
-			s = fmi3Error;
 		}
-		status = max(status, s);
-		if (status > fmi3Warning) return status;
 	}
-	if (i != nValues) {
-		snprintf(msg_buff, MAX_MSG_SIZE, "Expected nValues = %zu but was %zu.", i, nValues);
-		comp->logMessage(comp->componentEnvironment, status, "Error", msg_buff);
-		return fmi3Error;
-	}
-	return status;
+
+	unlockData(comp);
+
+	return fmi3OK;
 }
 
 fmi3Status fmi3GetClock(fmi3Instance instance,
@@ -409,38 +458,17 @@ fmi3Status fmi3SetFloat64(fmi3Instance instance,
 	const fmi3Float64 values[],
 	size_t nValues) {
 
-	char msg_buff[MAX_MSG_SIZE];
-
 	ControllerInstance* comp = (ControllerInstance*)instance;
 
-	fmi3Status status = fmi3OK;
+	if (!checkValueReferences(comp, VariableFloat64, true, valueReferences, nValueReferences, nValues)) return fmi3Error;
 
-	if (nValueReferences == 0) return status;
+	lockData(comp);
 
-	size_t i;
+	setFloat64Variables(variables, &comp->data, valueReferences, nValueReferences, values);
 
-	for (i = 0; i < nValueReferences; i++) {
-		fmi3Status s;
-		ValueReference vr = valueReferences[i];
-		switch (vr) {
-		case vr_as:
-			comp->data.as = values[i];
-			s = fmi3OK;
-			break;
-		default:
-			snprintf(msg_buff, MAX_MSG_SIZE, "Unexpected value reference: %d.", vr);
-			comp->logMessage(comp->componentEnvironment, status, "Error", msg_buff);
-			s = fmi3Error;
-		}
-		status = max(status, s);
-		if (status > fmi3Warning) return status;
-	}
-	if (i != nValues) {
-		snprintf(msg_buff, MAX_MSG_SIZE, "Expected nValues = %zu but was %zu.", i, nValues);
-		comp->logMessage(comp->componentEnvironment, status, "Error", msg_buff);
-		return fmi3Error;
-	}
-	return status;
+	unlockData(comp);
+
+	return fmi3OK;
 }
 
 fmi3Status fmi3SetClock(fmi3Instance instance,
@@ -448,44 +476,18 @@ fmi3Status fmi3SetClock(fmi3Instance instance,
 	size_t nValueReferences,
 	const fmi3Clock values[]) {
 
-	char msg_buff[MAX_MSG_SIZE];
-
 	ControllerInstance* comp = (ControllerInstance*)instance;
 
-	fmi3Status status = fmi3OK;
-
-	if (nValueReferences == 0) return status;
-
-	fmi3Status s;
+	if (!checkValueReferences(comp, VariableClock, true, valueReferences, nValueReferences, nValueReferences)) return fmi3Error;
 
-	size_t i;
-
-	for (i = 0; i < nValueReferences; i++) {
-		fmi3Status s;
-		ValueReference vr = valueReferences[i];
-		switch (vr) {
-		case vr_r:
-			comp->data.r = values[i];
-			s = fmi3OK;
-			break;
-		case vr_s:
-			comp->data.s = values[i];
-			s = fmi3OK;
-			break;
-		default:
-			snprintf(msg_buff, MAX_MSG_SIZE, "Unexpected value reference: %d.", vr);
-			comp->logMessage(comp->componentEnvironment, status, "Error", msg_buff);
-			s = fmi3Error;
-		}
-		status = max(status, s);
-		if (status > fmi3Warning) return status;
-	}
+	setClockVariables(variables, &comp->data, valueReferences, nValueReferences, values);
 
-	return status;
+	return fmi3OK;
 }
 
 fmi3Status fmi3SetTime(fmi3Instance instance, fmi3Float64 time) {
 	ControllerInstance* comp = (ControllerInstance*)instance;
+	comp->data.time = time;
 	return fmi3OK;
 }
 
@@ -493,8 +495,6 @@ fmi3Status fmi3SetContinuousStates(fmi3Instance instance,
     const fmi3Float64 continuousStates[],
     size_t nContinuousStates) {
 	
-    char msg_buff[MAX_MSG_SIZE];
-
 	ControllerInstance* comp = (ControllerInstance*)instance;
 
 	fmi3Status status = fmi3OK;
@@ -502,8 +502,7 @@ fmi3Status fmi3SetContinuousStates(fmi3Instance instance,
 	if (nContinuousStates == 0) return status;
 
 	if (nContinuousStates != 0) {
-		snprintf(msg_buff, MAX_MSG_SIZE, "Unexpected nContinuousStates: %zd.", nContinuousStates);
-		comp->logMessage(comp->componentEnvironment, status, "Error", msg_buff);
+		LOG(comp, LogStatusError, status, "Unexpected nContinuousStates: %zd.", nContinuousStates);
 		status = fmi3Error;
 	}
 
@@ -524,8 +523,6 @@ fmi3Status fmi3UpdateDiscreteStates(fmi3Instance instance,
     fmi3Boolean* nextEventTimeDefined,
     fmi3Float64* nextEventTime) {
     
-	char msg_buff[MAX_MSG_SIZE];
-
 	ControllerInstance* comp = (ControllerInstance*)instance;
 
 	fmi3Status status = fmi3OK;
@@ -542,6 +539,87 @@ fmi3Status fmi3UpdateDiscreteStates(fmi3Instance instance,
 	return status;
 }
 
+fmi3Status fmi3ActivateModelPartition(fmi3Instance instance,
+	fmi3ValueReference clockReference,
+	fmi3Float64 activationTime) {
+
+	ControllerInstance* comp = (ControllerInstance*)instance;
+
+	fmi3Status status = fmi3OK;
+
+	switch (clockReference) {
+	case vr_r:
+		// The importer may preempt this task, e.g. to set as, so the update must be atomic
+		lockData(comp);
+		comp->data.pre_ur = comp->data.ur;
+		comp->data.ur = comp->data.ur + comp->data.as;
+		unlockData(comp);
+		break;
+	case vr_s:
+		// as is set by the importer before the activation, nothing to compute
+		break;
+	default:
+		LOG(comp, LogStatusError, fmi3Error, "Unexpected clock reference: %d.", clockReference);
+		status = fmi3Error;
+	}
+
+	return status;
+}
+
+fmi3Status fmi3GetDirectionalDerivative(fmi3Instance instance,
+	const fmi3ValueReference unknowns[],
+	size_t nUnknowns,
+	const fmi3ValueReference knowns[],
+	size_t nKnowns,
+	const fmi3Float64 seed[],
+	size_t nSeed,
+	fmi3Float64 sensitivity[],
+	size_t nSensitivity) {
+
+	fmi3Status status = fmi3Error;
+
+	ControllerInstance* comp = (ControllerInstance*)instance;
+
+	LOG(comp, LogStatusError, status, "Function not relevant for this fmu.");
+
+	return status;
+}
+
+fmi3Status fmi3GetAdjointDerivative(fmi3Instance instance,
+	const fmi3ValueReference unknowns[],
+	size_t nUnknowns,
+	const fmi3ValueReference knowns[],
+	size_t nKnowns,
+	const fmi3Float64 seed[],
+	size_t nSeed,
+	fmi3Float64 sensitivity[],
+	size_t nSensitivity) {
+
+	fmi3Status status = fmi3Error;
+
+	ControllerInstance* comp = (ControllerInstance*)instance;
+
+	LOG(comp, LogStatusError, status, "Function not relevant for this fmu.");
+
+	return status;
+}
+
+fmi3Status fmi3GetOutputDerivatives(fmi3Instance instance,
+	const fmi3ValueReference valueReferences[],
+	size_t nValueReferences,
+	const fmi3Int32 orders[],
+	fmi3Float64 values[],
+	size_t nValues) {
+
+	fmi3Status status = fmi3Error;
+
+	ControllerInstance* comp = (ControllerInstance*)instance;
+
+	LOG(comp, LogStatusError, status, "Function not relevant for this fmu.");
+
+	return status;
+}
+
 fmi3Status fmi3DoStep(fmi3Instance instance,
 	fmi3Float64 currentCommunicationPoint,
 	fmi3Float64 communicationStepSize,
@@ -571,6 +649,130 @@ fmi3Status fmi3Terminate(fmi3Instance instance) {
 	return fmi3OK;
 }
 
+/* Getting and setting the internal FMU state */
+static fmi3Status invalidFMUState(ControllerInstance* comp, const char* function) {
+
+	LOG(comp, LogStatusError, fmi3Error, "%s: invalid FMU state.", function);
+
+	return fmi3Error;
+}
+
+static ControllerState* findFMUState(ControllerInstance* comp, fmi3FMUState FMUState) {
+
+	for (size_t i = 0; i < N_FMU_STATES; i++) {
+		if (FMUState == &comp->fmuStates[i] && comp->fmuStates[i].used) {
+			return &comp->fmuStates[i];
+		}
+	}
+
+	return NULL;
+}
+
+static ControllerState* allocateFMUState(ControllerInstance* comp) {
+
+	for (size_t i = 0; i < N_FMU_STATES; i++) {
+		if (!comp->fmuStates[i].used) {
+			comp->fmuStates[i].used = true;
+			return &comp->fmuStates[i];
+		}
+	}
+
+	LOG(comp, LogStatusError, fmi3Error, "All %d FMU states are in use.", N_FMU_STATES);
+
+	return NULL;
+}
+
+fmi3Status fmi3GetFMUState(fmi3Instance instance, fmi3FMUState* FMUState) {
+
+	ControllerInstance* comp = (ControllerInstance*)instance;
+
+	// An existing state is overwritten
+	ControllerState* state = *FMUState ? findFMUState(comp, *FMUState) : allocateFMUState(comp);
+
+	if (!state) return *FMUState ? invalidFMUState(comp, "fmi3GetFMUState") : fmi3Error;
+
+	state->data = comp->data;
+
+	*FMUState = (fmi3FMUState)state;
+
+	return fmi3OK;
+}
+
+fmi3Status fmi3SetFMUState(fmi3Instance instance, fmi3FMUState FMUState) {
+
+	ControllerInstance* comp = (ControllerInstance*)instance;
+
+	const ControllerState* state = findFMUState(comp, FMUState);
+
+	if (!state) return invalidFMUState(comp, "fmi3SetFMUState");
+
+	comp->data = state->data;
+
+	return fmi3OK;
+}
+
+fmi3Status fmi3FreeFMUState(fmi3Instance instance, fmi3FMUState* FMUState) {
+
+	ControllerInstance* comp = (ControllerInstance*)instance;
+
+	if (!FMUState || !*FMUState) return fmi3OK;
+
+	ControllerState* state = findFMUState(comp, *FMUState);
+
+	if (!state) return invalidFMUState(comp, "fmi3FreeFMUState");
+
+	state->used = false;
+
+	*FMUState = NULL;
+
+	return fmi3OK;
+}
+
+fmi3Status fmi3SerializedFMUStateSize(fmi3Instance instance,
+	fmi3FMUState FMUState,
+	size_t* size) {
+
+	*size = sizeof(ControllerData);
+
+	return fmi3OK;
+}
+
+fmi3Status fmi3SerializeFMUState(fmi3Instance instance,
+	fmi3FMUState FMUState,
+	fmi3Byte serializedState[],
+	size_t size) {
+
+	ControllerInstance* comp = (ControllerInstance*)instance;
+
+	const ControllerState* state = findFMUState(comp, FMUState);
+
+	if (!state || size != sizeof(ControllerData)) return invalidFMUState(comp, "fmi3SerializeFMUState");
+
+	memcpy(serializedState, &state->data, sizeof(ControllerData));
+
+	return fmi3OK;
+}
+
+fmi3Status fmi3DeserializeFMUState(fmi3Instance instance,
+	const fmi3Byte serializedState[],
+	size_t size,
+	fmi3FMUState* FMUState) {
+
+	ControllerInstance* comp = (ControllerInstance*)instance;
+
+	if (size != sizeof(ControllerData)) return invalidFMUState(comp, "fmi3DeserializeFMUState");
+
+	ControllerState* state = *FMUState ? findFMUState(comp, *FMUState) : allocateFMUState(comp);
+
+	if (!state) return *FMUState ? invalidFMUState(comp, "fmi3DeserializeFMUState") : fmi3Error;
+
+	memcpy(&state->data, serializedState, sizeof(ControllerData));
+
+	*FMUState = (fmi3FMUState)state;
+
+	return fmi3OK;
+}
+
 void fmi3FreeInstance(fmi3Instance instance) {
 	free(instance);
 }
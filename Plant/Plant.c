@@ -1,33 +1,57 @@
+#include <string.h>
+#include <math.h>
+
 #include "fmi3Functions.h"
 #include "Custom.h"
+#include "model_variables.h"
+#include "PlantVariables.h"
 
 #define MAX_MSG_SIZE 100
 
-typedef enum {
-	vr_time = 0, // time
-	vr_x = 1, // continuous state
-	vr_der_x = 2, // derivative of continuous state
-	vr_u = 3 // input
-} ValueReference;
-
+// The fields are named after the variables in the modelDescription.xml
 typedef struct {
 	fmi3Float64 time; // time
 	fmi3Float64 x; // continuous state
 	fmi3Float64 der_x; // derivative of continuous state
-	fmi3Float64 u; // input
+	fmi3Float64 u_r; // input
+	fmi3Float64 maxStepSize; // parameter: maximum internal step size of fmi3DoStep
+	fmi3Float64 tolerance; // parameter: tolerance of the internal step size control
 } PlantData;
 
+#define MODEL_DATA PlantData
+
+static const VariableInfo variables[N_VALUE_REFERENCES] = { MODEL_VARIABLES(VARIABLE_INFO) };
+
+// Bounds of the factor by which the step size control changes the internal step
+#define MIN_STEP_SIZE_FACTOR 0.2
+#define MAX_STEP_SIZE_FACTOR 4.0
+
+// Smallest internal step relative to the communication step, steps below are accepted regardless of the error
+#define MIN_STEP_SIZE_RATIO 1e-6
+
+// Number of FMU states that can be stored at the same time
+#define N_FMU_STATES 8
+
+typedef struct {
+	bool used;
+	PlantData data;
+} PlantState;
+
 typedef struct {
 
 	const char* instanceName;
 
 	// callback functions
 	fmi3LogMessageCallback logMessage;
+	bool logCategories[N_LOG_CATEGORIES];  // enabled categories of LOG()
 
 	void* componentEnvironment;
 
 	PlantData data;
 
+	// preallocated FMU states, so fmi3GetFMUState does not allocate
+	PlantState fmuStates[N_FMU_STATES];
+
 } PlantInstance;
 
 fmi3Instance fmi3InstantiateModelExchange(
@@ -45,6 +69,7 @@ fmi3Instance fmi3InstantiateModelExchange(
 
 	comp->instanceName = instanceName;
 	comp->logMessage = logMessage;
+	initLogCategories(comp->logCategories, logMessage, loggingOn);
 	comp->componentEnvironment = instanceEnvironment;
 
 	fmi3Reset((fmi3Instance)comp);
@@ -72,6 +97,7 @@ fmi3Instance fmi3InstantiateCoSimulation(
 
 	comp->instanceName = instanceName;
 	comp->logMessage = logMessage;
+	initLogCategories(comp->logCategories, logMessage, loggingOn);
 	comp->componentEnvironment = instanceEnvironment;
 
 	fmi3Reset((fmi3Instance)comp);
@@ -79,6 +105,42 @@ fmi3Instance fmi3InstantiateCoSimulation(
 	return (fmi3Instance)comp;
 }
 
+fmi3Instance fmi3InstantiateScheduledExecution(
+    fmi3String                     instanceName,
+    fmi3String                     instantiationToken,
+    fmi3String                     resourcePath,
+    fmi3Boolean                    visible,
+    fmi3Boolean                    loggingOn,
+    fmi3InstanceEnvironment        instanceEnvironment,
+    fmi3LogMessageCallback         logMessage,
+    fmi3ClockUpdateCallback        clockUpdate,
+    fmi3LockPreemptionCallback     lockPreemption,
+    fmi3UnlockPreemptionCallback   unlockPreemption) {
+
+	if (logMessage) {
+		logMessage(instanceEnvironment, fmi3Error, "logStatusError", "Scheduled Execution is not supported by this fmu.");
+	}
+
+	return NULL;
+}
+
+fmi3Status fmi3SetDebugLogging(fmi3Instance instance,
+    fmi3Boolean loggingOn,
+    size_t nCategories,
+    const fmi3String categories[]) {
+
+	PlantInstance* comp = (PlantInstance*)instance;
+
+	const size_t i = setLogCategories(comp->logCategories, comp->logMessage, loggingOn, nCategories, categories);
+
+	if (i < nCategories) {
+		LOG(comp, LogStatusError, fmi3Error, "Unknown log category: %s.", categories[i]);
+		return fmi3Error;
+	}
+
+	return fmi3OK;
+}
+
 fmi3Status fmi3Reset(fmi3Instance instance) {
 	fmi3Status status = fmi3OK;
 	PlantInstance* comp = (PlantInstance*)instance;
@@ -86,7 +148,9 @@ fmi3Status fmi3Reset(fmi3Instance instance) {
 	comp->data.time = 0.0;
 	comp->data.x = 0.0;
 	comp->data.der_x = 0.0;
-	comp->data.u = 0.0;
+	comp->data.u_r = 0.0;
+	comp->data.maxStepSize = 0.0;
+	comp->data.tolerance = 0.0;
 
 	return status;
 }
@@ -114,14 +178,11 @@ fmi3Status fmi3GetIntervalDecimal(fmi3Instance instance,
     fmi3Float64 intervals[],
     fmi3IntervalQualifier qualifiers[]) {
 
-	char msg_buff[MAX_MSG_SIZE];
-
 	fmi3Status status = fmi3Error;
 
 	PlantInstance* comp = (PlantInstance*)instance;
 
-	snprintf(msg_buff, MAX_MSG_SIZE, "Function not relevant for this fmu.");
-	comp->logMessage(comp->componentEnvironment, status, "Error", msg_buff);
+	LOG(comp, LogStatusError, status, "Function not relevant for this fmu.");
 
 	return status;
 }
@@ -133,14 +194,11 @@ fmi3Status fmi3GetIntervalFraction(fmi3Instance instance,
     fmi3UInt64 resolutions[],
     fmi3IntervalQualifier qualifiers[]) {
 
-	char msg_buff[MAX_MSG_SIZE];
-
 	fmi3Status status = fmi3Error;
 
 	PlantInstance* comp = (PlantInstance*)instance;
 
-	snprintf(msg_buff, MAX_MSG_SIZE, "Function not relevant for this fmu.");
-	comp->logMessage(comp->componentEnvironment, status, "Error", msg_buff);
+	LOG(comp, LogStatusError, status, "Function not relevant for this fmu.");
 
 	return status;
 }
@@ -150,14 +208,11 @@ fmi3Status fmi3GetShiftDecimal(fmi3Instance instance,
     const fmi3ValueReference valueReferences[],
     size_t nValueReferences,
     fmi3Float64 shifts[]) {
-    char msg_buff[MAX_MSG_SIZE];
-
 	fmi3Status status = fmi3Error;
 
 	PlantInstance* comp = (PlantInstance*)instance;
 
-	snprintf(msg_buff, MAX_MSG_SIZE, "Function not relevant for this fmu.");
-	comp->logMessage(comp->componentEnvironment, status, "Error", msg_buff);
+	LOG(comp, LogStatusError, status, "Function not relevant for this fmu.");
 
 	return status;
 }
@@ -167,14 +222,11 @@ fmi3Status fmi3GetShiftFraction(fmi3Instance instance,
     size_t nValueReferences,
     fmi3UInt64 counters[],
     fmi3UInt64 resolutions[]) {
-    char msg_buff[MAX_MSG_SIZE];
-
 	fmi3Status status = fmi3Error;
 
 	PlantInstance* comp = (PlantInstance*)instance;
 
-	snprintf(msg_buff, MAX_MSG_SIZE, "Function not relevant for this fmu.");
-	comp->logMessage(comp->componentEnvironment, status, "Error", msg_buff);
+	LOG(comp, LogStatusError, status, "Function not relevant for this fmu.");
 
 	return status;
 }
@@ -190,8 +242,6 @@ fmi3Status fmi3GetEventIndicators(fmi3Instance instance,
     fmi3Float64 eventIndicators[],
     size_t nEventIndicators) {
     
-	char msg_buff[MAX_MSG_SIZE];
-
 	PlantInstance* comp = (PlantInstance*)instance;
 
 	fmi3Status status = fmi3OK;
@@ -199,8 +249,7 @@ fmi3Status fmi3GetEventIndicators(fmi3Instance instance,
 	if (nEventIndicators == 0) return status;
 
 	if (nEventIndicators != 0) {
-		snprintf(msg_buff, MAX_MSG_SIZE, "Unexpected nEventIndicators: %zd.", nEventIndicators);
-		comp->logMessage(comp->componentEnvironment, status, "Error", msg_buff);
+		LOG(comp, LogStatusError, status, "Unexpected nEventIndicators: %zd.", nEventIndicators);
 		status = fmi3Error;
 	}
 
@@ -213,16 +262,37 @@ fmi3Status fmi3GetNumberOfContinuousStates(fmi3Instance instance,
     return fmi3OK;
 }
 
+static fmi3Float64 derivative(fmi3Float64 x, fmi3Float64 u) {
+	return - x + u;
+}
+
 void update_derivative(PlantInstance* comp) {
-	comp->data.der_x = - comp->data.x + comp->data.u;
+	comp->data.der_x = derivative(comp->data.x, comp->data.u_r);
+}
+
+// Logs the first value reference that cannot be accessed
+static bool checkValueReferences(PlantInstance* comp, VariableType type, bool set,
+	const fmi3ValueReference valueReferences[], size_t nValueReferences, size_t nValues) {
+
+	if (nValues != nValueReferences) {
+		LOG(comp, LogStatusError, fmi3Error, "Expected nValues = %zu but was %zu.", nValueReferences, nValues);
+		return false;
+	}
+
+	const size_t i = findInvalidValueReference(variables, N_VALUE_REFERENCES, type, set, valueReferences, nValueReferences);
+
+	if (i < nValueReferences) {
+		LOG(comp, LogStatusError, fmi3Error, "Unexpected value reference: %d.", valueReferences[i]);
+		return false;
+	}
+
+	return true;
 }
 
 fmi3Status fmi3GetContinuousStateDerivatives(fmi3Instance instance,
     fmi3Float64 derivatives[],
     size_t nContinuousStates) {
 
-    char msg_buff[MAX_MSG_SIZE];
-
 	PlantInstance* comp = (PlantInstance*)instance;
 
 	fmi3Status status = fmi3OK;
@@ -230,8 +300,7 @@ fmi3Status fmi3GetContinuousStateDerivatives(fmi3Instance instance,
 	if (nContinuousStates == 0) return status;
 
 	if (nContinuousStates != 1) {
-		snprintf(msg_buff, MAX_MSG_SIZE, "Unexpected nContinuousStates: %zd.", nContinuousStates);
-		comp->logMessage(comp->componentEnvironment, status, "Error", msg_buff);
+		LOG(comp, LogStatusError, status, "Unexpected nContinuousStates: %zd.", nContinuousStates);
 		status = fmi3Error;
 	}
 
@@ -248,48 +317,13 @@ fmi3Status fmi3GetFloat64(fmi3Instance instance,
 	fmi3Float64 values[],
 	size_t nValues) {
 
-	char msg_buff[MAX_MSG_SIZE];
-
 	PlantInstance* comp = (PlantInstance*)instance;
 
-	fmi3Status status = fmi3OK;
+	if (!checkValueReferences(comp, VariableFloat64, false, valueReferences, nValueReferences, nValues)) return fmi3Error;
 
-	if (nValueReferences == 0) return status;
-
-	fmi3Status s;
-
-	size_t i;
-
-	for (i = 0; i < nValueReferences; i++) {
-		fmi3Status s;
-		ValueReference vr = valueReferences[i];
-		switch (vr) {
-		case vr_time:
-			values[i] = comp->data.time;
-			s = fmi3OK;
-			break;
-		case vr_x:
-			values[i] = comp->data.x;
-			s = fmi3OK;
-			break;
-		case vr_der_x:
-			values[i] = comp->data.der_x;
-			s = fmi3OK;
-			break;
-		case vr_u:
-			values[i] = comp->data.u;
-			s = fmi3OK;
-			break;
-		default:
-			snprintf(msg_buff, MAX_MSG_SIZE, "Unexpected value reference: %d.", vr);
-			comp->logMessage(comp->componentEnvironment, status, "Error", msg_buff);
-			s = fmi3Error;
-		}
-		status = max(status, s);
-		if (status > fmi3Warning) return status;
-	}
+	getFloat64Variables(variables, &comp->data, valueReferences, nValueReferences, values);
 
-	return status;
+	return fmi3OK;
 }
 
 fmi3Status fmi3GetClock(fmi3Instance instance,
@@ -305,8 +339,6 @@ fmi3Status fmi3GetContinuousStates(fmi3Instance instance,
     fmi3Float64 continuousStates[],
     size_t nContinuousStates) {
 	
-	char msg_buff[MAX_MSG_SIZE];
-
 	PlantInstance* comp = (PlantInstance*)instance;
 
 	fmi3Status status = fmi3OK;
@@ -314,8 +346,7 @@ fmi3Status fmi3GetContinuousStates(fmi3Instance instance,
 	if (nContinuousStates == 0) return status;
 
 	if (nContinuousStates != 1) {
-		snprintf(msg_buff, MAX_MSG_SIZE, "Unexpected nContinuousStates: %zd.", nContinuousStates);
-		comp->logMessage(comp->componentEnvironment, status, "Error", msg_buff);
+		LOG(comp, LogStatusError, status, "Unexpected nContinuousStates: %zd.", nContinuousStates);
 		status = fmi3Error;
 	}
 
@@ -334,8 +365,6 @@ fmi3Status fmi3SetContinuousStates(fmi3Instance instance,
     const fmi3Float64 continuousStates[],
     size_t nContinuousStates) {
 	
-    char msg_buff[MAX_MSG_SIZE];
-
 	PlantInstance* comp = (PlantInstance*)instance;
 
 	fmi3Status status = fmi3OK;
@@ -343,8 +372,7 @@ fmi3Status fmi3SetContinuousStates(fmi3Instance instance,
 	if (nContinuousStates == 0) return status;
 
 	if (nContinuousStates != 1) {
-		snprintf(msg_buff, MAX_MSG_SIZE, "Unexpected nContinuousStates: %zd.", nContinuousStates);
-		comp->logMessage(comp->componentEnvironment, status, "Error", msg_buff);
+		LOG(comp, LogStatusError, status, "Unexpected nContinuousStates: %zd.", nContinuousStates);
 		status = fmi3Error;
 	}
 
@@ -359,36 +387,20 @@ fmi3Status fmi3SetFloat64(fmi3Instance instance,
 	const fmi3Float64 values[],
 	size_t nValues) {
 
-	char msg_buff[MAX_MSG_SIZE];
-
 	PlantInstance* comp = (PlantInstance*)instance;
 
-	fmi3Status status = fmi3OK;
-
-	if (nValueReferences == 0) return status;
+	if (!checkValueReferences(comp, VariableFloat64, true, valueReferences, nValueReferences, nValues)) return fmi3Error;
 
-	fmi3Status s;
+	setFloat64Variables(variables, &comp->data, valueReferences, nValueReferences, values);
 
-	size_t i;
-
-	for (i = 0; i < nValueReferences; i++) {
-		fmi3Status s;
-		ValueReference vr = valueReferences[i];
-		switch (vr) {
-		case vr_u:
-			comp->data.u = values[i];
-			s = fmi3OK;
-			break;
-		default:
-			snprintf(msg_buff, MAX_MSG_SIZE, "Unexpected value reference: %d.", vr);
-			comp->logMessage(comp->componentEnvironment, status, "Error", msg_buff);
-			s = fmi3Error;
-		}
-		status = max(status, s);
-		if (status > fmi3Warning) return status;
+	if (comp->data.maxStepSize < 0.0 || comp->data.tolerance < 0.0) {
+		comp->data.maxStepSize = max(comp->data.maxStepSize, 0.0);
+		comp->data.tolerance = max(comp->data.tolerance, 0.0);
+		LOG(comp, LogStatusError, fmi3Error, "maxStepSize and tolerance must not be negative.");
+		return fmi3Error;
 	}
 
-	return status;
+	return fmi3OK;
 }
 
 fmi3Status fmi3SetClock(fmi3Instance instance,
@@ -415,6 +427,216 @@ fmi3Status fmi3UpdateDiscreteStates(fmi3Instance instance,
 	return status;
 }
 
+fmi3Status fmi3ActivateModelPartition(fmi3Instance instance,
+	fmi3ValueReference clockReference,
+	fmi3Float64 activationTime) {
+
+	fmi3Status status = fmi3Error;
+
+	PlantInstance* comp = (PlantInstance*)instance;
+
+	LOG(comp, LogStatusError, status, "Function not relevant for this fmu.");
+
+	return status;
+}
+
+/* Getting partial derivatives of der(x) = -x + u_r and of the output x */
+static bool partialDerivative(fmi3ValueReference unknown, fmi3ValueReference known, fmi3Float64* value) {
+
+	if (known != vr_x && known != vr_u_r) return false;
+
+	switch (unknown) {
+	case vr_x:
+		*value = known == vr_x ? 1.0 : 0.0;
+		return true;
+	case vr_der_x:
+		*value = known == vr_x ? -1.0 : 1.0;
+		return true;
+	default:
+		return false;
+	}
+}
+
+// Logs the first pair of unknown and known without a partial derivative
+static bool checkPartialDerivatives(PlantInstance* comp,
+	const fmi3ValueReference unknowns[], size_t nUnknowns,
+	const fmi3ValueReference knowns[], size_t nKnowns,
+	size_t nSeed, size_t expectedSeed,
+	size_t nSensitivity, size_t expectedSensitivity) {
+
+	fmi3Float64 value;
+
+	if (nSeed != expectedSeed || nSensitivity != expectedSensitivity) {
+		LOG(comp, LogStatusError, fmi3Error, "Expected nSeed = %zu and nSensitivity = %zu.", expectedSeed, expectedSensitivity);
+		return false;
+	}
+
+	for (size_t i = 0; i < nUnknowns; i++) {
+		for (size_t j = 0; j < nKnowns; j++) {
+			if (!partialDerivative(unknowns[i], knowns[j], &value)) {
+				LOG(comp, LogStatusError, fmi3Error, "No partial derivative of %d with respect to %d.", unknowns[i], knowns[j]);
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+fmi3Status fmi3GetDirectionalDerivative(fmi3Instance instance,
+	const fmi3ValueReference unknowns[],
+	size_t nUnknowns,
+	const fmi3ValueReference knowns[],
+	size_t nKnowns,
+	const fmi3Float64 seed[],
+	size_t nSeed,
+	fmi3Float64 sensitivity[],
+	size_t nSensitivity) {
+
+	PlantInstance* comp = (PlantInstance*)instance;
+
+	if (!checkPartialDerivatives(comp, unknowns, nUnknowns, knowns, nKnowns, nSeed, nKnowns, nSensitivity, nUnknowns)) return fmi3Error;
+
+	// sensitivity = J * seed
+	for (size_t i = 0; i < nUnknowns; i++) {
+		sensitivity[i] = 0.0;
+		for (size_t j = 0; j < nKnowns; j++) {
+			fmi3Float64 value;
+			partialDerivative(unknowns[i], knowns[j], &value);
+			sensitivity[i] += value * seed[j];
+		}
+	}
+
+	return fmi3OK;
+}
+
+fmi3Status fmi3GetAdjointDerivative(fmi3Instance instance,
+	const fmi3ValueReference unknowns[],
+	size_t nUnknowns,
+	const fmi3ValueReference knowns[],
+	size_t nKnowns,
+	const fmi3Float64 seed[],
+	size_t nSeed,
+	fmi3Float64 sensitivity[],
+	size_t nSensitivity) {
+
+	PlantInstance* comp = (PlantInstance*)instance;
+
+	if (!checkPartialDerivatives(comp, unknowns, nUnknowns, knowns, nKnowns, nSeed, nUnknowns, nSensitivity, nKnowns)) return fmi3Error;
+
+	// sensitivity = seed^T * J
+	for (size_t j = 0; j < nKnowns; j++) {
+		sensitivity[j] = 0.0;
+		for (size_t i = 0; i < nUnknowns; i++) {
+			fmi3Float64 value;
+			partialDerivative(unknowns[i], knowns[j], &value);
+			sensitivity[j] += seed[i] * value;
+		}
+	}
+
+	return fmi3OK;
+}
+
+fmi3Status fmi3GetOutputDerivatives(fmi3Instance instance,
+	const fmi3ValueReference valueReferences[],
+	size_t nValueReferences,
+	const fmi3Int32 orders[],
+	fmi3Float64 values[],
+	size_t nValues) {
+
+	PlantInstance* comp = (PlantInstance*)instance;
+
+	fmi3Status status = fmi3OK;
+
+	if (nValueReferences != nValues) {
+		LOG(comp, LogStatusError, fmi3Error, "Expected nValues = %zu but was %zu.", nValueReferences, nValues);
+		return fmi3Error;
+	}
+
+	update_derivative(comp);
+
+	for (size_t i = 0; i < nValueReferences; i++) {
+		// Only the first derivative of x is provided
+		if (valueReferences[i] == vr_x && orders[i] == 1) {
+			values[i] = comp->data.der_x;
+		} else {
+			LOG(comp, LogStatusError, fmi3Error, "Output derivative of order %d not available for value reference %d.", orders[i], valueReferences[i]);
+			status = fmi3Error;
+		}
+	}
+
+	return status;
+}
+
+/* Internal solver of fmi3DoStep. The input is held constant over the communication step. */
+static fmi3Float64 rk4Step(fmi3Float64 x, fmi3Float64 u, fmi3Float64 h) {
+
+	const fmi3Float64 k1 = derivative(x, u);
+	const fmi3Float64 k2 = derivative(x + 0.5 * h * k1, u);
+	const fmi3Float64 k3 = derivative(x + 0.5 * h * k2, u);
+	const fmi3Float64 k4 = derivative(x + h * k3, u);
+
+	return x + h / 6.0 * (k1 + 2.0 * k2 + 2.0 * k3 + k4);
+}
+
+// Equidistant RK4 steps of at most maxStepSize
+static fmi3Float64 integrateFixed(fmi3Float64 x, fmi3Float64 u, fmi3Float64 stepSize, fmi3Float64 maxStepSize) {
+
+	const int nSteps = max(1, (int)ceil(stepSize / maxStepSize));
+
+	const fmi3Float64 h = stepSize / nSteps;
+
+	for (int i = 0; i < nSteps; i++) {
+		x = rk4Step(x, u, h);
+	}
+
+	return x;
+}
+
+// RK4 with step doubling: the difference of one full and two half steps estimates the error of the half steps
+static fmi3Float64 integrateAdaptive(fmi3Float64 x, fmi3Float64 u, fmi3Float64 stepSize, fmi3Float64 maxStepSize, fmi3Float64 tolerance) {
+
+	const fmi3Float64 hMax = maxStepSize > 0.0 ? maxStepSize : stepSize;
+	const fmi3Float64 hMin = MIN_STEP_SIZE_RATIO * stepSize;
+
+	fmi3Float64 remaining = stepSize;
+	fmi3Float64 h = hMax;
+
+	while (remaining > 0.0) {
+
+		const bool last = h >= remaining;
+
+		if (last) {
+			h = remaining;
+		}
+
+		const fmi3Float64 full = rk4Step(x, u, h);
+		const fmi3Float64 half = rk4Step(rk4Step(x, u, 0.5 * h), u, 0.5 * h);
+
+		// the local error of RK4 is O(h^5), so two half steps are 2^4 - 1 times more accurate than the difference
+		const fmi3Float64 error = fabs(half - full) / 15.0;
+		const fmi3Float64 scale = tolerance * max(1.0, fabs(half));
+
+		if (error <= scale || h <= hMin) {
+			// accept with the Richardson extrapolation of the two estimates
+			x = half + (half - full) / 15.0;
+			remaining = last ? 0.0 : remaining - h;
+		}
+
+		fmi3Float64 factor = MAX_STEP_SIZE_FACTOR;
+
+		if (error > 0.0) {
+			factor = 0.9 * pow(scale / error, 0.2);
+			factor = factor < MIN_STEP_SIZE_FACTOR ? MIN_STEP_SIZE_FACTOR : factor > MAX_STEP_SIZE_FACTOR ? MAX_STEP_SIZE_FACTOR : factor;
+		}
+
+		h = h * factor;
+		h = h > hMax ? hMax : h < hMin ? hMin : h;
+	}
+
+	return x;
+}
+
 fmi3Status fmi3DoStep(fmi3Instance instance,
 	fmi3Float64 currentCommunicationPoint,
 	fmi3Float64 communicationStepSize,
@@ -428,9 +650,15 @@ fmi3Status fmi3DoStep(fmi3Instance instance,
 
 	fmi3Status status = fmi3OK;
 
-	update_derivative(comp);
-
-	comp->data.x = comp->data.x + communicationStepSize * comp->data.der_x;
+	if (comp->data.tolerance > 0.0) {
+		comp->data.x = integrateAdaptive(comp->data.x, comp->data.u_r, communicationStepSize, comp->data.maxStepSize, comp->data.tolerance);
+	} else if (comp->data.maxStepSize > 0.0) {
+		comp->data.x = integrateFixed(comp->data.x, comp->data.u_r, communicationStepSize, comp->data.maxStepSize);
+	} else {
+		// one explicit Euler step over the communication step
+		update_derivative(comp);
+		comp->data.x = comp->data.x + communicationStepSize * comp->data.der_x;
+	}
 
 	*eventHandlingNeeded = fmi3False;
 	*terminateSimulation = fmi3False;
@@ -449,6 +677,130 @@ fmi3Status fmi3Terminate(fmi3Instance instance) {
 	return fmi3OK;
 }
 
+/* Getting and setting the internal FMU state */
+static fmi3Status invalidFMUState(PlantInstance* comp, const char* function) {
+
+	LOG(comp, LogStatusError, fmi3Error, "%s: invalid FMU state.", function);
+
+	return fmi3Error;
+}
+
+static PlantState* findFMUState(PlantInstance* comp, fmi3FMUState FMUState) {
+
+	for (size_t i = 0; i < N_FMU_STATES; i++) {
+		if (FMUState == &comp->fmuStates[i] && comp->fmuStates[i].used) {
+			return &comp->fmuStates[i];
+		}
+	}
+
+	return NULL;
+}
+
+static PlantState* allocateFMUState(PlantInstance* comp) {
+
+	for (size_t i = 0; i < N_FMU_STATES; i++) {
+		if (!comp->fmuStates[i].used) {
+			comp->fmuStates[i].used = true;
+			return &comp->fmuStates[i];
+		}
+	}
+
+	LOG(comp, LogStatusError, fmi3Error, "All %d FMU states are in use.", N_FMU_STATES);
+
+	return NULL;
+}
+
+fmi3Status fmi3GetFMUState(fmi3Instance instance, fmi3FMUState* FMUState) {
+
+	PlantInstance* comp = (PlantInstance*)instance;
+
+	// An existing state is overwritten
+	PlantState* state = *FMUState ? findFMUState(comp, *FMUState) : allocateFMUState(comp);
+
+	if (!state) return *FMUState ? invalidFMUState(comp, "fmi3GetFMUState") : fmi3Error;
+
+	state->data = comp->data;
+
+	*FMUState = (fmi3FMUState)state;
+
+	return fmi3OK;
+}
+
+fmi3Status fmi3SetFMUState(fmi3Instance instance, fmi3FMUState FMUState) {
+
+	PlantInstance* comp = (PlantInstance*)instance;
+
+	const PlantState* state = findFMUState(comp, FMUState);
+
+	if (!state) return invalidFMUState(comp, "fmi3SetFMUState");
+
+	comp->data = state->data;
+
+	return fmi3OK;
+}
+
+fmi3Status fmi3FreeFMUState(fmi3Instance instance, fmi3FMUState* FMUState) {
+
+	PlantInstance* comp = (PlantInstance*)instance;
+
+	if (!FMUState || !*FMUState) return fmi3OK;
+
+	PlantState* state = findFMUState(comp, *FMUState);
+
+	if (!state) return invalidFMUState(comp, "fmi3FreeFMUState");
+
+	state->used = false;
+
+	*FMUState = NULL;
+
+	return fmi3OK;
+}
+
+fmi3Status fmi3SerializedFMUStateSize(fmi3Instance instance,
+	fmi3FMUState FMUState,
+	size_t* size) {
+
+	*size = sizeof(PlantData);
+
+	return fmi3OK;
+}
+
+fmi3Status fmi3SerializeFMUState(fmi3Instance instance,
+	fmi3FMUState FMUState,
+	fmi3Byte serializedState[],
+	size_t size) {
+
+	PlantInstance* comp = (PlantInstance*)instance;
+
+	const PlantState* state = findFMUState(comp, FMUState);
+
+	if (!state || size != sizeof(PlantData)) return invalidFMUState(comp, "fmi3SerializeFMUState");
+
+	memcpy(serializedState, &state->data, sizeof(PlantData));
+
+	return fmi3OK;
+}
+
+fmi3Status fmi3DeserializeFMUState(fmi3Instance instance,
+	const fmi3Byte serializedState[],
+	size_t size,
+	fmi3FMUState* FMUState) {
+
+	PlantInstance* comp = (PlantInstance*)instance;
+
+	if (size != sizeof(PlantData)) return invalidFMUState(comp, "fmi3DeserializeFMUState");
+
+	PlantState* state = *FMUState ? findFMUState(comp, *FMUState) : allocateFMUState(comp);
+
+	if (!state) return *FMUState ? invalidFMUState(comp, "fmi3DeserializeFMUState") : fmi3Error;
+
+	memcpy(&state->data, serializedState, sizeof(PlantData));
+
+	*FMUState = (fmi3FMUState)state;
+
+	return fmi3OK;
+}
+
 void fmi3FreeInstance(fmi3Instance instance) {
 	free(instance);
 }
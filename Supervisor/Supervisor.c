@@ -1,8 +1,18 @@
+#include <string.h>
+
 #include "fmi3Functions.h"
 #include "Custom.h"
+#include "model_variables.h"
+#include "SupervisorVariables.h"
 
 #define MAX_MSG_SIZE 100
 
+// Internal step size at which x is sampled if the supervisor may return early
+#define FIXED_INTERNAL_STEP_SIZE 1e-3
+
+// Width of the bracket around the interpolated zero crossing
+#define EVENT_TOLERANCE 1e-10
+
 typedef enum {
 	Instantiated = 1,
 	EventMode,
@@ -10,14 +20,9 @@ typedef enum {
 	Terminated
 } ModelState;
 
-typedef enum {
-	vr_s = 1,       // Clock s
-	vr_x = 2,           // Sample from Plant
-	vr_as = 3,          // Output that is fed to the Controller
-	vr_as_previous = 4  // Previous value for as
-} ValueReference;
-
+// The fields are named after the variables in the modelDescription.xml
 typedef struct {
+	double time; // Simulation time
 	bool s;    // Clock
 	double x;  // Sample
 	double as; // Output and ClockedState that is fed to the Controller
@@ -26,17 +31,36 @@ typedef struct {
 	double pz; // Previous Event Indicator
 } SupervisorData;
 
+#define MODEL_DATA SupervisorData
+
+static const VariableInfo variables[N_VALUE_REFERENCES] = { MODEL_VARIABLES(VARIABLE_INFO) };
+
+// Number of FMU states that can be stored at the same time
+#define N_FMU_STATES 8
+
+typedef struct {
+	bool used;
+	SupervisorData data;
+} SupervisorState;
+
 typedef struct {
 
 	const char* instanceName;
 
 	// callback functions
 	fmi3LogMessageCallback logMessage;
+	bool logCategories[N_LOG_CATEGORIES];  // enabled categories of LOG()
+	fmi3IntermediateUpdateCallback intermediateUpdate;
+
+	fmi3Boolean earlyReturnAllowed;
 
 	void* componentEnvironment;
 
 	SupervisorData data;
 
+	// preallocated FMU states, so fmi3GetFMUState does not allocate
+	SupervisorState fmuStates[N_FMU_STATES];
+
 	ModelState state;
 } SupervisorInstance;
 
@@ -55,6 +79,7 @@ fmi3Instance fmi3InstantiateModelExchange(
 
 	comp->instanceName = instanceName;
 	comp->logMessage = logMessage;
+	initLogCategories(comp->logCategories, logMessage, loggingOn);
 	comp->componentEnvironment = instanceEnvironment;
 
 	fmi3Reset((fmi3Instance)comp);
@@ -82,19 +107,78 @@ fmi3Instance fmi3InstantiateCoSimulation(
 
 	comp->instanceName = instanceName;
 	comp->logMessage = logMessage;
+	initLogCategories(comp->logCategories, logMessage, loggingOn);
 	comp->componentEnvironment = instanceEnvironment;
+	comp->earlyReturnAllowed = earlyReturnAllowed;
+	comp->intermediateUpdate = intermediateUpdate;
 
 	fmi3Reset((fmi3Instance)comp);
 
 	return (fmi3Instance)comp;
 }
 
+fmi3Instance fmi3InstantiateScheduledExecution(
+    fmi3String                     instanceName,
+    fmi3String                     instantiationToken,
+    fmi3String                     resourcePath,
+    fmi3Boolean                    visible,
+    fmi3Boolean                    loggingOn,
+    fmi3InstanceEnvironment        instanceEnvironment,
+    fmi3LogMessageCallback         logMessage,
+    fmi3ClockUpdateCallback        clockUpdate,
+    fmi3LockPreemptionCallback     lockPreemption,
+    fmi3UnlockPreemptionCallback   unlockPreemption) {
+
+	if (logMessage) {
+		logMessage(instanceEnvironment, fmi3Error, "logStatusError", "Scheduled Execution is not supported by this fmu.");
+	}
+
+	return NULL;
+}
+
+fmi3Status fmi3SetDebugLogging(fmi3Instance instance,
+    fmi3Boolean loggingOn,
+    size_t nCategories,
+    const fmi3String categories[]) {
+
+	SupervisorInstance* comp = (SupervisorInstance*)instance;
+
+	const size_t i = setLogCategories(comp->logCategories, comp->logMessage, loggingOn, nCategories, categories);
+
+	if (i < nCategories) {
+		LOG(comp, LogStatusError, fmi3Error, "Unknown log category: %s.", categories[i]);
+		return fmi3Error;
+	}
+
+	return fmi3OK;
+}
+
+// Logs the first value reference that cannot be accessed
+static bool checkValueReferences(SupervisorInstance* comp, VariableType type, bool set,
+	const fmi3ValueReference valueReferences[], size_t nValueReferences, size_t nValues) {
+
+	if (nValues != nValueReferences) {
+		LOG(comp, LogStatusError, fmi3Error, "Expected nValues = %zu but was %zu.", nValueReferences, nValues);
+		return false;
+	}
+
+	const size_t i = findInvalidValueReference(variables, N_VALUE_REFERENCES, type, set, valueReferences, nValueReferences);
+
+	if (i < nValueReferences) {
+		LOG(comp, LogStatusError, fmi3Error, "Unexpected value reference: %d.", valueReferences[i]);
+		return false;
+	}
+
+	return true;
+}
+
 fmi3Status fmi3Reset(fmi3Instance instance) {
 	fmi3Status status = fmi3OK;
 	SupervisorInstance* comp = (SupervisorInstance*)instance;
 	
 	comp->state = Instantiated;
 
+	comp->data.time = 0.0;
 	comp->data.s = false;       // Clock
 	comp->data.x = 0.0;         // Sample
 	comp->data.as = 1.0;        // Discrete state/output
@@ -168,8 +252,6 @@ fmi3Status fmi3GetContinuousStateDerivatives(fmi3Instance instance,
     fmi3Float64 derivatives[],
     size_t nContinuousStates) {
 
-    char msg_buff[MAX_MSG_SIZE];
-
 	SupervisorInstance* comp = (SupervisorInstance*)instance;
 
 	fmi3Status status = fmi3OK;
@@ -177,8 +259,7 @@ fmi3Status fmi3GetContinuousStateDerivatives(fmi3Instance instance,
 	if (nContinuousStates == 0) return status;
 
 	if (nContinuousStates != 0) {
-		snprintf(msg_buff, MAX_MSG_SIZE, "Unexpected nContinuousStates: %zd.", nContinuousStates);
-		comp->logMessage(comp->componentEnvironment, status, "Error", msg_buff);
+		LOG(comp, LogStatusError, status, "Unexpected nContinuousStates: %zd.", nContinuousStates);
 		status = fmi3Error;
 	}
 
@@ -191,14 +272,11 @@ fmi3Status fmi3GetIntervalDecimal(fmi3Instance instance,
     fmi3Float64 intervals[],
     fmi3IntervalQualifier qualifiers[]) {
 
-	char msg_buff[MAX_MSG_SIZE];
-
 	fmi3Status status = fmi3Error;
 
 	SupervisorInstance* comp = (SupervisorInstance*)instance;
 
-	snprintf(msg_buff, MAX_MSG_SIZE, "Function not relevant for this fmu.");
-	comp->logMessage(comp->componentEnvironment, status, "Error", msg_buff);
+	LOG(comp, LogStatusError, status, "Function not relevant for this fmu.");
 
 	return status;
 }
@@ -210,14 +288,11 @@ fmi3Status fmi3GetIntervalFraction(fmi3Instance instance,
     fmi3UInt64 resolutions[],
     fmi3IntervalQualifier qualifiers[]) {
 
-	char msg_buff[MAX_MSG_SIZE];
-
 	fmi3Status status = fmi3Error;
 
 	SupervisorInstance* comp = (SupervisorInstance*)instance;
 
-	snprintf(msg_buff, MAX_MSG_SIZE, "Function not relevant for this fmu.");
-	comp->logMessage(comp->componentEnvironment, status, "Error", msg_buff);
+	LOG(comp, LogStatusError, status, "Function not relevant for this fmu.");
 
 	return status;
 }
@@ -226,14 +301,11 @@ fmi3Status fmi3GetShiftDecimal(fmi3Instance instance,
     const fmi3ValueReference valueReferences[],
     size_t nValueReferences,
     fmi3Float64 shifts[]) {
-    char msg_buff[MAX_MSG_SIZE];
-
 	fmi3Status status = fmi3Error;
 
 	SupervisorInstance* comp = (SupervisorInstance*)instance;
 
-	snprintf(msg_buff, MAX_MSG_SIZE, "Function not relevant for this fmu.");
-	comp->logMessage(comp->componentEnvironment, status, "Error", msg_buff);
+	LOG(comp, LogStatusError, status, "Function not relevant for this fmu.");
 
 	return status;
 }
@@ -243,14 +315,11 @@ fmi3Status fmi3GetShiftFraction(fmi3Instance instance,
     size_t nValueReferences,
     fmi3UInt64 counters[],
     fmi3UInt64 resolutions[]) {
-    char msg_buff[MAX_MSG_SIZE];
-
 	fmi3Status status = fmi3Error;
 
 	SupervisorInstance* comp = (SupervisorInstance*)instance;
 
-	snprintf(msg_buff, MAX_MSG_SIZE, "Function not relevant for this fmu.");
-	comp->logMessage(comp->componentEnvironment, status, "Error", msg_buff);
+	LOG(comp, LogStatusError, status, "Function not relevant for this fmu.");
 
 	return status;
 }
@@ -261,55 +330,29 @@ fmi3Status fmi3GetFloat64(fmi3Instance instance,
 	fmi3Float64 values[],
 	size_t nValues) {
 
-	char msg_buff[MAX_MSG_SIZE];
-
 	SupervisorInstance* comp = (SupervisorInstance*)instance;
 
 	fmi3Status status = fmi3OK;
 
-	if (nValueReferences == 0) return status;
+	if (!checkValueReferences(comp, VariableFloat64, false, valueReferences, nValueReferences, nValues)) return fmi3Error;
 
-	fmi3Status s;
+	getFloat64Variables(variables, &comp->data, valueReferences, nValueReferences, values);
 
-	size_t i;
-
-	for (i = 0; i < nValueReferences; i++) {
-		fmi3Status s;
-		ValueReference vr = valueReferences[i];
-		switch (vr) {
-		case vr_as:
-			if (comp->state == EventMode && comp->data.s) {
-				// We need this here because when clock s is ticking, we need to output the next state already
-				//   (because the clocked partition depends on that value),
-				//   without executing the state transition.
-				// Therefore we compute the next state "comp->data.as * -1.0" and output it.
-				// The actual execution of the state transition happens in the eventUpdate function below.
-				// See definition of clocked partition in 2.2.8.3. Model Partitions and Clocked Variables.
-				values[i] = comp->data.as * -1.0;
-				s = fmi3OK;
-			}
-			else {
-				snprintf(msg_buff, MAX_MSG_SIZE, "Value of clock s being observed outside of event mode.");
-				comp->logMessage(comp->componentEnvironment, status, "Warning", msg_buff);
-				s = fmi3Warning;
-				values[i] = comp->data.as;
-			}
-			break;
-		case vr_x:
-			values[i] = comp->data.x;
-			s = fmi3OK;
-			break;
-		case vr_as_previous:
-			values[i] = comp->data.as_previous;
-			s = fmi3OK;
-			break;
-		default:
-			snprintf(msg_buff, MAX_MSG_SIZE, "Unexpected value reference: %d.", vr);
-			comp->logMessage(comp->componentEnvironment, status, "Error", msg_buff);
-			s = fmi3Error;
+	for (size_t i = 0; i < nValueReferences; i++) {
+		if (valueReferences[i] != vr_as) continue;
+		if (comp->state == EventMode && comp->data.s) {
+			// We need this here because when clock s is ticking, we need to output the next state already
+			//   (because the clocked partition depends on that value),
+			//   without executing the state transition.
+			// Therefore we compute the next state "comp->data.as * -1.0" and output it.
+			// The actual execution of the state transition happens in the eventUpdate function below.
+			// See definition of clocked partition in 2.2.8.3. Model Partitions and Clocked Variables.
+			values[i] = comp->data.as * -1.0;
+		}
+		else {
+			LOG(comp, LogStatusError, status, "Value of clock s being observed outside of event mode.");
+			status = fmi3Warning;
 		}
-		status = max(status, s);
-		if (status > fmi3Warning) return status;
 	}
 
 	return status;
@@ -319,8 +362,6 @@ fmi3Status fmi3GetContinuousStates(fmi3Instance instance,
     fmi3Float64 continuousStates[],
     size_t nContinuousStates) {
 	
-	char msg_buff[MAX_MSG_SIZE];
-
 	SupervisorInstance* comp = (SupervisorInstance*)instance;
 
 	fmi3Status status = fmi3OK;
@@ -328,8 +369,7 @@ fmi3Status fmi3GetContinuousStates(fmi3Instance instance,
 	if (nContinuousStates == 0) return status;
 
 	if (nContinuousStates != 0) {
-		snprintf(msg_buff, MAX_MSG_SIZE, "Unexpected nContinuousStates: %zd.", nContinuousStates);
-		comp->logMessage(comp->componentEnvironment, status, "Error", msg_buff);
+		LOG(comp, LogStatusError, status, "Unexpected nContinuousStates: %zd.", nContinuousStates);
 		status = fmi3Error;
 	}
 
@@ -341,37 +381,18 @@ fmi3Status fmi3GetClock(fmi3Instance instance,
 	size_t nValueReferences,
 	fmi3Clock values[]) {
 
-	char msg_buff[MAX_MSG_SIZE];
-
 	SupervisorInstance* comp = (SupervisorInstance*)instance;
 
-	fmi3Status status = fmi3OK;
-
-	if (nValueReferences == 0) return status;
+	if (!checkValueReferences(comp, VariableClock, false, valueReferences, nValueReferences, nValueReferences)) return fmi3Error;
 
-	size_t i;
-	for (i = 0; i < nValueReferences; i++) {
-		fmi3Status s;
-		ValueReference vr = valueReferences[i];
-		switch (vr) {
-		case vr_s:
-			values[i] = comp->data.s;
-			s = fmi3OK;
-			break;
-		default:
-			snprintf(msg_buff, MAX_MSG_SIZE, "Unexpected value reference: %d.", vr);
-			comp->logMessage(comp->componentEnvironment, status, "Error", msg_buff);
-			s = fmi3Error;
-		}
-		status = max(status, s);
-		if (status > fmi3Warning) return status;
-	}
+	getClockVariables(variables, &comp->data, valueReferences, nValueReferences, values);
 
-	return status;
+	return fmi3OK;
 }
 
 fmi3Status fmi3SetTime(fmi3Instance instance, fmi3Float64 time) {
 	SupervisorInstance* comp = (SupervisorInstance*)instance;
+	comp->data.time = time;
 	return fmi3OK;
 }
 
@@ -379,8 +400,6 @@ fmi3Status fmi3SetContinuousStates(fmi3Instance instance,
     const fmi3Float64 continuousStates[],
     size_t nContinuousStates) {
 	
-    char msg_buff[MAX_MSG_SIZE];
-
 	SupervisorInstance* comp = (SupervisorInstance*)instance;
 
 	fmi3Status status = fmi3OK;
@@ -388,8 +407,7 @@ fmi3Status fmi3SetContinuousStates(fmi3Instance instance,
 	if (nContinuousStates == 0) return status;
 
 	if (nContinuousStates != 0) {
-		snprintf(msg_buff, MAX_MSG_SIZE, "Unexpected nContinuousStates: %zd.", nContinuousStates);
-		comp->logMessage(comp->componentEnvironment, status, "Error", msg_buff);
+		LOG(comp, LogStatusError, status, "Unexpected nContinuousStates: %zd.", nContinuousStates);
 		status = fmi3Error;
 	}
 
@@ -402,38 +420,13 @@ fmi3Status fmi3SetFloat64(fmi3Instance instance,
 	const fmi3Float64 values[],
 	size_t nValues) {
 
-	char msg_buff[MAX_MSG_SIZE];
-
 	SupervisorInstance* comp = (SupervisorInstance*)instance;
 
-	fmi3Status status = fmi3OK;
-
-	if (nValueReferences == 0) return status;
+	if (!checkValueReferences(comp, VariableFloat64, true, valueReferences, nValueReferences, nValues)) return fmi3Error;
 
-	size_t i;
+	setFloat64Variables(variables, &comp->data, valueReferences, nValueReferences, values);
 
-	for (i = 0; i < nValueReferences; i++) {
-		fmi3Status s;
-		ValueReference vr = valueReferences[i];
-		switch (vr) {
-		case vr_x:
-			comp->data.x = values[i];
-			s = fmi3OK;
-			break;
-		default:
-			snprintf(msg_buff, MAX_MSG_SIZE, "Unexpected value reference: %d.", vr);
-			comp->logMessage(comp->componentEnvironment, status, "Error", msg_buff);
-			s = fmi3Error;
-		}
-		status = max(status, s);
-		if (status > fmi3Warning) return status;
-	}
-	if (i != nValues) {
-		snprintf(msg_buff, MAX_MSG_SIZE, "Expected nValues = %zu but was %zu.", i, nValues);
-		comp->logMessage(comp->componentEnvironment, status, "Error", msg_buff);
-		return fmi3Error;
-	}
-	return status;
+	return fmi3OK;
 }
 
 fmi3Status fmi3SetClock(fmi3Instance instance,
@@ -468,8 +461,6 @@ fmi3Status fmi3UpdateDiscreteStates(fmi3Instance instance,
     fmi3Boolean* nextEventTimeDefined,
     fmi3Float64* nextEventTime) {
     
-	char msg_buff[MAX_MSG_SIZE];
-
 	SupervisorInstance* comp = (SupervisorInstance*)instance;
 
 	fmi3Status status = fmi3OK;
@@ -492,6 +483,139 @@ fmi3Status fmi3UpdateDiscreteStates(fmi3Instance instance,
 	return status;
 }
 
+fmi3Status fmi3ActivateModelPartition(fmi3Instance instance,
+	fmi3ValueReference clockReference,
+	fmi3Float64 activationTime) {
+
+	fmi3Status status = fmi3Error;
+
+	SupervisorInstance* comp = (SupervisorInstance*)instance;
+
+	LOG(comp, LogStatusError, status, "Function not relevant for this fmu.");
+
+	return status;
+}
+
+fmi3Status fmi3GetDirectionalDerivative(fmi3Instance instance,
+	const fmi3ValueReference unknowns[],
+	size_t nUnknowns,
+	const fmi3ValueReference knowns[],
+	size_t nKnowns,
+	const fmi3Float64 seed[],
+	size_t nSeed,
+	fmi3Float64 sensitivity[],
+	size_t nSensitivity) {
+
+	fmi3Status status = fmi3Error;
+
+	SupervisorInstance* comp = (SupervisorInstance*)instance;
+
+	LOG(comp, LogStatusError, status, "Function not relevant for this fmu.");
+
+	return status;
+}
+
+fmi3Status fmi3GetAdjointDerivative(fmi3Instance instance,
+	const fmi3ValueReference unknowns[],
+	size_t nUnknowns,
+	const fmi3ValueReference knowns[],
+	size_t nKnowns,
+	const fmi3Float64 seed[],
+	size_t nSeed,
+	fmi3Float64 sensitivity[],
+	size_t nSensitivity) {
+
+	fmi3Status status = fmi3Error;
+
+	SupervisorInstance* comp = (SupervisorInstance*)instance;
+
+	LOG(comp, LogStatusError, status, "Function not relevant for this fmu.");
+
+	return status;
+}
+
+fmi3Status fmi3GetOutputDerivatives(fmi3Instance instance,
+	const fmi3ValueReference valueReferences[],
+	size_t nValueReferences,
+	const fmi3Int32 orders[],
+	fmi3Float64 values[],
+	size_t nValues) {
+
+	fmi3Status status = fmi3Error;
+
+	SupervisorInstance* comp = (SupervisorInstance*)instance;
+
+	LOG(comp, LogStatusError, status, "Function not relevant for this fmu.");
+
+	return status;
+}
+
+/* Samples x at the internal steps through the intermediate updates and returns early after the
+   zero crossing of z, which is interpolated linearly between the last two samples. The step ends
+   at the right end of the bracket, so x is already past the crossing at the returned time. */
+static fmi3Status doStepWithEarlyReturn(SupervisorInstance* comp,
+	fmi3Float64 currentCommunicationPoint,
+	fmi3Float64 communicationStepSize,
+	fmi3Boolean* eventHandlingNeeded,
+	fmi3Boolean* terminateSimulation,
+	fmi3Boolean* earlyReturn,
+	fmi3Float64* lastSuccessfulTime) {
+
+	const fmi3Float64 endTime = currentCommunicationPoint + communicationStepSize;
+
+	fmi3Float64 time = currentCommunicationPoint;
+
+	*eventHandlingNeeded = fmi3False;
+	*terminateSimulation = fmi3False;
+	*earlyReturn = fmi3False;
+
+	update_event_indicator(comp);
+
+	for (unsigned long k = 1; !isZeroCrossing(comp->data.pz, comp->data.z) && time < endTime; k++) {
+
+		const fmi3Float64 previousTime = time;
+		const fmi3Float64 previousZ = comp->data.z;
+
+		time = currentCommunicationPoint + k * FIXED_INTERNAL_STEP_SIZE;
+
+		// Avoid a tiny last step due to round-off
+		if (time > endTime - 1e-3 * FIXED_INTERNAL_STEP_SIZE) {
+			time = endTime;
+		}
+
+		fmi3Boolean earlyReturnRequested = fmi3False;
+		fmi3Float64 earlyReturnTime = endTime;
+
+		// The importer sets x at the internal step
+		comp->intermediateUpdate(comp->componentEnvironment, time, fmi3True, fmi3False, fmi3True, fmi3True, &earlyReturnRequested, &earlyReturnTime);
+
+		update_event_indicator(comp);
+
+		if (isZeroCrossing(comp->data.pz, comp->data.z)) {
+
+			// z keeps the value after the crossing, so the event is still detected in event mode
+			if (previousZ != comp->data.z) {
+				const fmi3Float64 eventTime = previousTime + (time - previousTime) * previousZ / (previousZ - comp->data.z) + EVENT_TOLERANCE;
+
+				if (eventTime < time) {
+					time = eventTime;
+				}
+			}
+
+			LOG(comp, LogEvents, fmi3OK, "Zero crossing of z at t=%.12g.", time);
+
+		} else if (earlyReturnRequested && time < endTime) {
+			break;
+		}
+	}
+
+	*eventHandlingNeeded = isZeroCrossing(comp->data.pz, comp->data.z);
+	*earlyReturn = time < endTime;
+	*lastSuccessfulTime = time;
+
+	return fmi3OK;
+}
+
 fmi3Status fmi3DoStep(fmi3Instance instance,
 	fmi3Float64 currentCommunicationPoint,
 	fmi3Float64 communicationStepSize,
@@ -501,17 +625,19 @@ fmi3Status fmi3DoStep(fmi3Instance instance,
 	fmi3Boolean* earlyReturn,
 	fmi3Float64* lastSuccessfulTime) {
 	
-	char msg_buff[MAX_MSG_SIZE];
-
 	SupervisorInstance* comp = (SupervisorInstance*)instance;
 
 	fmi3Status status = fmi3OK;
 
+	if (comp->earlyReturnAllowed && comp->intermediateUpdate) {
+		return doStepWithEarlyReturn(comp, currentCommunicationPoint, communicationStepSize,
+			eventHandlingNeeded, terminateSimulation, earlyReturn, lastSuccessfulTime);
+	}
+
 	update_event_indicator(comp);
 
 	// Log vars for event detection
-	snprintf(msg_buff, MAX_MSG_SIZE, "Event indicators:\n\tpz=%f\n\tz=%f", comp->data.pz, comp->data.z);
-	comp->logMessage(comp->componentEnvironment, status, "Debug", msg_buff);
+	LOG(comp, LogEvents, status, "Event indicators:\n\tpz=%f\n\tz=%f", comp->data.pz, comp->data.z);
 
 	bool stateEvent = isZeroCrossing(comp->data.pz, comp->data.z);
 
@@ -539,6 +665,130 @@ fmi3Status fmi3Terminate(fmi3Instance instance) {
 	return fmi3OK;
 }
 
+/* Getting and setting the internal FMU state */
+static fmi3Status invalidFMUState(SupervisorInstance* comp, const char* function) {
+
+	LOG(comp, LogStatusError, fmi3Error, "%s: invalid FMU state.", function);
+
+	return fmi3Error;
+}
+
+static SupervisorState* findFMUState(SupervisorInstance* comp, fmi3FMUState FMUState) {
+
+	for (size_t i = 0; i < N_FMU_STATES; i++) {
+		if (FMUState == &comp->fmuStates[i] && comp->fmuStates[i].used) {
+			return &comp->fmuStates[i];
+		}
+	}
+
+	return NULL;
+}
+
+static SupervisorState* allocateFMUState(SupervisorInstance* comp) {
+
+	for (size_t i = 0; i < N_FMU_STATES; i++) {
+		if (!comp->fmuStates[i].used) {
+			comp->fmuStates[i].used = true;
+			return &comp->fmuStates[i];
+		}
+	}
+
+	LOG(comp, LogStatusError, fmi3Error, "All %d FMU states are in use.", N_FMU_STATES);
+
+	return NULL;
+}
+
+fmi3Status fmi3GetFMUState(fmi3Instance instance, fmi3FMUState* FMUState) {
+
+	SupervisorInstance* comp = (SupervisorInstance*)instance;
+
+	// An existing state is overwritten
+	SupervisorState* state = *FMUState ? findFMUState(comp, *FMUState) : allocateFMUState(comp);
+
+	if (!state) return *FMUState ? invalidFMUState(comp, "fmi3GetFMUState") : fmi3Error;
+
+	state->data = comp->data;
+
+	*FMUState = (fmi3FMUState)state;
+
+	return fmi3OK;
+}
+
+fmi3Status fmi3SetFMUState(fmi3Instance instance, fmi3FMUState FMUState) {
+
+	SupervisorInstance* comp = (SupervisorInstance*)instance;
+
+	const SupervisorState* state = findFMUState(comp, FMUState);
+
+	if (!state) return invalidFMUState(comp, "fmi3SetFMUState");
+
+	comp->data = state->data;
+
+	return fmi3OK;
+}
+
+fmi3Status fmi3FreeFMUState(fmi3Instance instance, fmi3FMUState* FMUState) {
+
+	SupervisorInstance* comp = (SupervisorInstance*)instance;
+
+	if (!FMUState || !*FMUState) return fmi3OK;
+
+	SupervisorState* state = findFMUState(comp, *FMUState);
+
+	if (!state) return invalidFMUState(comp, "fmi3FreeFMUState");
+
+	state->used = false;
+
+	*FMUState = NULL;
+
+	return fmi3OK;
+}
+
+fmi3Status fmi3SerializedFMUStateSize(fmi3Instance instance,
+	fmi3FMUState FMUState,
+	size_t* size) {
+
+	*size = sizeof(SupervisorData);
+
+	return fmi3OK;
+}
+
+fmi3Status fmi3SerializeFMUState(fmi3Instance instance,
+	fmi3FMUState FMUState,
+	fmi3Byte serializedState[],
+	size_t size) {
+
+	SupervisorInstance* comp = (SupervisorInstance*)instance;
+
+	const SupervisorState* state = findFMUState(comp, FMUState);
+
+	if (!state || size != sizeof(SupervisorData)) return invalidFMUState(comp, "fmi3SerializeFMUState");
+
+	memcpy(serializedState, &state->data, sizeof(SupervisorData));
+
+	return fmi3OK;
+}
+
+fmi3Status fmi3DeserializeFMUState(fmi3Instance instance,
+	const fmi3Byte serializedState[],
+	size_t size,
+	fmi3FMUState* FMUState) {
+
+	SupervisorInstance* comp = (SupervisorInstance*)instance;
+
+	if (size != sizeof(SupervisorData)) return invalidFMUState(comp, "fmi3DeserializeFMUState");
+
+	SupervisorState* state = *FMUState ? findFMUState(comp, *FMUState) : allocateFMUState(comp);
+
+	if (!state) return *FMUState ? invalidFMUState(comp, "fmi3DeserializeFMUState") : fmi3Error;
+
+	memcpy(&state->data, serializedState, sizeof(SupervisorData));
+
+	*FMUState = (fmi3FMUState)state;
+
+	return fmi3OK;
+}
+
 void fmi3FreeInstance(fmi3Instance instance) {
 	free(instance);
 }
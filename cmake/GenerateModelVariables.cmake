@@ -0,0 +1,77 @@
+# Generates the value references and the variable list of an FMU from its modelDescription.xml
+#
+#   cmake -DMODEL_NAME=Plant -DMODEL_DESCRIPTION=Plant/modelDescription.xml -DOUTPUT=PlantVariables.h -P GenerateModelVariables.cmake
+#
+# The header defines
+# - the enum ValueReference with vr_<name> for every variable
+# - N_VALUE_REFERENCES, the largest value reference + 1
+# - the X macro MODEL_VARIABLES(X) with X(type, name, valueReference, causality) for every variable
+#
+# Names are turned into C identifiers, e.g. der(x) -> der_x, and must match the fields of the data struct of the FMU.
+
+foreach (VARIABLE MODEL_NAME MODEL_DESCRIPTION OUTPUT)
+  if (NOT ${VARIABLE})
+    message(FATAL_ERROR "${VARIABLE} is not set.")
+  endif ()
+endforeach ()
+
+file(READ ${MODEL_DESCRIPTION} XML)
+
+# Only the variables that the FMUs access through the table
+string(REGEX MATCHALL "<(Float64|Clock)[ \t\r\n][^>]*>" ELEMENTS "${XML}")
+
+set(ENUM "")
+set(LIST "")
+set(N_VALUE_REFERENCES 0)
+
+foreach (ELEMENT ${ELEMENTS})
+
+  string(REGEX MATCH "^<([A-Za-z0-9]+)" _ "${ELEMENT}")
+  set(TYPE ${CMAKE_MATCH_1})
+
+  if (NOT ELEMENT MATCHES "[ \t\r\n]name=\"([^\"]*)\"")
+    message(FATAL_ERROR "${MODEL_DESCRIPTION}: variable without name: ${ELEMENT}")
+  endif ()
+  set(NAME ${CMAKE_MATCH_1})
+
+  if (NOT ELEMENT MATCHES "[ \t\r\n]valueReference=\"([0-9]+)\"")
+    message(FATAL_ERROR "${MODEL_DESCRIPTION}: variable ${NAME} without valueReference")
+  endif ()
+  set(VALUE_REFERENCE ${CMAKE_MATCH_1})
+
+  # causality defaults to local
+  set(CAUSALITY local)
+  if (ELEMENT MATCHES "[ \t\r\n]causality=\"([a-zA-Z]+)\"")
+    set(CAUSALITY ${CMAKE_MATCH_1})
+  endif ()
+
+  string(REGEX REPLACE "[^A-Za-z0-9_]+" "_" IDENTIFIER "${NAME}")
+  string(REGEX REPLACE "_+$" "" IDENTIFIER "${IDENTIFIER}")
+
+  string(APPEND ENUM "\tvr_${IDENTIFIER} = ${VALUE_REFERENCE},\n")
+  string(APPEND LIST "\tX(${TYPE}, ${IDENTIFIER}, ${VALUE_REFERENCE}, ${CAUSALITY}) \\\n")
+
+  if (VALUE_REFERENCE GREATER_EQUAL N_VALUE_REFERENCES)
+    math(EXPR N_VALUE_REFERENCES "${VALUE_REFERENCE} + 1")
+  endif ()
+
+endforeach ()
+
+if (N_VALUE_REFERENCES EQUAL 0)
+  message(FATAL_ERROR "${MODEL_DESCRIPTION} has no Float64 or Clock variables.")
+endif ()
+
+set(CONTENT "/* Generated from ${MODEL_NAME}/modelDescription.xml by GenerateModelVariables.cmake, do not edit. */
+
+#pragma once
+
+typedef enum {
+${ENUM}} ValueReference;
+
+#define N_VALUE_REFERENCES ${N_VALUE_REFERENCES}
+
+#define MODEL_VARIABLES(X) \\
+${LIST}
+")
+
+file(WRITE ${OUTPUT} "${CONTENT}")
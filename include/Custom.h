@@ -1,4 +1,78 @@
+#ifndef CUSTOM_H
+#define CUSTOM_H
+
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+
+#include "fmi3FunctionTypes.h"
 
 #ifndef max
 #define max(a, b) ((a) > (b) ? (a) : (b))
 #endif
+
+/*
+Log categories of the <LogCategories> in the modelDescription.xml.
+
+The instance keeps a flag per category in logCategories[], so a message of a
+disabled category costs a single branch and is never formatted:
+
+	LOG(comp, LogEvents, fmi3OK, "Zero crossing of z at t=%.12g.", time);
+
+The instance needs the fields logMessage, componentEnvironment and logCategories,
+and the file defines MAX_MSG_SIZE.
+*/
+
+typedef enum {
+	LogEvents,
+	LogStatusError,
+	N_LOG_CATEGORIES
+} LogCategory;
+
+static const char* const logCategoryNames[N_LOG_CATEGORIES] = { "logEvents", "logStatusError" };
+
+#define LOG(comp, category, status, ...) do { \
+	if ((comp)->logCategories[category]) { \
+		char msg_buff[MAX_MSG_SIZE]; \
+		snprintf(msg_buff, MAX_MSG_SIZE, __VA_ARGS__); \
+		(comp)->logMessage((comp)->componentEnvironment, (status), logCategoryNames[category], msg_buff); \
+	} \
+} while (0)
+
+// Errors are logged regardless of loggingOn, until they are disabled with fmi3SetDebugLogging()
+static inline void initLogCategories(bool logCategories[], fmi3LogMessageCallback logMessage, fmi3Boolean loggingOn) {
+
+	logCategories[LogEvents]      = logMessage && loggingOn;
+	logCategories[LogStatusError] = logMessage != NULL;
+}
+
+// Sets all categories if nCategories is 0. Returns the index of the first unknown category, or nCategories
+static inline size_t setLogCategories(bool logCategories[], fmi3LogMessageCallback logMessage, fmi3Boolean loggingOn,
+	size_t nCategories, const fmi3String categories[]) {
+
+	if (nCategories == 0) {
+		for (size_t i = 0; i < N_LOG_CATEGORIES; i++) {
+			logCategories[i] = logMessage && loggingOn;
+		}
+		return 0;
+	}
+
+	for (size_t i = 0; i < nCategories; i++) {
+
+		size_t j = 0;
+
+		while (j < N_LOG_CATEGORIES && strcmp(categories[i], logCategoryNames[j])) {
+			j++;
+		}
+
+		if (j == N_LOG_CATEGORIES) {
+			return i;
+		}
+
+		logCategories[j] = logMessage && loggingOn;
+	}
+
+	return nCategories;
+}
+
+#endif /* CUSTOM_H */
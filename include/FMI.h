@@ -22,6 +22,30 @@ extern "C" {
 #define FMI_STATIC
 #endif
 
+/*
+Build-time level of the tracing of the function calls to logFunctionCall:
+
+FMI_TRACE_NONE    the tracing is compiled out
+FMI_TRACE_ERRORS  only calls that do not return FMIOK are traced
+FMI_TRACE_ALL     the successful calls are traced as well, sampled with FMISetTraceInterval()
+*/
+#define FMI_TRACE_NONE   0
+#define FMI_TRACE_ERRORS 1
+#define FMI_TRACE_ALL    2
+
+#ifndef FMI_TRACE_LEVEL
+#define FMI_TRACE_LEVEL FMI_TRACE_ALL
+#endif
+
+/*
+Build-time switch of the binary call trace (see call_trace.h), independent of
+FMI_TRACE_LEVEL: 1 records the calls of the instances with a trace, 0 compiles
+the recording out.
+*/
+#ifndef FMI_CALL_TRACE
+#define FMI_CALL_TRACE 1
+#endif
+
 typedef enum {
     FMIOK,
     FMIWarning,
@@ -100,16 +124,21 @@ typedef struct FMI2Functions_ FMI2Functions;
 
 typedef struct FMI3Functions_ FMI3Functions;
 
+typedef struct FMILibrary_ FMILibrary;
+
 typedef void FMILogFunctionCall(FMIInstance *instance, FMIStatus status, const char *message, ...);
 
 typedef void FMILogMessage(FMIInstance *instance, FMIStatus status, const char *category, const char *message);
 
 struct FMIInstance_ {
 
+    // owned by the library and shared with the other instances of the library
     FMI1Functions *fmi1Functions;
     FMI2Functions *fmi2Functions;
     FMI3Functions *fmi3Functions;
 
+    FMILibrary *library;
+
 #ifdef _WIN32
     HMODULE libraryHandle;
 #else
@@ -121,6 +150,14 @@ struct FMIInstance_ {
     FMILogMessage      *logMessage;
     FMILogFunctionCall *logFunctionCall;
 
+    // every traceInterval-th successful call is traced, none if 0
+    size_t traceInterval;
+    size_t traceCounter;
+
+    // binary trace of the calls, see call_trace.h
+    struct CallTrace_ *callTrace;
+    size_t callTraceIndex;
+
     double time;
 
     char *buf1;
@@ -143,12 +180,56 @@ struct FMIInstance_ {
 
     FMIInterfaceType interfaceType;
 
+    bool eventModeUsed;  // Co-Simulation in FMI 3.0
+
 };
 
+#if FMI_TRACE_LEVEL >= FMI_TRACE_ALL
+static inline bool FMISampleTrace(FMIInstance *instance) {
+
+    if (instance->traceInterval == 0 || ++instance->traceCounter < instance->traceInterval) {
+        return false;
+    }
+
+    instance->traceCounter = 0;
+
+    return true;
+}
+
+#define FMI_TRACE_CALL(instance, status) ((instance)->logFunctionCall && ((status) != FMIOK || FMISampleTrace(instance)))
+#elif FMI_TRACE_LEVEL >= FMI_TRACE_ERRORS
+#define FMI_TRACE_CALL(instance, status) ((instance)->logFunctionCall && (status) != FMIOK)
+#else
+#define FMI_TRACE_CALL(instance, status) false
+#endif
+
 FMI_STATIC FMIInstance *FMICreateInstance(const char *instanceName, const char *libraryPath, FMILogMessage *logMessage, FMILogFunctionCall *logFunctionCall);
 
 FMI_STATIC void FMIFreeInstance(FMIInstance *instance);
 
+/*
+The shared libraries are loaded once per process and path: instances created
+from the same libraryPath share the library handle and the function tables,
+which are loaded by the first instance of an FMI version and are read-only
+afterwards. The library is unloaded when its last instance is freed.
+*/
+
+// Returns the function table of the FMI version that has been loaded for the library of the instance, or NULL
+FMI_STATIC void* FMIGetLibraryFunctions(FMIInstance *instance, FMIVersion fmiVersion);
+
+// Stores a loaded function table in the library of the instance and returns the table to use. If another
+// instance has stored a table in the meantime, that table is returned and functions is freed.
+FMI_STATIC void* FMIShareLibraryFunctions(FMIInstance *instance, FMIVersion fmiVersion, void *functions);
+
+// Number of loaded shared libraries
+FMI_STATIC size_t FMIGetNumberOfLibraries(void);
+
+// Path of the shared library of the instance
+FMI_STATIC const char* FMIGetLibraryPath(FMIInstance *instance);
+
+// Traces every interval-th successful call (1 all calls, 0 only calls that do not return FMIOK), 1 by default
+FMI_STATIC void FMISetTraceInterval(FMIInstance *instance, size_t interval);
+
 FMI_STATIC const char* FMIValueReferencesToString(FMIInstance *instance, const FMIValueReference vr[], size_t nvr);
 
 FMI_STATIC const char* FMIValuesToString(FMIInstance *instance, size_t vValues, const size_t sizes[], const void* values, FMIVariableType variableType);
@@ -7,17 +7,9 @@ extern "C" {
 #include "fmi3FunctionTypes.h"
 #include "FMI.h"
 
+/* The function table is shared by all instances of a shared library, so it must not hold the state of an instance. */
 struct FMI3Functions_ {
 
-    fmi3Boolean eventModeUsed;
-
-    fmi3Boolean discreteStatesNeedUpdate;
-    fmi3Boolean terminateSimulation;
-    fmi3Boolean nominalsOfContinuousStatesChanged;
-    fmi3Boolean valuesOfContinuousStatesChanged;
-    fmi3Boolean nextEventTimeDefined;
-    fmi3Float64 nextEventTime;
-
     /***************************************************
     Common Functions for FMI 3.0
     ****************************************************/
@@ -136,6 +128,84 @@ struct FMI3Functions_ {
 
 };
 
+/* The functions of FMI3Functions as X(a, name) for fmi3<name>, e.g. to bind the functions of statically linked FMUs */
+#define FMI3_FUNCTIONS(X, a) \
+    X(a, GetVersion)                      \
+    X(a, SetDebugLogging)                 \
+    X(a, InstantiateModelExchange)        \
+    X(a, InstantiateCoSimulation)         \
+    X(a, InstantiateScheduledExecution)   \
+    X(a, FreeInstance)                    \
+    X(a, EnterInitializationMode)         \
+    X(a, ExitInitializationMode)          \
+    X(a, EnterEventMode)                  \
+    X(a, Terminate)                       \
+    X(a, Reset)                           \
+    X(a, GetFloat32)                      \
+    X(a, GetFloat64)                      \
+    X(a, GetInt8)                         \
+    X(a, GetUInt8)                        \
+    X(a, GetInt16)                        \
+    X(a, GetUInt16)                       \
+    X(a, GetInt32)                        \
+    X(a, GetUInt32)                       \
+    X(a, GetInt64)                        \
+    X(a, GetUInt64)                       \
+    X(a, GetBoolean)                      \
+    X(a, GetString)                       \
+    X(a, GetBinary)                       \
+    X(a, GetClock)                        \
+    X(a, SetFloat32)                      \
+    X(a, SetFloat64)                      \
+    X(a, SetInt8)                         \
+    X(a, SetUInt8)                        \
+    X(a, SetInt16)                        \
+    X(a, SetUInt16)                       \
+    X(a, SetInt32)                        \
+    X(a, SetUInt32)                       \
+    X(a, SetInt64)                        \
+    X(a, SetUInt64)                       \
+    X(a, SetBoolean)                      \
+    X(a, SetString)                       \
+    X(a, SetBinary)                       \
+    X(a, SetClock)                        \
+    X(a, GetNumberOfVariableDependencies) \
+    X(a, GetVariableDependencies)         \
+    X(a, GetFMUState)                     \
+    X(a, SetFMUState)                     \
+    X(a, FreeFMUState)                    \
+    X(a, SerializedFMUStateSize)          \
+    X(a, SerializeFMUState)               \
+    X(a, DeserializeFMUState)             \
+    X(a, GetDirectionalDerivative)        \
+    X(a, GetAdjointDerivative)            \
+    X(a, EnterConfigurationMode)          \
+    X(a, ExitConfigurationMode)           \
+    X(a, GetIntervalDecimal)              \
+    X(a, GetIntervalFraction)             \
+    X(a, GetShiftDecimal)                 \
+    X(a, GetShiftFraction)                \
+    X(a, SetIntervalDecimal)              \
+    X(a, SetIntervalFraction)             \
+    X(a, SetShiftDecimal)                 \
+    X(a, SetShiftFraction)                \
+    X(a, EvaluateDiscreteStates)          \
+    X(a, UpdateDiscreteStates)            \
+    X(a, EnterContinuousTimeMode)         \
+    X(a, CompletedIntegratorStep)         \
+    X(a, SetTime)                         \
+    X(a, SetContinuousStates)             \
+    X(a, GetContinuousStateDerivatives)   \
+    X(a, GetEventIndicators)              \
+    X(a, GetContinuousStates)             \
+    X(a, GetNominalsOfContinuousStates)   \
+    X(a, GetNumberOfEventIndicators)      \
+    X(a, GetNumberOfContinuousStates)     \
+    X(a, EnterStepMode)                   \
+    X(a, GetOutputDerivatives)            \
+    X(a, DoStep)                          \
+    X(a, ActivateModelPartition)
+
 
 /***************************************************
 Common Functions
@@ -423,6 +493,16 @@ FMI_STATIC FMIStatus FMI3GetAdjointDerivative(FMIInstance *instance,
     fmi3Float64 sensitivity[],
     size_t nSensitivity);
 
+/* Assembles the Jacobian jacobian[i * nKnowns + j] = d unknowns[i] / d knowns[j] column by column
+   with directional derivatives or, if there are fewer unknowns than knowns, row by row with
+   adjoint derivatives. The FMU must provide the kind of derivatives that is used. */
+FMI_STATIC FMIStatus FMI3GetJacobian(FMIInstance *instance,
+    const fmi3ValueReference unknowns[],
+    size_t nUnknowns,
+    const fmi3ValueReference knowns[],
+    size_t nKnowns,
+    fmi3Float64 jacobian[]);
+
 /* Entering and exiting the Configuration or Reconfiguration Mode */
 FMI_STATIC FMIStatus FMI3EnterConfigurationMode(FMIInstance *instance);
 
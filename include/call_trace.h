@@ -0,0 +1,104 @@
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "FMI3.h"
+
+/*
+Binary trace of the FMI 3.0 calls of the instances, written by FMI3.c.
+
+The trace is a memory-mapped file with a CallTraceHeader followed by a ring of
+capacity fixed-size records. Every call appends a record with the function, the
+instance, the returned status and the value references and the raw values of the
+call, i.e. the inputs of setters and the outputs of getters. Scalar arguments,
+e.g. the time of fmi3SetTime(), are stored as fmi3Float64 values. Records that do
+not fit are truncated and flagged by nValueReferences and nValues, which are the
+counts of the call. Once the ring is full the oldest records are overwritten.
+
+The instances of the trace are listed in the header with their library paths and
+instantiation tokens, so call_trace_replay can re-create them and re-drive the
+FMUs with the recorded calls.
+*/
+
+#define CALL_TRACE_MAGIC "FMI3TRC"
+#define CALL_TRACE_VERSION 1
+
+#define CALL_TRACE_MAX_INSTANCES 16
+#define CALL_TRACE_MAX_VALUE_REFERENCES 8
+#define CALL_TRACE_MAX_VALUE_BYTES 72
+
+#define CALL_TRACE_FUNCTION_ID(a, f) CallTraceFMI3 ## f,
+
+// The functions of FMI3Functions, e.g. CallTraceFMI3DoStep
+typedef enum {
+    FMI3_FUNCTIONS(CALL_TRACE_FUNCTION_ID, _)
+    N_CALL_TRACE_FUNCTIONS
+} CallTraceFunction;
+
+typedef struct {
+    char name[64];
+    char libraryPath[256];
+    char instantiationToken[64];
+} CallTraceInstance;
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t recordSize;
+    uint64_t capacity;   // of the ring in records
+    uint64_t nRecords;   // written, the record n is at n % capacity
+    uint32_t nInstances;
+    uint32_t reserved;
+    CallTraceInstance instances[CALL_TRACE_MAX_INSTANCES];
+} CallTraceHeader;
+
+typedef struct {
+    uint64_t sequence;
+    uint16_t function;           // CallTraceFunction
+    uint8_t instance;            // index in CallTraceHeader.instances
+    uint8_t status;              // FMIStatus
+    uint32_t nValueReferences;   // of the call, at most CALL_TRACE_MAX_VALUE_REFERENCES are stored
+    uint32_t nValues;            // of the call, at most CALL_TRACE_MAX_VALUE_BYTES / valueSize are stored
+    uint32_t valueSize;
+    uint32_t valueReferences[CALL_TRACE_MAX_VALUE_REFERENCES];
+    uint8_t values[CALL_TRACE_MAX_VALUE_BYTES];
+} CallTraceRecord;
+
+typedef struct CallTrace_ CallTrace;
+
+// Creates a trace file with a ring of capacity records, an existing file is overwritten
+CallTrace* CallTraceCreate(const char *path, size_t capacity);
+
+// Opens a trace file for reading
+CallTrace* CallTraceOpen(const char *path);
+
+// Unmaps and closes the file. The instances must not be used with the trace anymore.
+void CallTraceFree(CallTrace *trace);
+
+// Adds the instance to the trace, its calls are recorded from now on
+FMIStatus CallTraceAddInstance(CallTrace *trace, FMIInstance *instance);
+
+const CallTraceHeader* CallTraceGetHeader(const CallTrace *trace);
+
+// Returns the record with the sequence number, or NULL if it has been overwritten or not been written
+const CallTraceRecord* CallTraceGetRecord(const CallTrace *trace, uint64_t sequence);
+
+// Name of the function, e.g. "fmi3DoStep"
+const char* CallTraceFunctionName(CallTraceFunction function);
+
+// Records a call of an instance that has been added to a trace
+void CallTraceWrite(FMIInstance *instance, CallTraceFunction function, FMIStatus status,
+    const fmi3ValueReference valueReferences[], size_t nValueReferences,
+    const void *values, size_t valueSize, size_t nValues);
+
+// Stores the instantiation token of an instance that has been added to a trace
+void CallTraceSetInstantiationToken(FMIInstance *instance, fmi3String instantiationToken);
+
+#ifdef __cplusplus
+}  /* end of extern "C" { */
+#endif
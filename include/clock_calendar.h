@@ -0,0 +1,50 @@
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+
+#include "FMI3.h"
+
+/*
+Calendar of the ticks of periodic clocks on an integer time base.
+
+Intervals and shifts are given as fractions counter / resolution, as returned by
+FMI3GetIntervalFraction and FMI3GetShiftFraction. The calendar counts time in
+ticks of 1 / resolution seconds, where resolution is the least common multiple
+of all resolutions added so far, so every clock tick falls on an exact tick of
+the time base. Pending clock ticks are kept in a binary heap, ordered by time
+and then by clock id.
+*/
+
+typedef struct ClockCalendar_ ClockCalendar;
+
+ClockCalendar* ClockCalendarCreate(void);
+
+void ClockCalendarFree(ClockCalendar *calendar);
+
+// Refines the time base so that 1 / resolution seconds is a whole number of ticks. Pending ticks are rescaled.
+FMIStatus ClockCalendarAddResolution(ClockCalendar *calendar, fmi3UInt64 resolution);
+
+// Schedules a periodic clock that ticks at shift + k * interval, k = 0, 1, 2, ...
+FMIStatus ClockCalendarAddPeriodicClock(ClockCalendar *calendar, size_t id,
+    fmi3UInt64 intervalCounter, fmi3UInt64 intervalResolution,
+    fmi3UInt64 shiftCounter, fmi3UInt64 shiftResolution);
+
+// Returns false if no clock is scheduled.
+bool ClockCalendarNextTick(const ClockCalendar *calendar, fmi3UInt64 *ticks);
+
+// Removes all ticks at or before ticks, reschedules the periodic clocks and returns the number of ids written.
+// A clock that is due more than once is reported once.
+size_t ClockCalendarPopDue(ClockCalendar *calendar, fmi3UInt64 ticks, size_t ids[], size_t nIds);
+
+// Ticks per second of the time base
+fmi3UInt64 ClockCalendarResolution(const ClockCalendar *calendar);
+
+fmi3Float64 ClockCalendarToTime(const ClockCalendar *calendar, fmi3UInt64 ticks);
+
+#ifdef __cplusplus
+}  /* end of extern "C" { */
+#endif
@@ -0,0 +1,42 @@
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+
+#include "FMI3.h"
+#include "scheduler.h"
+
+/*
+Compiled exchange of the Float64 values of a set of connections.
+
+When the plan is created, the value references of the outputs are grouped into one
+array per source instance and those of the inputs into one array per target
+instance. An output that feeds several inputs is read once. A flat scatter table
+maps every input to the slot of its output in the gathered values.
+
+An exchange gets the outputs with one FMI3GetFloat64 call per source instance,
+copies them through the scatter table and sets the inputs with one FMI3SetFloat64
+call per target instance, regardless of the number of connections.
+*/
+
+typedef struct ConnectionPlan_ ConnectionPlan;
+
+// Compiles connections between the instances of the scheduler. Returns NULL if a connection is not a Float64 connection.
+ConnectionPlan* ConnectionPlanCreate(const Scheduler *scheduler, const Connection *const connections[], size_t nConnections);
+
+// Compiles the connections that are not clocked, which are exchanged outside of events
+ConnectionPlan* ConnectionPlanCreateContinuous(const Scheduler *scheduler);
+
+void ConnectionPlanFree(ConnectionPlan *plan);
+
+size_t ConnectionPlanGetNumberOfConnections(const ConnectionPlan *plan);
+
+// Propagates the outputs of the connections to their inputs
+FMIStatus ConnectionPlanExchange(ConnectionPlan *plan);
+
+#ifdef __cplusplus
+}  /* end of extern "C" { */
+#endif
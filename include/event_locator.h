@@ -0,0 +1,48 @@
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+
+#include "FMI3.h"
+
+/*
+Locates the first zero crossing of a set of event indicators within a step.
+
+The indicators are evaluated through a callback, so the caller decides how the
+FMUs are brought to an intermediate time, e.g. by interpolating the states of
+the last step. The crossing is refined with the Illinois variant of regula
+falsi until the bracket is narrower than the tolerance. The located event is
+the right end of the final bracket, i.e. the first evaluated time at which
+the indicators have strictly changed their sign.
+*/
+
+typedef FMIStatus EventIndicatorFunction(void *context, fmi3Float64 time, fmi3Float64 eventIndicators[]);
+
+typedef struct {
+    size_t nEvents;
+    size_t nEvaluations;
+} EventLocatorStatistics;
+
+typedef struct EventLocator_ EventLocator;
+
+EventLocator* EventLocatorCreate(size_t nEventIndicators, fmi3Float64 tolerance, size_t maxIterations);
+
+void EventLocatorFree(EventLocator *locator);
+
+// Returns true if any indicator strictly changes its sign between zLeft and zRight.
+bool EventLocatorCrossed(const EventLocator *locator, const fmi3Float64 zLeft[], const fmi3Float64 zRight[]);
+
+// Refines a crossing between tLeft and tRight. Returns the event time and the indicators at that time.
+FMIStatus EventLocatorFind(EventLocator *locator, EventIndicatorFunction *function, void *context,
+    fmi3Float64 tLeft, const fmi3Float64 zLeft[],
+    fmi3Float64 tRight, const fmi3Float64 zRight[],
+    fmi3Float64 *tEvent, fmi3Float64 zEvent[]);
+
+const EventLocatorStatistics* EventLocatorGetStatistics(const EventLocator *locator);
+
+#ifdef __cplusplus
+}  /* end of extern "C" { */
+#endif
@@ -0,0 +1,36 @@
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+
+#include "FMI.h"
+
+/*
+Extraction of FMU archives into a persistent cache directory.
+
+An archive <name>.fmu is extracted once into <cache>/<name>-<hash>, where hash is
+the 64-bit FNV-1a hash of the content of the archive, so a changed FMU never
+reuses the files of an older one. The entries are stored or deflated, their
+CRC-32 is checked, and an archive is extracted into a temporary directory that is
+renamed when complete, so concurrent runs never see a partially extracted FMU.
+
+The canonical path, size, modification time and hash of the archive are kept in
+<cache>/<name>-<path hash>.index, where path hash is the FNV-1a hash of the canonical
+path, so archives of the same name in different directories do not share an index.
+As long as path, size and modification time, at the full precision of the file
+system, match, the archive is neither read nor hashed again, and the extracted
+directory is reused as is. This fast path trusts size and modification time: an
+archive that is replaced by a different one of the same size and modification
+time returns the stale FMU until the index is removed.
+*/
+
+// Extracts the archive into the cache directory unless it has been extracted before,
+// and returns the directory of the extracted FMU in unzipdir
+FMIStatus FMUArchiveExtract(const char *archivePath, const char *cacheDirectory, char *unzipdir, size_t size);
+
+#ifdef __cplusplus
+}  /* end of extern "C" { */
+#endif
@@ -0,0 +1,91 @@
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+
+#include "FMI3.h"
+#include "scheduler.h"
+
+/*
+Master algorithms for stepping the Co-Simulation instances of a scheduler.
+
+A macro step is a sequence of waves. The instances of a wave step from the
+same inputs, in parallel if a worker pool is available, and the outputs of a
+wave are propagated along the connections before the next wave starts, with one
+get and one set call per instance through a ConnectionPlan. Only
+connections that are not clocked are exchanged, the clocked ones are handled
+at events by the scheduler.
+
+- Gauss-Seidel: one instance per wave in the order of the connection graph,
+  so every instance steps with the fresh outputs of its predecessors
+- Jacobi: all instances in one wave, outputs are exchanged after the step
+- Hybrid: the instances of one level of the connection graph form a wave, so
+  independent instances step in parallel and dependent ones get fresh inputs
+
+Cycles in the connection graph are broken at the instance that was added
+first. The inputs of that instance lag behind by one macro step.
+*/
+
+typedef enum {
+    MasterGaussSeidel,
+    MasterJacobi,
+    MasterHybrid
+} MasterAlgorithmType;
+
+typedef struct {
+    size_t nEvents;     // events located by MasterAlgorithmDoStepLocateEvents()
+    size_t nRollbacks;  // steps that have been repeated from a restored FMU state
+    size_t nEarlyReturns;
+} MasterAlgorithmStatistics;
+
+typedef struct MasterAlgorithm_ MasterAlgorithm;
+
+// Creates the waves from the connections of the scheduler. Without threads all instances step on the calling thread.
+MasterAlgorithm* MasterAlgorithmCreate(Scheduler *scheduler, MasterAlgorithmType type, size_t nThreads);
+
+void MasterAlgorithmFree(MasterAlgorithm *master);
+
+// Steps all instances from time to time + hTaken, exchanges the outputs and marks the instances that need event handling in the scheduler.
+// hTaken is less than h only if an instance has returned early.
+FMIStatus MasterAlgorithmDoStep(MasterAlgorithm *master, fmi3Float64 time, fmi3Float64 h, fmi3Float64 *hTaken, bool *eventHandlingNeeded, bool *terminateSimulation);
+
+/*
+Steps like MasterAlgorithmDoStep() but, if an instance reports an event, restores the FMU states
+from before the step and bisects the step size until the first step that reports the event is
+known within tolerance. The instances are left at time + hTaken, where hTaken <= h.
+
+All instances must support fmi3GetFMUState and fmi3SetFMUState. An event can only be located if
+the instance that reports it receives the outputs of the same step, i.e. not with the Jacobi master.
+*/
+FMIStatus MasterAlgorithmDoStepLocateEvents(MasterAlgorithm *master, fmi3Float64 time, fmi3Float64 h, fmi3Float64 tolerance, fmi3Float64 *hTaken, bool *eventHandlingNeeded, bool *terminateSimulation);
+
+/*
+Lets the instance return early from fmi3DoStep. It steps before all other instances, which then
+only step to its lastSuccessfulTime. Its inputs are extrapolated from the outputs and the first
+output derivatives of the connected instances at the start of the step and set in the intermediate
+updates, so the instance must be instantiated with earlyReturnAllowed and MasterAlgorithmIntermediateUpdate().
+*/
+FMIStatus MasterAlgorithmAllowEarlyReturn(MasterAlgorithm *master, FMIInstance *instance);
+
+void MasterAlgorithmIntermediateUpdate(
+    fmi3InstanceEnvironment instanceEnvironment,
+    fmi3Float64  intermediateUpdateTime,
+    fmi3Boolean  intermediateVariableSetRequested,
+    fmi3Boolean  intermediateVariableGetAllowed,
+    fmi3Boolean  intermediateStepFinished,
+    fmi3Boolean  canReturnEarly,
+    fmi3Boolean* earlyReturnRequested,
+    fmi3Float64* earlyReturnTime);
+
+const MasterAlgorithmStatistics* MasterAlgorithmGetStatistics(const MasterAlgorithm *master);
+
+const char* MasterAlgorithmTypeToString(MasterAlgorithmType type);
+
+bool MasterAlgorithmTypeFromString(const char *name, MasterAlgorithmType *type);
+
+#ifdef __cplusplus
+}  /* end of extern "C" { */
+#endif
@@ -0,0 +1,95 @@
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+
+#include "FMI3.h"
+
+/*
+Minimal reader for the parts of an FMI 3.0 modelDescription.xml that the
+orchestrators need: the model variables with their clocks, the dependencies
+of the outputs and continuous state derivatives from the <ModelStructure>,
+and the capability flags of the interfaces.
+
+The file is parsed in a single pass in place, the strings point into the
+buffer of the file. The variables are indexed by name and by value reference
+in hash tables, so masters can resolve their connections at startup in O(1)
+per lookup instead of hard coding the value references.
+*/
+
+typedef enum {
+    ModelVariableFloat64,
+    ModelVariableClock,
+    ModelVariableOther
+} ModelVariableType;
+
+typedef enum {
+    CausalityInput,
+    CausalityOutput,
+    CausalityOther
+} ModelVariableCausality;
+
+typedef struct {
+    const char *name;
+    fmi3ValueReference valueReference;
+    ModelVariableType type;
+    ModelVariableCausality causality;
+    bool continuous;                    // variability="continuous"
+    fmi3UInt32 priority;                // priority of a Clock for Scheduled Execution, lower values first
+    size_t nClocks;
+    fmi3ValueReference *clocks;         // value references of the clocks of a clocked variable
+    bool hasDerivative;
+    fmi3ValueReference derivative;      // value reference of the state of a derivative, if hasDerivative
+    bool hasDependencies;               // false if the dependencies are not declared, i.e. unknown
+    size_t nDependencies;
+    fmi3ValueReference *dependencies;   // dependencies of an <Output> or <ContinuousStateDerivative>
+} ModelVariable;
+
+// <ModelExchange>, <CoSimulation> or <ScheduledExecution>
+typedef struct {
+    bool provided;
+    const char *modelIdentifier;
+    bool providesDirectionalDerivatives;
+    bool providesAdjointDerivatives;
+    bool canGetAndSetFMUState;
+    bool canSerializeFMUState;
+    bool canHandleVariableCommunicationStepSize;  // Co-Simulation
+    bool hasEventMode;                            // Co-Simulation
+} ModelInterface;
+
+typedef struct {
+    const char *modelName;
+    const char *instantiationToken;
+    ModelInterface modelExchange;
+    ModelInterface coSimulation;
+    ModelInterface scheduledExecution;
+    size_t nVariables;
+    ModelVariable *variables;
+    size_t nContinuousStateDerivatives;
+    fmi3ValueReference *continuousStateDerivatives;  // in the order of the continuous states
+
+    // the content of the file, the strings point into it
+    char *buffer;
+
+    // hash tables of the variables by name and by value reference with nBuckets each,
+    // that hold the index of the variable + 1 or 0 for an empty bucket
+    size_t nBuckets;
+    size_t *nameBuckets;
+    size_t *valueReferenceBuckets;
+} ModelDescription;
+
+// Returns NULL if the file cannot be read or is not well-formed.
+ModelDescription* ModelDescriptionRead(const char *filename);
+
+void ModelDescriptionFree(ModelDescription *modelDescription);
+
+const ModelVariable* ModelDescriptionFindVariable(const ModelDescription *modelDescription, const char *name);
+
+const ModelVariable* ModelDescriptionFindValueReference(const ModelDescription *modelDescription, fmi3ValueReference valueReference);
+
+#ifdef __cplusplus
+}  /* end of extern "C" { */
+#endif
@@ -0,0 +1,93 @@
+#ifndef MODEL_VARIABLES_H
+#define MODEL_VARIABLES_H
+
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "fmi3PlatformTypes.h"
+
+/*
+Table driven access to the variables of an FMU.
+
+The build generates <ModelName>Variables.h from the modelDescription.xml with the
+value references and MODEL_VARIABLES(X). The FMU builds the table from the fields
+of its data struct:
+
+	#define MODEL_DATA PlantData
+	static const VariableInfo variables[N_VALUE_REFERENCES] = { MODEL_VARIABLES(VARIABLE_INFO) };
+
+Value references without a variable have the type VariableUndefined.
+*/
+
+typedef enum {
+	VariableUndefined,
+	VariableFloat64,
+	VariableClock
+} VariableType;
+
+typedef struct {
+	VariableType type;
+	bool settable;  // inputs and parameters
+	size_t offset;  // of the field in MODEL_DATA
+} VariableInfo;
+
+#define VARIABLE_TYPE_Float64 VariableFloat64
+#define VARIABLE_TYPE_Clock   VariableClock
+
+#define VARIABLE_SETTABLE_independent false
+#define VARIABLE_SETTABLE_input       true
+#define VARIABLE_SETTABLE_output      false
+#define VARIABLE_SETTABLE_local       false
+#define VARIABLE_SETTABLE_parameter   true
+
+#define VARIABLE_INFO(type, name, valueReference, causality) \
+	[valueReference] = { VARIABLE_TYPE_##type, VARIABLE_SETTABLE_##causality, offsetof(MODEL_DATA, name) },
+
+// Returns the index of the first value reference that is not a variable of the type, or nValueReferences
+static inline size_t findInvalidValueReference(const VariableInfo variables[], size_t nVariables, VariableType type, bool set,
+	const fmi3ValueReference valueReferences[], size_t nValueReferences) {
+
+	for (size_t i = 0; i < nValueReferences; i++) {
+		const fmi3ValueReference vr = valueReferences[i];
+		if (vr >= nVariables || variables[vr].type != type || (set && !variables[vr].settable)) {
+			return i;
+		}
+	}
+
+	return nValueReferences;
+}
+
+// The value references must have been checked with findInvalidValueReference()
+static inline void getFloat64Variables(const VariableInfo variables[], const void* data,
+	const fmi3ValueReference valueReferences[], size_t nValueReferences, fmi3Float64 values[]) {
+
+	for (size_t i = 0; i < nValueReferences; i++) {
+		values[i] = *(const fmi3Float64*)((const char*)data + variables[valueReferences[i]].offset);
+	}
+}
+
+static inline void setFloat64Variables(const VariableInfo variables[], void* data,
+	const fmi3ValueReference valueReferences[], size_t nValueReferences, const fmi3Float64 values[]) {
+
+	for (size_t i = 0; i < nValueReferences; i++) {
+		*(fmi3Float64*)((char*)data + variables[valueReferences[i]].offset) = values[i];
+	}
+}
+
+static inline void getClockVariables(const VariableInfo variables[], const void* data,
+	const fmi3ValueReference valueReferences[], size_t nValueReferences, fmi3Clock values[]) {
+
+	for (size_t i = 0; i < nValueReferences; i++) {
+		values[i] = *(const fmi3Clock*)((const char*)data + variables[valueReferences[i]].offset);
+	}
+}
+
+static inline void setClockVariables(const VariableInfo variables[], void* data,
+	const fmi3ValueReference valueReferences[], size_t nValueReferences, const fmi3Clock values[]) {
+
+	for (size_t i = 0; i < nValueReferences; i++) {
+		*(fmi3Clock*)((char*)data + variables[valueReferences[i]].offset) = values[i];
+	}
+}
+
+#endif /* MODEL_VARIABLES_H */
@@ -0,0 +1,76 @@
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+
+#include "FMI3.h"
+
+/*
+Integrators for the continuous states of a single Model Exchange instance.
+
+The solver owns the state vector and drives the FMU through FMI3SetTime,
+FMI3SetContinuousStates and FMI3GetContinuousStateDerivatives. After every
+call to SolverReset() or SolverStep() the FMU holds the solver's current
+time and states, so outputs can be read directly from the instance.
+
+The implicit methods need the Jacobian of the derivatives with respect to the
+states. If the value references of the states and their derivatives are set,
+it is computed with FMI3GetJacobian(), otherwise with finite differences where
+the columns that do not share a row of the sparsity pattern are perturbed
+together. The Jacobian is kept over the steps and only updated after a reset,
+e.g. at an event, and after a rejected step.
+*/
+
+typedef enum {
+    SolverEuler,          // explicit Euler with a fixed step
+    SolverDormandPrince,  // embedded Runge-Kutta 5(4) with step size control and dense output
+    SolverRosenbrock      // linearly implicit Rosenbrock 2(1) for stiff systems with step size control
+} SolverType;
+
+typedef struct {
+    SolverType  type;
+    fmi3Float64 fixedStep;    // step of fixed-step methods, initial step of adaptive methods
+    fmi3Float64 tolerance;    // relative and absolute tolerance of adaptive methods
+    fmi3Float64 minStep;      // adaptive methods fail if the step drops below this value
+    fmi3Float64 maxStep;      // upper bound for the step of adaptive methods
+    const fmi3ValueReference *stateReferences;       // nx states and their derivatives for directional derivatives,
+    const fmi3ValueReference *derivativeReferences;  // NULL to use finite differences
+    const bool *jacobianPattern;                     // nx * nx row-major non-zeros of the Jacobian, NULL if dense
+} SolverSettings;
+
+typedef struct {
+    size_t nSteps;
+    size_t nRejectedSteps;
+    size_t nDerivativeEvaluations;
+    size_t nJacobianEvaluations;
+    size_t nDecompositions;   // LU decompositions of the iteration matrix
+} SolverStatistics;
+
+typedef struct Solver_ Solver;
+
+// The arrays of the settings are copied.
+Solver* SolverCreate(FMIInstance *instance, size_t nContinuousStates, const SolverSettings *settings);
+
+void SolverFree(Solver *solver);
+
+// Reads the continuous states from the FMU and restarts the integration at time, e.g. after an event.
+FMIStatus SolverReset(Solver *solver, fmi3Float64 time);
+
+// Takes one accepted step that ends at or before tMax. The step ends exactly at tMax if it was limited by it.
+FMIStatus SolverStep(Solver *solver, fmi3Float64 tMax, fmi3Float64 *tReached);
+
+// Evaluates the states at a time within the last accepted step without calling the FMU.
+void SolverInterpolate(const Solver *solver, fmi3Float64 time, fmi3Float64 continuousStates[]);
+
+const SolverStatistics* SolverGetStatistics(const Solver *solver);
+
+const char* SolverTypeToString(SolverType type);
+
+bool SolverTypeFromString(const char *name, SolverType *type);
+
+#ifdef __cplusplus
+}  /* end of extern "C" { */
+#endif
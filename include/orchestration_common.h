@@ -1,27 +1,19 @@
 #pragma once
 
 #include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "scheduler.h"
+#include "call_trace.h"
+#include "fmu_archive.h"
+#include "result_sink.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
 
-// Plantmodel vrefs
-#define Plantmodel_U_ref  3
-#define Plantmodel_X_ref  1
-
-// Controller vrefs
-#define Controller_UR_ref 3
-#define Controller_R_ref  1
-#define Controller_S_ref  6
-#define Controller_AS_ref 5
-
-// Supervisor vrefs
-#define Supervisor_S_ref  1
-#define Supervisor_X_ref  2
-#define Supervisor_AS_ref 3
-
 // instance IDs
 #define PLANTMODEL_ID 0
 #define CONTROLLER_ID 1
@@ -29,32 +21,54 @@ extern "C" {
 
 #define N_INSTANCES 3
 
+// Maximum number of clocks that tick at the same time
+#define N_CLOCKS 1
+
 #define FIXED_STEP 1e-2
+// FIXED_STEP as a fraction, for the integer time base of the clocks
+#define FIXED_STEP_COUNTER 1
+#define FIXED_STEP_RESOLUTION 100
 #define STOP_TIME 10.0
 
-#define MAXDIRLENGTH 250
+#define MAXDIRLENGTH 1024
+
+// Default cache directory of the extracted FMUs of --fmu-dir
+#define FMU_CACHE_DIRECTORY "fmu_cache"
 
 
 // Instance names
 const char* names[N_INSTANCES] = { "plantmodel", "controller", "supervisor" };
 
-// Constants with value references
-const fmi3ValueReference plantmodel_u_refs[]  = { Plantmodel_U_ref  };
-const fmi3ValueReference plantmodel_y_refs[]  = { Plantmodel_X_ref  };
-const fmi3ValueReference controller_y_refs[]  = { Controller_UR_ref };
-const fmi3ValueReference controller_r_refs[]  = { Controller_R_ref  };
-const fmi3ValueReference controller_s_refs[]  = { Controller_S_ref  };
-const fmi3ValueReference controller_as_refs[] = { Controller_AS_ref };
-const fmi3ValueReference supervisor_s_refs[]  = { Supervisor_S_ref  };
-const fmi3ValueReference supervisor_as_refs[] = { Supervisor_AS_ref };
-const fmi3ValueReference supervisor_in_refs[] = { Supervisor_X_ref  };
+// Value references of the exchanged variables, resolved by name with resolveValueReferences()
+fmi3ValueReference plantmodel_u_refs[1];
+fmi3ValueReference plantmodel_y_refs[1];
+fmi3ValueReference plantmodel_max_step_size_refs[1];
+fmi3ValueReference plantmodel_tolerance_refs[1];
+fmi3ValueReference controller_y_refs[1];
+fmi3ValueReference controller_r_refs[1];
+fmi3ValueReference controller_s_refs[1];
+fmi3ValueReference controller_as_refs[1];
+fmi3ValueReference supervisor_s_refs[1];
+fmi3ValueReference supervisor_as_refs[1];
+fmi3ValueReference supervisor_in_refs[1];
 
 // Simulation constants
 const fmi3Float64 tEnd = STOP_TIME;
 const fmi3Float64 tStart = 0;
 
 
-static void logMessage(FMIInstance* instance, FMIStatus status, const char* category, const char* message) {
+// Messages of FMUs that step in parallel must not interleave
+#if defined(_WIN32)
+#define LOCK_OUTPUT()   _lock_file(stdout)
+#define UNLOCK_OUTPUT() _unlock_file(stdout)
+#else
+#define LOCK_OUTPUT()   flockfile(stdout)
+#define UNLOCK_OUTPUT() funlockfile(stdout)
+#endif
+
+static inline void logMessage(FMIInstance* instance, FMIStatus status, const char* category, const char* message) {
+
+    LOCK_OUTPUT();
 
     switch (status) {
     case FMIOK:
@@ -78,14 +92,18 @@ static void logMessage(FMIInstance* instance, FMIStatus status, const char* cate
     }
 
     printf("[%s] %s\n", instance->name, message);
+
+    UNLOCK_OUTPUT();
 }
 
 
-static void logFunction(FMIInstance* instance, FMIStatus status, const char* msg_format, ...) {
+static inline void logFunction(FMIInstance* instance, FMIStatus status, const char* msg_format, ...) {
 
     va_list args;
     va_start(args, msg_format);
 
+    LOCK_OUTPUT();
+
     switch (status) {
     case FMIOK:
         printf("[OK] ");
@@ -113,104 +131,349 @@ static void logFunction(FMIInstance* instance, FMIStatus status, const char* msg
 
     printf("\n");
 
+    UNLOCK_OUTPUT();
+
     va_end(args);
 }
 
-//**************** Output structures */
+//**************** Command line options ******************//
 
-// Define struct to hold outputs of FMI3UpdateDiscreteStates
-typedef struct {
-    fmi3Boolean discreteStatesNeedUpdate;
-    fmi3Boolean terminateSimulation;
-    fmi3Boolean nominalsChanged;
-    fmi3Boolean statesChanged;
-    fmi3Boolean nextEventTimeDefined;
-    fmi3Float64 nextEventTime;
-} FMI3UpdateDiscreteStatesOutput;
+// Returns the value of an option "--name=value" or NULL if it is not present
+static inline const char* getOption(int argc, char* argv[], const char* name) {
+
+    const size_t length = strlen(name);
+
+    for (int i = 1; i < argc; i++) {
+        if (!strncmp(argv[i], "--", 2) && !strncmp(&argv[i][2], name, length) && argv[i][2 + length] == '=') {
+            return &argv[i][3 + length];
+        }
+    }
+
+    return NULL;
+}
 
 //**************** Output aux functions ******************//
 
-#define OUTPUT_FILE_HEADER "time,x,r,u_r,a_s\n"
+// Columns of the result file
+#define N_RESULT_COLUMNS 5
+
+static const char* const resultColumnNames[N_RESULT_COLUMNS] = { "time", "x", "r", "u_r", "a_s" };
+static const ResultColumnType resultColumnTypes[N_RESULT_COLUMNS] = { ResultFloat64, ResultFloat64, ResultInt32, ResultFloat64, ResultFloat64 };
 
 #define CALL(f) do { status = f; if (status > FMIOK) goto TERMINATE; } while (0)
 
-static FMIStatus recordVariables(FILE *outputFile, FMIInstance* controller, FMIInstance* plant, fmi3Float64 time) {
+// Sets the parameters of the internal solver of the plant for fmi3DoStep from the options
+// --plant-max-step=<maximum step size> and --plant-tolerance=<tolerance of the step size control>
+static inline FMIStatus setPlantSolverOptions(FMIInstance* plant, int argc, char* argv[]) {
+
+    FMIStatus status = FMIOK;
+
+    const char* maxStepOption = getOption(argc, argv, "plant-max-step");
+    const char* toleranceOption = getOption(argc, argv, "plant-tolerance");
+
+    if (maxStepOption) {
+        const fmi3Float64 value[] = { atof(maxStepOption) };
+        CALL(FMI3SetFloat64(plant, plantmodel_max_step_size_refs, 1, value, 1));
+    }
+
+    if (toleranceOption) {
+        const fmi3Float64 value[] = { atof(toleranceOption) };
+        CALL(FMI3SetFloat64(plant, plantmodel_tolerance_refs, 1, value, 1));
+    }
+
+TERMINATE:
+    return status;
+}
+
+// Maximum number of categories of the option --log-categories
+#define MAX_LOG_CATEGORIES 8
+
+// Restricts the debug logging of an FMU to the categories of the option --log-categories=<category>,...
+// e.g. --log-categories=logStatusError, and turns it off for --log-categories=
+static inline FMIStatus setLogCategoryOptions(FMIInstance* instance, int argc, char* argv[]) {
+
+    FMIStatus status = FMIOK;
+
+    const char* option = getOption(argc, argv, "log-categories");
+    char buffer[256];
+    fmi3String categories[MAX_LOG_CATEGORIES];
+    size_t nCategories = 0;
+
+    if (!option) {
+        return status;
+    }
+
+    strncpy(buffer, option, sizeof(buffer) - 1);
+    buffer[sizeof(buffer) - 1] = '\0';
+
+    for (char* category = strtok(buffer, ","); category && nCategories < MAX_LOG_CATEGORIES; category = strtok(NULL, ",")) {
+        categories[nCategories++] = category;
+    }
+
+    // all categories off, then the listed ones on
+    CALL(FMI3SetDebugLogging(instance, fmi3False, 0, NULL));
+
+    if (nCategories > 0) {
+        CALL(FMI3SetDebugLogging(instance, fmi3True, nCategories, categories));
+    }
+
+TERMINATE:
+    return status;
+}
+
+// Traces every n-th successful FMI call of an instance with --trace-interval=<n>,
+// only the calls that fail with --trace-interval=0
+static inline void setTraceOptions(FMIInstance* instance, int argc, char* argv[]) {
+
+    const char* option = getOption(argc, argv, "trace-interval");
+
+    if (option) {
+        FMISetTraceInterval(instance, (size_t)strtoul(option, NULL, 10));
+    }
+}
+
+// Default capacity of the ring of --call-trace in records
+#define CALL_TRACE_CAPACITY 65536
+
+// Records the FMI calls of the instances with --call-trace=<file> in a ring of --call-trace-capacity=<n> records,
+// which can be replayed with call_trace_replay <file>
+static inline FMIStatus setCallTraceOption(CallTrace** trace, int argc, char* argv[], FMIInstance* controller, FMIInstance* plant, FMIInstance* supervisor) {
+
+    FMIStatus status = FMIOK;
+
+    const char* option = getOption(argc, argv, "call-trace");
+    const char* capacityOption = getOption(argc, argv, "call-trace-capacity");
+
+    if (!option) {
+        return status;
+    }
+
+#if !FMI_CALL_TRACE
+    printf("The call trace %s cannot be recorded, because it has been compiled out (FMI_CALL_TRACE=OFF).\n", option);
+    return FMIError;
+#endif
+
+    *trace = CallTraceCreate(option, capacityOption ? (size_t)strtoul(capacityOption, NULL, 10) : CALL_TRACE_CAPACITY);
+
+    if (!*trace) {
+        printf("Failed to create the call trace %s.\n", option);
+        return FMIError;
+    }
+
+    CALL(CallTraceAddInstance(*trace, controller));
+    CALL(CallTraceAddInstance(*trace, plant));
+    CALL(CallTraceAddInstance(*trace, supervisor));
+
+TERMINATE:
+    return status;
+}
+
+static inline FMIStatus recordVariables(ResultSink *resultSink, FMIInstance* controller, FMIInstance* plant, fmi3Float64 time) {
 
     FMIStatus status = FMIOK;
 
-    const fmi3ValueReference plantmodel_vref[] = {Plantmodel_X_ref};
     fmi3Float64 plantmodel_vals[] = {0.0};
-    CALL(FMI3GetFloat64(plant, plantmodel_vref, 1, plantmodel_vals, 1));
+    CALL(FMI3GetFloat64(plant, plantmodel_y_refs, 1, plantmodel_vals, 1));
 
-    const fmi3ValueReference controller_vref[] = {Controller_UR_ref , Controller_AS_ref };
+    const fmi3ValueReference controller_vref[] = {controller_y_refs[0], controller_as_refs[0]};
     fmi3Float64 controller_vals[] = {0.0 , 0.0 };
     CALL(FMI3GetFloat64(controller, controller_vref, 2, controller_vals, 2));
 
-    //                                         time,     x,           r,        u_r                a_s
-    fprintf(outputFile, "%g,%g,%d,%g,%g\n", time, plantmodel_vals[0], 0, controller_vals[0], controller_vals[1]);
+    //                                 time, x,                  r, u_r,                a_s
+    ResultSinkSetFloat64(resultSink, 0, time);
+    ResultSinkSetFloat64(resultSink, 1, plantmodel_vals[0]);
+    ResultSinkSetInt32(resultSink,   2, 0);
+    ResultSinkSetFloat64(resultSink, 3, controller_vals[0]);
+    ResultSinkSetFloat64(resultSink, 4, controller_vals[1]);
+
+    CALL(ResultSinkEndRow(resultSink));
 
 TERMINATE:
     return status;
 }
 
-FILE* initializeFile(char* fname) {
-    FILE* outputFile = fopen(fname, "w");
-    if (!outputFile) {
+// Creates the binary result file of --result=<file>, or the default file, which can be converted with result2csv.
+// The rows are written by a writer thread through a ring of --result-buffer=<rows>, 0 writes them on the simulation thread.
+static inline ResultSink* initializeResultSink(int argc, char* argv[], const char* defaultPath) {
+
+    const char* option = getOption(argc, argv, "result");
+    const char* bufferOption = getOption(argc, argv, "result-buffer");
+
+    const size_t ringSize = bufferOption ? (size_t)strtoul(bufferOption, NULL, 10) : RESULT_RING_SIZE;
+
+    ResultSink* resultSink = ResultSinkCreate(option ? option : defaultPath, N_RESULT_COLUMNS, resultColumnNames, resultColumnTypes, RESULT_CHUNK_SIZE, ringSize);
+
+    if (!resultSink) {
         puts("Failed to open output file.");
-        return NULL;
     }
-    fputs(OUTPUT_FILE_HEADER, outputFile);
-    return outputFile;
+
+    return resultSink;
 }
 
 //*******************************************************//
 
 #if defined(_WIN32)
 #define BINARY_DIR "\\binaries\\x86_64-windows\\"
+#define MODEL_DESCRIPTION "\\modelDescription.xml"
 #define BINARY_EXT ".dll"
 #elif defined(__APPLE__)
 #define BINARY_DIR "/binaries/x86_64-darwin/"
+#define MODEL_DESCRIPTION "/modelDescription.xml"
 #define BINARY_EXT ".dylib"
 #else
 #define BINARY_DIR "/binaries/x86_64-linux/"
+#define MODEL_DESCRIPTION "/modelDescription.xml"
 #define BINARY_EXT ".so"
 #endif
 
+// Models of the FMUs
+#define N_MODELS 3
 
-static FMIStatus handleTimeEventController(FMIInstance* controller, FMIInstance* plant) {
+static const char* modelIdentifiers[N_MODELS] = { "Controller", "Plant", "Supervisor" };
 
-    FMIStatus status = FMIOK;
+// Directories of the unpacked FMUs, those of the build tree unless they are extracted with extractFMUs()
+static char fmuDirectories[N_MODELS][MAXDIRLENGTH] = { "Controller", "Plant", "Supervisor" };
 
-    // Activate Controller's clock r
-    fmi3Clock controller_r_vals[] = { fmi3ClockActive };
-    CALL(FMI3SetClock(controller, controller_r_refs, 1, controller_r_vals));
+static inline const char* fmuDirectory(const char* modelIdentifier) {
 
-    // Inputs to the clocked partition are assumed to have been set already, in the continuous time
+    for (size_t i = 0; i < N_MODELS; i++) {
+        if (!strcmp(modelIdentifiers[i], modelIdentifier)) {
+            return fmuDirectories[i];
+        }
+    }
 
-    // Compute outputs to clocked partition: Exchange data Controller -> Plantmodel
-    fmi3Float64 controller_vals[] = { 0.0 };
-    CALL(FMI3GetFloat64(controller, controller_y_refs, 1, controller_vals, 1));
-    CALL(FMI3SetFloat64(plant, plantmodel_u_refs, 1, controller_vals, 1));
+    return modelIdentifier;
+}
 
-TERMINATE:
-    return status;
+// Loads the FMUs from the archives <directory>/<model>.fmu with --fmu-dir=<directory>, e.g. --fmu-dir=../fmus.
+// The archives are extracted once into --fmu-cache=<directory>, FMU_CACHE_DIRECTORY by default, and reused by later runs.
+static inline FMIStatus extractFMUs(int argc, char* argv[]) {
+
+    const char* option = getOption(argc, argv, "fmu-dir");
+    const char* cacheOption = getOption(argc, argv, "fmu-cache");
+
+    if (!option) {
+        return FMIOK;
+    }
+
+    for (size_t i = 0; i < N_MODELS; i++) {
+
+        char archivePath[MAXDIRLENGTH];
+
+        snprintf(archivePath, sizeof(archivePath), "%s/%s.fmu", option, modelIdentifiers[i]);
+
+        if (FMUArchiveExtract(archivePath, cacheOption ? cacheOption : FMU_CACHE_DIRECTORY, fmuDirectories[i], MAXDIRLENGTH) != FMIOK) {
+            printf("Failed to extract %s.\n", archivePath);
+            return FMIError;
+        }
+    }
+
+    return FMIOK;
 }
 
-static FMIStatus handleStateEventSupervisor(FMIInstance* controller, FMIInstance* supervisor) {
+// Loads the shared library of the model from its FMU directory
+static inline FMIInstance* createInstance(const char* instanceName, const char* modelIdentifier) {
+
+    char path[MAXDIRLENGTH];
+
+    snprintf(path, sizeof(path), "%s" BINARY_DIR "%s" BINARY_EXT, fmuDirectory(modelIdentifier), modelIdentifier);
+
+    return FMICreateInstance(instanceName, path, logMessage, logFunction);
+}
+
+static inline const char* modelDescriptionPath(const char* modelIdentifier, char* path, size_t size) {
+
+    snprintf(path, size, "%s" MODEL_DESCRIPTION, fmuDirectory(modelIdentifier));
+
+    return path;
+}
+
+static inline ModelDescription* readModelDescription(const char* modelIdentifier) {
+
+    char path[MAXDIRLENGTH];
+
+    return ModelDescriptionRead(modelDescriptionPath(modelIdentifier, path, sizeof(path)));
+}
+
+
+// Connections between the instances as "<instance name>.<variable name>"
+static const char* connections[][2] = {
+    { "supervisor.s",  "controller.s"  },
+    { "supervisor.as", "controller.as" },
+    { "controller.ur", "plant.u_r"     },
+    { "plant.x",       "supervisor.x"  },
+};
+
+// The variables of the value references, e.g. the input u_r of the Plant
+static const struct {
+    const char* model;
+    const char* name;
+    fmi3ValueReference* valueReference;
+} namedVariables[] = {
+    { "Plant",      "u_r",         plantmodel_u_refs             },
+    { "Plant",      "x",           plantmodel_y_refs             },
+    { "Plant",      "maxStepSize", plantmodel_max_step_size_refs },
+    { "Plant",      "tolerance",   plantmodel_tolerance_refs     },
+    { "Controller", "ur",          controller_y_refs             },
+    { "Controller", "r",           controller_r_refs             },
+    { "Controller", "s",           controller_s_refs             },
+    { "Controller", "as",          controller_as_refs            },
+    { "Supervisor", "s",           supervisor_s_refs             },
+    { "Supervisor", "as",          supervisor_as_refs            },
+    { "Supervisor", "x",           supervisor_in_refs            },
+};
+
+// Looks up the value references of the exchanged variables in the modelDescription.xml of the FMUs
+static inline FMIStatus resolveValueReferences(void) {
+
+    for (size_t i = 0; i < N_MODELS; i++) {
+
+        char path[MAXDIRLENGTH];
+
+        ModelDescription* modelDescription = ModelDescriptionRead(modelDescriptionPath(modelIdentifiers[i], path, sizeof(path)));
+
+        if (!modelDescription) {
+            printf("Failed to read %s.\n", path);
+            return FMIError;
+        }
+
+        for (size_t j = 0; j < sizeof(namedVariables) / sizeof(namedVariables[0]); j++) {
+
+            if (strcmp(namedVariables[j].model, modelIdentifiers[i])) {
+                continue;
+            }
+
+            const ModelVariable* variable = ModelDescriptionFindVariable(modelDescription, namedVariables[j].name);
+
+            if (!variable) {
+                printf("Variable %s is missing in %s.\n", namedVariables[j].name, path);
+                ModelDescriptionFree(modelDescription);
+                return FMIError;
+            }
+
+            *namedVariables[j].valueReference = variable->valueReference;
+        }
+
+        ModelDescriptionFree(modelDescription);
+    }
+
+    return FMIOK;
+}
+
+static inline FMIStatus initializeScheduler(Scheduler* scheduler, FMIInstance* controller, FMIInstance* plant, FMIInstance* supervisor) {
 
     FMIStatus status = FMIOK;
+    char path[MAXDIRLENGTH];
 
-    fmi3Clock supervisor_s_vals[] = { fmi3ClockInactive };
-    fmi3Float64 supervisor_as_vals[] = { 0.0 };
+    CALL(SchedulerAddInstance(scheduler, controller, modelDescriptionPath("Controller", path, sizeof(path))));
+    CALL(SchedulerAddInstance(scheduler, plant,      modelDescriptionPath("Plant",      path, sizeof(path))));
+    CALL(SchedulerAddInstance(scheduler, supervisor, modelDescriptionPath("Supervisor", path, sizeof(path))));
 
-    // Propagate clock activation Supervisor -> Controller
-    CALL(FMI3GetClock(supervisor, supervisor_s_refs, 1, supervisor_s_vals));
-    assert(supervisor_s_vals[0] == fmi3ClockActive);
-    CALL(FMI3SetClock(controller, controller_s_refs, 1, supervisor_s_vals));
+    for (size_t i = 0; i < sizeof(connections) / sizeof(connections[0]); i++) {
+        CALL(SchedulerAddConnection(scheduler, connections[i][0], connections[i][1]));
+    }
 
-    // Exchange data Supervisor -> Controller
-    CALL(FMI3GetFloat64(supervisor, supervisor_as_refs, 1, supervisor_as_vals, 1));
-    CALL(FMI3SetFloat64(controller, controller_as_refs, 1, supervisor_as_vals, 1));
+    CALL(SchedulerInitialize(scheduler));
 
 TERMINATE:
     return status;
@@ -0,0 +1,95 @@
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "FMI3.h"
+
+/*
+Binary column store for the results of the examples.
+
+A result file starts with a ResultFileHeader and one ResultColumn per column with
+its name and type. The rows follow in chunks of at most chunkSize rows: a
+ResultChunkHeader with the number of rows, then the values of every column of
+the chunk, column by column, each block padded to 8 bytes. The values are stored
+in the byte order of the writer at full precision.
+
+The sink collects the rows of a chunk in memory, so recording a row only copies
+its values, and a full chunk is written with one call per column.
+result2csv converts a result file to CSV.
+
+With a ring size larger than 1 the chunks are written by a writer thread. The
+recorded rows are passed through a single-producer/single-consumer ring, which
+is lock-free as long as it neither runs empty nor full: the writer sleeps until
+a chunk or half of the ring is pending, and the producer only waits for the
+writer when the ring is full. The rows must be recorded on one thread.
+*/
+
+#define RESULT_FILE_MAGIC "FMI3RES"
+#define RESULT_FILE_VERSION 1
+
+#define RESULT_MAX_NAME_LENGTH 64
+
+// Default number of rows per chunk
+#define RESULT_CHUNK_SIZE 4096
+
+// Default number of rows in the ring of the writer thread
+#define RESULT_RING_SIZE 16384
+
+typedef enum {
+    ResultFloat64,
+    ResultInt32
+} ResultColumnType;
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t nColumns;
+    uint32_t chunkSize;  // maximum number of rows per chunk
+    uint32_t reserved;
+} ResultFileHeader;
+
+typedef struct {
+    char name[RESULT_MAX_NAME_LENGTH];
+    uint32_t type;  // ResultColumnType
+    uint32_t reserved;
+} ResultColumn;
+
+typedef struct {
+    uint32_t nRows;
+    uint32_t reserved;
+} ResultChunkHeader;
+
+// Size of a value of the type in bytes
+size_t ResultColumnTypeSize(ResultColumnType type);
+
+// Size of the block of nRows values of the type in a chunk, including the padding
+size_t ResultColumnBlockSize(ResultColumnType type, size_t nRows);
+
+typedef struct ResultSink_ ResultSink;
+
+// Creates a result file with the columns, an existing file is overwritten. With a ringSize > 1
+// the rows are written by a writer thread, otherwise on the calling thread.
+ResultSink* ResultSinkCreate(const char *path, size_t nColumns, const char *const names[], const ResultColumnType types[], size_t chunkSize, size_t ringSize);
+
+// Writes the remaining rows, stops the writer thread and closes the file
+void ResultSinkFree(ResultSink *sink);
+
+// Set the values of the current row
+void ResultSinkSetFloat64(ResultSink *sink, size_t column, fmi3Float64 value);
+
+void ResultSinkSetInt32(ResultSink *sink, size_t column, fmi3Int32 value);
+
+// Completes the current row and writes the chunk when it is full. Returns FMIError if a previous write failed.
+FMIStatus ResultSinkEndRow(ResultSink *sink);
+
+// Writes the recorded rows, including those of an incomplete chunk
+FMIStatus ResultSinkFlush(ResultSink *sink);
+
+#ifdef __cplusplus
+}  /* end of extern "C" { */
+#endif
@@ -0,0 +1,100 @@
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+
+#include "FMI3.h"
+#include "model_description.h"
+
+/*
+Event handling for a system of FMUs with synchronous clocks.
+
+Every clock of every instance defines a clocked partition. The scheduler reads
+the clocks, the clocked variables and the output dependencies from the
+modelDescription.xml of each instance and builds a DAG of the partitions from
+the connections between the instances:
+
+- an output clock precedes the input clocks it is connected to
+- a partition precedes the partitions whose clocked inputs it feeds
+- within an instance, a partition precedes the partitions whose clocked outputs depend on its variables
+
+At an event, the scheduler enters event mode only for the instances that the
+active clocks touch, evaluates the active partitions in topological order,
+propagating clocks and clocked variables along the connections, and updates
+the discrete states of the touched instances until none of them requests
+another iteration (super-dense time). Instances are ordered by the same
+dependencies, so upstream instances are always handled first.
+
+The clocked variables of each partition are compiled into a ConnectionPlan by
+SchedulerInitialize(), so they are propagated with one get and one set call per
+instance.
+
+The scheduler keeps the nextEventTime reported by each instance, so that the
+master can stop at the time events the FMUs schedule themselves.
+*/
+
+typedef struct {
+    bool terminateSimulation;              // requested by any instance
+    bool valuesOfContinuousStatesChanged;  // reported by any instance
+    size_t nIterations;                    // calls of FMI3UpdateDiscreteStates per instance
+} SchedulerEventInfo;
+
+typedef struct {
+    size_t fromInstance;
+    const ModelVariable *from;
+    size_t toInstance;
+    const ModelVariable *to;
+} Connection;
+
+typedef struct Scheduler_ Scheduler;
+
+Scheduler* SchedulerCreate(void);
+
+void SchedulerFree(Scheduler *scheduler);
+
+// Adds an instantiated FMU. Connections refer to its variables as "<instance name>.<variable name>".
+FMIStatus SchedulerAddInstance(Scheduler *scheduler, FMIInstance *instance, const char *modelDescriptionPath);
+
+// Connects an output to an input of the same type. Clocks are connected to clocks.
+FMIStatus SchedulerAddConnection(Scheduler *scheduler, const char *from, const char *to);
+
+// Sorts instances and partitions. Fails if the dependencies are cyclic.
+FMIStatus SchedulerInitialize(Scheduler *scheduler);
+
+// Instances are numbered in the order they were added.
+size_t SchedulerGetNumberOfInstances(const Scheduler *scheduler);
+
+FMIInstance* SchedulerGetInstance(const Scheduler *scheduler, size_t instance);
+
+size_t SchedulerGetNumberOfConnections(const Scheduler *scheduler);
+
+const Connection* SchedulerGetConnection(const Scheduler *scheduler, size_t connection);
+
+// Returns true for connections of clocks and clocked variables, which are exchanged at events only.
+bool SchedulerIsClockedConnection(const Connection *connection);
+
+// Returns the id of a clock, e.g. "controller.r", to be used with SchedulerActivateClock().
+bool SchedulerFindClock(const Scheduler *scheduler, const char *name, size_t *clock);
+
+// Marks an input clock as ticking at the next event, e.g. at a time event.
+FMIStatus SchedulerActivateClock(Scheduler *scheduler, size_t clock);
+
+// Marks an instance that signalled a state event. Its output clocks are queried at the next event.
+FMIStatus SchedulerSetStateEvent(Scheduler *scheduler, FMIInstance *instance);
+
+// Returns the earliest nextEventTime of all instances or false if no instance has defined one.
+bool SchedulerNextEventTime(const Scheduler *scheduler, fmi3Float64 *time);
+
+// Marks the instances whose nextEventTime is due at time, like a state event. Returns false if there are none.
+bool SchedulerSetTimeEvents(Scheduler *scheduler, fmi3Float64 time);
+
+// Handles all pending clock activations and events, iterates the discrete states to a fixed point
+// and returns the instances to continuous time or step mode.
+FMIStatus SchedulerHandleEvents(Scheduler *scheduler, SchedulerEventInfo *info);
+
+#ifdef __cplusplus
+}  /* end of extern "C" { */
+#endif
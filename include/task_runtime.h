@@ -0,0 +1,61 @@
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+
+#include "FMI3.h"
+
+/*
+Runtime for the model partitions of FMUs in Scheduled Execution.
+
+The importer queues the partitions of the clocks that tick with
+TaskRuntimeActivate(). A free worker thread takes the queued activation
+with the highest clock priority, i.e. the lowest value, and activations of
+the same priority in the order they were queued. TaskRuntimeWait() returns
+when the queue is empty and all partitions have finished, so it acts as a
+barrier before the outputs of the partitions are read.
+
+A running partition is not interrupted, so a partition of higher priority
+waits for the next free worker. The partitions of one instance never run at
+the same time, because the state the importer keeps for an instance (status,
+trace counter, log buffers) is not thread-safe, so a worker skips the
+activations of busy instances. The preemption lock of the FMUs is a mutex
+of the runtime, so lockPreemption() also keeps the importer out while it
+gets or sets variables of the partitions.
+
+Without threads the activations run on the calling thread in TaskRuntimeWait().
+*/
+
+typedef struct {
+    size_t nActivations;   // finished calls of FMI3ActivateModelPartition()
+    size_t nClockUpdates;  // calls of the clockUpdate callback
+} TaskRuntimeStatistics;
+
+typedef struct TaskRuntime_ TaskRuntime;
+
+// Only one runtime can exist at a time, because the preemption callbacks have no arguments.
+TaskRuntime* TaskRuntimeCreate(size_t nThreads);
+
+void TaskRuntimeFree(TaskRuntime *runtime);
+
+// Queues the activation of the partition of the clock clockReference of a Scheduled Execution instance.
+FMIStatus TaskRuntimeActivate(TaskRuntime *runtime, FMIInstance *instance, fmi3ValueReference clockReference, fmi3UInt32 priority, fmi3Float64 activationTime);
+
+// Waits until all queued partitions have finished and returns their worst status.
+FMIStatus TaskRuntimeWait(TaskRuntime *runtime);
+
+const TaskRuntimeStatistics* TaskRuntimeGetStatistics(const TaskRuntime *runtime);
+
+// Callbacks for FMI3InstantiateScheduledExecution()
+void TaskRuntimeClockUpdate(fmi3InstanceEnvironment instanceEnvironment);
+
+void TaskRuntimeLockPreemption(void);
+
+void TaskRuntimeUnlockPreemption(void);
+
+#ifdef __cplusplus
+}  /* end of extern "C" { */
+#endif
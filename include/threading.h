@@ -0,0 +1,46 @@
+#pragma once
+
+/*
+Portable threads, mutexes and condition variables for the runtimes of the
+examples: Win32 threads on Windows, POSIX threads otherwise.
+
+A thread runs a function declared as
+
+    static ThreadResult THREAD_CALL threadMain(void *argument) { ...; return 0; }
+*/
+
+#ifdef _WIN32
+#include <windows.h>
+typedef HANDLE             Thread;
+typedef CRITICAL_SECTION   Mutex;
+typedef CONDITION_VARIABLE Condition;
+typedef DWORD              ThreadResult;
+#define THREAD_CALL        WINAPI
+#define THREAD_CREATE(t, f, a)  ((*(t) = CreateThread(NULL, 0, f, a, 0, NULL)) != NULL)
+#define THREAD_JOIN(t)     do { WaitForSingleObject(t, INFINITE); CloseHandle(t); } while (0)
+#define MUTEX_INIT(m)      InitializeCriticalSection(m)
+#define MUTEX_DESTROY(m)   DeleteCriticalSection(m)
+#define MUTEX_LOCK(m)      EnterCriticalSection(m)
+#define MUTEX_UNLOCK(m)    LeaveCriticalSection(m)
+#define COND_INIT(c)       InitializeConditionVariable(c)
+#define COND_DESTROY(c)
+#define COND_WAIT(c, m)    SleepConditionVariableCS(c, m, INFINITE)
+#define COND_BROADCAST(c)  WakeAllConditionVariable(c)
+#else
+#include <pthread.h>
+typedef pthread_t          Thread;
+typedef pthread_mutex_t    Mutex;
+typedef pthread_cond_t     Condition;
+typedef void*              ThreadResult;
+#define THREAD_CALL
+#define THREAD_CREATE(t, f, a)  (pthread_create(t, NULL, f, a) == 0)
+#define THREAD_JOIN(t)     pthread_join(t, NULL)
+#define MUTEX_INIT(m)      pthread_mutex_init(m, NULL)
+#define MUTEX_DESTROY(m)   pthread_mutex_destroy(m)
+#define MUTEX_LOCK(m)      pthread_mutex_lock(m)
+#define MUTEX_UNLOCK(m)    pthread_mutex_unlock(m)
+#define COND_INIT(c)       pthread_cond_init(c, NULL)
+#define COND_DESTROY(c)    pthread_cond_destroy(c)
+#define COND_WAIT(c, m)    pthread_cond_wait(c, m)
+#define COND_BROADCAST(c)  pthread_cond_broadcast(c)
+#endif
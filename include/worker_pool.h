@@ -0,0 +1,33 @@
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+
+#include "FMI.h"
+
+/*
+Persistent pool of worker threads for running independent FMU calls in
+parallel, e.g. the DoStep calls of one macro step.
+
+WorkerPoolRun() hands out the tasks to the workers and returns when all of
+them have finished, so it acts as a barrier before the data exchange. The
+threads are created once and wait for work between the calls.
+*/
+
+typedef FMIStatus WorkerTask(void *argument);
+
+typedef struct WorkerPool_ WorkerPool;
+
+WorkerPool* WorkerPoolCreate(size_t nThreads);
+
+void WorkerPoolFree(WorkerPool *pool);
+
+// Runs task(arguments[i]) for all i < nTasks and returns the worst status.
+FMIStatus WorkerPoolRun(WorkerPool *pool, WorkerTask *task, void *arguments[], size_t nTasks);
+
+#ifdef __cplusplus
+}  /* end of extern "C" { */
+#endif
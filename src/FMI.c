@@ -19,10 +19,45 @@
 
 #define INITIAL_MESSAGE_BUFFER_SIZE 1024
 
+#ifdef _WIN32
+static SRWLOCK librariesLock = SRWLOCK_INIT;
+#define LOCK_LIBRARIES()   AcquireSRWLockExclusive(&librariesLock)
+#define UNLOCK_LIBRARIES() ReleaseSRWLockExclusive(&librariesLock)
+#else
+#include <pthread.h>
+static pthread_mutex_t librariesLock = PTHREAD_MUTEX_INITIALIZER;
+#define LOCK_LIBRARIES()   pthread_mutex_lock(&librariesLock)
+#define UNLOCK_LIBRARIES() pthread_mutex_unlock(&librariesLock)
+#endif
 
-FMIInstance *FMICreateInstance(const char *instanceName, const char *libraryPath, FMILogMessage *logMessage, FMILogFunctionCall *logFunctionCall) {
+struct FMILibrary_ {
+
+    char *path;
+
+#ifdef _WIN32
+    HMODULE handle;
+#else
+    void *handle;
+#endif
+
+    size_t refCount;
+
+    FMI1Functions *fmi1Functions;
+    FMI2Functions *fmi2Functions;
+    FMI3Functions *fmi3Functions;
+
+    FMILibrary *next;
+};
+
+// loaded libraries, guarded by librariesLock
+static FMILibrary *libraries = NULL;
 
-# ifdef _WIN32
+static FMILibrary *loadLibrary(const char *libraryPath) {
+
+# if defined(FMI_STATIC_FMUS)
+    // the FMUs are linked into the executable and the path only selects the model
+    void *libraryHandle = NULL;
+# elif defined(_WIN32)
     TCHAR Buffer[1024];
     GetCurrentDirectory(1024, Buffer);
 
@@ -52,21 +87,125 @@ FMIInstance *FMICreateInstance(const char *instanceName, const char *libraryPath
     void *libraryHandle = dlopen(libraryPath, RTLD_LAZY);
 # endif
 
+# if !defined(FMI_STATIC_FMUS)
     if (!libraryHandle) {
         return NULL;
     }
+# endif
+
+    FMILibrary *library = (FMILibrary*)calloc(1, sizeof(FMILibrary));
+
+    if (library) {
+        library->path = strdup(libraryPath);
+    }
+
+    if (!library || !library->path) {
+# if defined(FMI_STATIC_FMUS)
+# elif defined(_WIN32)
+        FreeLibrary(libraryHandle);
+# else
+        dlclose(libraryHandle);
+# endif
+        free(library);
+        return NULL;
+    }
+
+    library->handle = libraryHandle;
+
+    return library;
+}
+
+static void unloadLibrary(FMILibrary *library) {
+
+# if defined(FMI_STATIC_FMUS)
+# elif defined(_WIN32)
+    FreeLibrary(library->handle);
+# else
+    dlclose(library->handle);
+# endif
+
+    free(library->fmi1Functions);
+    free(library->fmi2Functions);
+    free(library->fmi3Functions);
+    free(library->path);
+    free(library);
+}
+
+/* Returns the library with a new reference, loads it if necessary. */
+static FMILibrary *acquireLibrary(const char *libraryPath) {
+
+    LOCK_LIBRARIES();
+
+    FMILibrary *library = libraries;
+
+    while (library && strcmp(library->path, libraryPath)) {
+        library = library->next;
+    }
+
+    if (!library) {
+
+        library = loadLibrary(libraryPath);
+
+        if (library) {
+            library->next = libraries;
+            libraries = library;
+        }
+    }
+
+    if (library) {
+        library->refCount++;
+    }
+
+    UNLOCK_LIBRARIES();
+
+    return library;
+}
+
+static void releaseLibrary(FMILibrary *library) {
+
+    LOCK_LIBRARIES();
+
+    if (--library->refCount > 0) {
+        UNLOCK_LIBRARIES();
+        return;
+    }
+
+    FMILibrary **link = &libraries;
+
+    while (*link != library) {
+        link = &(*link)->next;
+    }
+
+    *link = library->next;
+
+    UNLOCK_LIBRARIES();
+
+    unloadLibrary(library);
+}
+
+FMIInstance *FMICreateInstance(const char *instanceName, const char *libraryPath, FMILogMessage *logMessage, FMILogFunctionCall *logFunctionCall) {
+
+    FMILibrary *library = acquireLibrary(libraryPath);
+
+    if (!library) {
+        return NULL;
+    }
 
     FMIInstance* instance = (FMIInstance*)calloc(1, sizeof(FMIInstance));
 
     if (!instance) {
+        releaseLibrary(library);
         return NULL;
     }
 
-    instance->libraryHandle = libraryHandle;
+    instance->library = library;
+    instance->libraryHandle = library->handle;
 
     instance->logMessage      = logMessage;
     instance->logFunctionCall = logFunctionCall;
 
+    instance->traceInterval = 1;
+
     instance->bufsize1 = INITIAL_MESSAGE_BUFFER_SIZE;
     instance->bufsize2 = INITIAL_MESSAGE_BUFFER_SIZE;
 
@@ -86,13 +225,10 @@ void FMIFreeInstance(FMIInstance *instance) {
         return;
     }
 
-    // unload the shared library
-    if (instance->libraryHandle) {
-# ifdef _WIN32
-        FreeLibrary(instance->libraryHandle);
-# else
-        dlclose(instance->libraryHandle);
-# endif
+    // unload the shared library with its last instance
+    if (instance->library) {
+        releaseLibrary(instance->library);
+        instance->library = NULL;
         instance->libraryHandle = NULL;
     }
 
@@ -100,13 +236,88 @@ void FMIFreeInstance(FMIInstance *instance) {
     free(instance->buf2);
     free((void*)instance->name);
 
-    free(instance->fmi1Functions);
-    free(instance->fmi2Functions);
-    free(instance->fmi3Functions);
-
     free(instance);
 }
 
+void* FMIGetLibraryFunctions(FMIInstance *instance, FMIVersion fmiVersion) {
+
+    void *functions = NULL;
+
+    LOCK_LIBRARIES();
+
+    switch (fmiVersion) {
+        case FMIVersion1:
+            functions = instance->library->fmi1Functions;
+            break;
+        case FMIVersion2:
+            functions = instance->library->fmi2Functions;
+            break;
+        case FMIVersion3:
+            functions = instance->library->fmi3Functions;
+            break;
+    }
+
+    UNLOCK_LIBRARIES();
+
+    return functions;
+}
+
+void* FMIShareLibraryFunctions(FMIInstance *instance, FMIVersion fmiVersion, void *functions) {
+
+    FMILibrary *library = instance->library;
+    void **shared = NULL;
+
+    switch (fmiVersion) {
+        case FMIVersion1:
+            shared = (void**)&library->fmi1Functions;
+            break;
+        case FMIVersion2:
+            shared = (void**)&library->fmi2Functions;
+            break;
+        case FMIVersion3:
+            shared = (void**)&library->fmi3Functions;
+            break;
+    }
+
+    LOCK_LIBRARIES();
+
+    if (*shared) {
+        free(functions);
+    } else {
+        *shared = functions;
+    }
+
+    functions = *shared;
+
+    UNLOCK_LIBRARIES();
+
+    return functions;
+}
+
+const char* FMIGetLibraryPath(FMIInstance *instance) {
+    return instance->library->path;
+}
+
+void FMISetTraceInterval(FMIInstance *instance, size_t interval) {
+    instance->traceInterval = interval;
+    instance->traceCounter = 0;
+}
+
+size_t FMIGetNumberOfLibraries(void) {
+
+    size_t n = 0;
+
+    LOCK_LIBRARIES();
+
+    for (const FMILibrary *library = libraries; library; library = library->next) {
+        n++;
+    }
+
+    UNLOCK_LIBRARIES();
+
+    return n;
+}
+
 const char* FMIValueReferencesToString(FMIInstance *instance, const FMIValueReference vr[], size_t nvr) {
 
     size_t pos = 0;
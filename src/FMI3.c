@@ -13,6 +13,7 @@
 #include <math.h>
 
 #include "FMI3.h"
+#include "call_trace.h"
 
 
 static void cb_logMessage3(fmi3InstanceEnvironment instanceEnvironment,
@@ -54,20 +55,48 @@ do { \
 } while (0)
 #endif
 
+#if FMI_CALL_TRACE
+#define RECORD_CALL(f, status, vr, nvr, v, n) \
+do { \
+    if (instance->callTrace) { \
+        CallTraceWrite(instance, CallTraceFMI3 ## f, status, vr, nvr, v, sizeof(*(v)), n); \
+    } \
+} while (0)
+#define RECORD_INSTANTIATION(f, status, token, v, n) \
+do { \
+    if (instance->callTrace) { \
+        CallTraceSetInstantiationToken(instance, token); \
+        CallTraceWrite(instance, CallTraceFMI3 ## f, status, NULL, 0, v, sizeof(*(v)), n); \
+    } \
+} while (0)
+#else
+#define RECORD_CALL(f, status, vr, nvr, v, n)
+#define RECORD_INSTANTIATION(f, status, token, v, n)
+#endif
+
+// scalar arguments are recorded as fmi3Float64 values
+#define ARGUMENTS(...) ((const fmi3Float64[]){ __VA_ARGS__ })
+#define NO_VALUES ((const fmi3Float64*)NULL)
+
 #define CALL(f) \
 do { \
     FMIStatus status = (FMIStatus)instance->fmi3Functions->fmi3 ## f (instance->component); \
-    if (instance->logFunctionCall) { \
+    RECORD_CALL(f, status, NULL, 0, NO_VALUES, 0); \
+    if (FMI_TRACE_CALL(instance, status)) { \
         instance->logFunctionCall(instance, status, "fmi3" #f "()"); \
     } \
     instance->status = status > instance->status ? status : instance->status; \
     return status; \
 } while (0)
 
-#define CALL_ARGS(f, m, ...) \
+#define CALL_ARGS(f, m, ...) CALL_ARGS_RECORD(f, NULL, 0, NO_VALUES, 0, m, __VA_ARGS__)
+
+// CALL_ARGS() that records the value references vr and the values v of the call
+#define CALL_ARGS_RECORD(f, vr, nvr, v, n, m, ...) \
 do { \
     FMIStatus status = (FMIStatus)instance->fmi3Functions-> fmi3 ## f (instance->component, __VA_ARGS__); \
-    if (instance->logFunctionCall) { \
+    RECORD_CALL(f, status, vr, nvr, v, n); \
+    if (FMI_TRACE_CALL(instance, status)) { \
         instance->logFunctionCall(instance, status, "fmi3" #f "(" m ")", __VA_ARGS__); \
     } \
     instance->status = status > instance->status ? status : instance->status; \
@@ -77,7 +106,8 @@ do { \
 #define CALL_ARRAY(s, t) \
 do { \
     FMIStatus status = (FMIStatus)instance->fmi3Functions->fmi3 ## s ## t(instance->component, valueReferences, nValueReferences, values, nValues); \
-    if (instance->logFunctionCall) { \
+    RECORD_CALL(s ## t, status, valueReferences, nValueReferences, values, nValues); \
+    if (FMI_TRACE_CALL(instance, status)) { \
         FMIValueReferencesToString(instance, valueReferences, nValueReferences); \
         FMIValuesToString(instance, nValues, NULL, values, FMI ## t ## Type); \
         instance->logFunctionCall(instance, status, "fmi3" #s #t "(valueReferences=%s, nValueReferences=%zu, values=%s, nValues=%zu)", instance->buf1, nValueReferences, instance->buf2, nValues); \
@@ -92,7 +122,7 @@ Types for Common Functions
 
 /* Inquire version numbers and setting logging status */
 const char* FMI3GetVersion(FMIInstance *instance) {
-    if (instance->logFunctionCall) {
+    if (FMI_TRACE_CALL(instance, FMIOK)) {
         instance->logFunctionCall(instance, FMIOK, "fmi3GetVersion()");
     }
     return instance->fmi3Functions->fmi3GetVersion();
@@ -103,7 +133,8 @@ FMIStatus FMI3SetDebugLogging(FMIInstance *instance,
     size_t nCategories,
     const fmi3String categories[]) {
     FMIStatus status = (FMIStatus)instance->fmi3Functions->fmi3SetDebugLogging(instance->component, loggingOn, nCategories, categories);
-    if (instance->logFunctionCall) {
+    RECORD_CALL(SetDebugLogging, status, NULL, 0, ARGUMENTS(loggingOn), 1);
+    if (FMI_TRACE_CALL(instance, status)) {
         FMIValuesToString(instance, nCategories, NULL, categories, FMIStringType);
         instance->logFunctionCall(instance, status, "fmi3SetDebugLogging(loggingOn=%d, nCategories=%zu, categories=%s)",
             loggingOn, nCategories, instance->buf2);
@@ -111,17 +142,62 @@ FMIStatus FMI3SetDebugLogging(FMIInstance *instance,
     return status;
 }
 
-static FMIStatus loadSymbols3(FMIInstance *instance) {
+#if defined(FMI_STATIC_FMUS) && (!defined(FMI_VERSION) || FMI_VERSION == 3)
 
-#if !defined(FMI_VERSION) || FMI_VERSION == 3
+/* FMI3_STATIC_MODELS(X) with X(modelIdentifier) for every FMU linked into the executable */
+#include "fmi3StaticModels.h"
 
-    instance->fmi3Functions = calloc(1, sizeof(FMI3Functions));
+/* The FMUs are compiled with FMI3_FUNCTION_PREFIX=<modelIdentifier>_ */
+#define DECLARE_STATIC_FUNCTION(model, f) fmi3 ## f ## TYPE model ## _fmi3 ## f;
+#define DECLARE_STATIC_FUNCTIONS(model) FMI3_FUNCTIONS(DECLARE_STATIC_FUNCTION, model)
 
-    if (!instance->fmi3Functions) {
-        return FMIError;
+FMI3_STATIC_MODELS(DECLARE_STATIC_FUNCTIONS)
+
+typedef struct {
+    const char *modelIdentifier;
+    FMI3Functions functions;
+} StaticModel;
+
+#define STATIC_FUNCTION(model, f) .fmi3 ## f = model ## _fmi3 ## f,
+#define STATIC_MODEL(model) { #model, { FMI3_FUNCTIONS(STATIC_FUNCTION, model) } },
+
+static const StaticModel staticModels[] = { FMI3_STATIC_MODELS(STATIC_MODEL) };
+
+/* Binds the functions of the FMU whose model identifier is the file name of the shared library. */
+static FMIStatus loadFunctions3(FMIInstance *instance) {
+
+    const char *path = FMIGetLibraryPath(instance);
+    const char *name = path;
+
+    for (const char *c = path; *c; c++) {
+        if (*c == '/' || *c == '\\') {
+            name = c + 1;
+        }
     }
 
-    instance->fmiVersion = FMIVersion3;
+    const size_t length = strcspn(name, ".");
+
+    for (size_t i = 0; i < sizeof(staticModels) / sizeof(StaticModel); i++) {
+
+        const char *modelIdentifier = staticModels[i].modelIdentifier;
+
+        if (strlen(modelIdentifier) == length && !strncmp(name, modelIdentifier, length)) {
+            *instance->fmi3Functions = staticModels[i].functions;
+            return FMIOK;
+        }
+    }
+
+    if (instance->logMessage) {
+        instance->logMessage(instance, FMIFatal, "fatal", "The FMU is not linked into the executable.");
+    }
+
+    return FMIFatal;
+}
+
+#elif !defined(FMI_VERSION) || FMI_VERSION == 3
+
+/* Looks up the symbols in the shared library and stores them in instance->fmi3Functions. */
+static FMIStatus loadFunctions3(FMIInstance *instance) {
 
     /***************************************************
     Common Functions
@@ -233,8 +309,41 @@ static FMIStatus loadSymbols3(FMIInstance *instance) {
     LOAD_SYMBOL(DoStep);
     LOAD_SYMBOL(ActivateModelPartition);
 
+    return FMIOK;
+}
+
+#endif
+
+static FMIStatus loadSymbols3(FMIInstance *instance) {
+
+#if !defined(FMI_VERSION) || FMI_VERSION == 3
+
+    instance->fmiVersion = FMIVersion3;
     instance->state = FMI2StartAndEndState;
 
+    // the functions are bound once per shared library
+    instance->fmi3Functions = (FMI3Functions*)FMIGetLibraryFunctions(instance, FMIVersion3);
+
+    if (instance->fmi3Functions) {
+        return FMIOK;
+    }
+
+    instance->fmi3Functions = (FMI3Functions*)calloc(1, sizeof(FMI3Functions));
+
+    if (!instance->fmi3Functions) {
+        return FMIError;
+    }
+
+    const FMIStatus status = loadFunctions3(instance);
+
+    if (status != FMIOK) {
+        free(instance->fmi3Functions);
+        instance->fmi3Functions = NULL;
+        return status;
+    }
+
+    instance->fmi3Functions = (FMI3Functions*)FMIShareLibraryFunctions(instance, FMIVersion3, instance->fmi3Functions);
+
     return FMIOK;
 
 #else
@@ -254,11 +363,17 @@ FMIStatus FMI3InstantiateModelExchange(
 
     FMIStatus status = loadSymbols3(instance);
 
+    if (status != FMIOK) {
+        return status;
+    }
+
     fmi3LogMessageCallback logMessage = instance->logMessage ? cb_logMessage3 : NULL;
 
     instance->component = instance->fmi3Functions->fmi3InstantiateModelExchange(instance->name, instantiationToken, resourcePath, visible, loggingOn, instance, logMessage);
 
-    if (instance->logFunctionCall) {
+    RECORD_INSTANTIATION(InstantiateModelExchange, instance->component ? FMIOK : FMIError, instantiationToken, ARGUMENTS(visible, loggingOn), 2);
+
+    if (FMI_TRACE_CALL(instance, instance->component ? FMIOK : FMIError)) {
         instance->logFunctionCall(instance, instance->component ? FMIOK : FMIError,
             "fmi3InstantiateModelExchange("
             "instanceName=\"%s\", "
@@ -320,9 +435,12 @@ FMIStatus FMI3InstantiateCoSimulation(
         logMessage,
         intermediateUpdate);
 
-    instance->fmi3Functions->eventModeUsed = eventModeUsed;
+    instance->eventModeUsed = eventModeUsed;
+
+    RECORD_INSTANTIATION(InstantiateCoSimulation, instance->component ? FMIOK : FMIError, instantiationToken,
+        ARGUMENTS(visible, loggingOn, eventModeUsed, earlyReturnAllowed), 4);
 
-    if (instance->logFunctionCall) {
+    if (FMI_TRACE_CALL(instance, instance->component ? FMIOK : FMIError)) {
         instance->logFunctionCall(instance, instance->component ? FMIOK : FMIError,
             "fmi3InstantiateCoSimulation("
             "instanceName=\"%s\", "
@@ -392,7 +510,9 @@ FMIStatus FMI3InstantiateScheduledExecution(
         lockPreemption,
         unlockPreemption);
 
-    if (instance->logFunctionCall) {
+    RECORD_INSTANTIATION(InstantiateScheduledExecution, instance->component ? FMIOK : FMIError, instantiationToken, ARGUMENTS(visible, loggingOn), 2);
+
+    if (FMI_TRACE_CALL(instance, instance->component ? FMIOK : FMIError)) {
         instance->logFunctionCall(instance, instance->component ? FMIOK : FMIError,
             "fmi3InstantiateScheduledExecution("
             "instanceName=\"%s\", "
@@ -434,11 +554,18 @@ FMIStatus FMI3FreeInstance(FMIInstance *instance) {
         return FMIError;
     }
 
+    // not instantiated, e.g. after a failure during the setup of the master
+    if (!instance->fmi3Functions || !instance->component) {
+        return FMIOK;
+    }
+
     instance->fmi3Functions->fmi3FreeInstance(instance->component);
 
     instance->component = NULL;
 
-    if (instance->logFunctionCall) {
+    RECORD_CALL(FreeInstance, FMIOK, NULL, 0, NO_VALUES, 0);
+
+    if (FMI_TRACE_CALL(instance, FMIOK)) {
         instance->logFunctionCall(instance, FMIOK, "fmi3FreeInstance()");
     }
 
@@ -455,14 +582,14 @@ FMIStatus FMI3EnterInitializationMode(FMIInstance *instance,
 
     instance->state = FMI2InitializationModeState;
 
-    CALL_ARGS(EnterInitializationMode,
+    CALL_ARGS_RECORD(EnterInitializationMode, NULL, 0, ARGUMENTS(toleranceDefined, tolerance, startTime, stopTimeDefined, stopTime), 5,
         "toleranceDefined=%d, tolerance=%.16g, startTime=%.16g, stopTimeDefined=%d, stopTime=%.16g",
         toleranceDefined, tolerance, startTime, stopTimeDefined, stopTime);
 }
 
 FMIStatus FMI3ExitInitializationMode(FMIInstance *instance) {
 
-    if (instance->interfaceType == FMIModelExchange || (instance->fmiVersion == FMIVersion3 && instance->interfaceType == FMICoSimulation && instance->fmi3Functions->eventModeUsed)) {
+    if (instance->interfaceType == FMIModelExchange || (instance->fmiVersion == FMIVersion3 && instance->interfaceType == FMICoSimulation && instance->eventModeUsed)) {
         instance->state = FMI2EventModeState;
     } else {
         instance->state = FMI2StepCompleteState;
@@ -592,7 +719,9 @@ FMIStatus FMI3GetBinary(FMIInstance *instance,
 
     FMIStatus status = (FMIStatus)instance->fmi3Functions->fmi3GetBinary(instance->component, valueReferences, nValueReferences, sizes, values, nValues);
 
-    if (instance->logFunctionCall) {
+    RECORD_CALL(GetBinary, status, valueReferences, nValueReferences, NO_VALUES, 0);
+
+    if (FMI_TRACE_CALL(instance, status)) {
         FMIValueReferencesToString(instance, valueReferences, nValueReferences);
         FMIValuesToString(instance, nValues, sizes, values, FMIBinaryType);
         instance->logFunctionCall(instance, status, "fmi3GetBinary(valueReferences=%s, nValueReferences=%zu, sizes=%p, values=%s, nValues=%zu)", instance->buf1, nValueReferences, sizes, instance->buf2, nValues);
@@ -608,7 +737,9 @@ FMIStatus FMI3GetClock(FMIInstance *instance,
 
     FMIStatus status = (FMIStatus)instance->fmi3Functions->fmi3GetClock(instance->component, valueReferences, nValueReferences, values);
 
-    if (instance->logFunctionCall) {
+    RECORD_CALL(GetClock, status, valueReferences, nValueReferences, values, nValueReferences);
+
+    if (FMI_TRACE_CALL(instance, status)) {
         FMIValueReferencesToString(instance, valueReferences, nValueReferences);
         FMIValuesToString(instance, nValueReferences, NULL, values, FMIClockType);
         instance->logFunctionCall(instance, status, "fmi3GetClock(valueReferences=%s, nValueReferences=%zu, values=%s)", instance->buf1, nValueReferences, instance->buf2);
@@ -722,7 +853,9 @@ FMIStatus FMI3SetBinary(FMIInstance *instance,
 
     FMIStatus status = (FMIStatus)instance->fmi3Functions->fmi3SetBinary(instance->component, valueReferences, nValueReferences, sizes, values, nValues);
 
-    if (instance->logFunctionCall) {
+    RECORD_CALL(SetBinary, status, valueReferences, nValueReferences, NO_VALUES, 0);
+
+    if (FMI_TRACE_CALL(instance, status)) {
         FMIValueReferencesToString(instance, valueReferences, nValueReferences);
         FMIValuesToString(instance, nValues, sizes, values, FMIBinaryType);
         instance->logFunctionCall(instance, status, "fmi3SetBinary(valueReferences=%s, nValueReferences=%zu, sizes=0x%p, values=%s, nValues=%zu", instance->buf1, nValueReferences, sizes, instance->buf2, nValues);
@@ -738,7 +871,9 @@ FMIStatus FMI3SetClock(FMIInstance *instance,
 
     FMIStatus status = (FMIStatus)instance->fmi3Functions->fmi3SetClock(instance->component, valueReferences, nValueReferences, values);
 
-    if (instance->logFunctionCall) {
+    RECORD_CALL(SetClock, status, valueReferences, nValueReferences, values, nValueReferences);
+
+    if (FMI_TRACE_CALL(instance, status)) {
         FMIValueReferencesToString(instance, valueReferences, nValueReferences);
         FMIValuesToString(instance, nValueReferences, NULL, values, FMIClockType);
         instance->logFunctionCall(instance, status, "fmi3SetClock(valueReferences=%s, nValueReferences=%zu, values=%s)", instance->buf1, nValueReferences, instance->buf2);
@@ -783,7 +918,8 @@ FMIStatus FMI3SerializedFMUStateSize(FMIInstance *instance,
     fmi3FMUState  FMUState,
     size_t* size) {
     FMIStatus status = (FMIStatus)instance->fmi3Functions->fmi3SerializedFMUStateSize(instance->component, FMUState, size);
-    if (instance->logFunctionCall) {
+    RECORD_CALL(SerializedFMUStateSize, status, NULL, 0, NO_VALUES, 0);
+    if (FMI_TRACE_CALL(instance, status)) {
         instance->logFunctionCall(instance, status, "fmi3SerializedFMUStateSize(FMUState=0x%p, size=%zu)", FMUState, *size);
     }
     return status;
@@ -832,6 +968,66 @@ FMIStatus FMI3GetAdjointDerivative(FMIInstance *instance,
         unknowns, nUnknowns, knowns, nKnowns, seed, nSeed, sensitivity, nSensitivity);
 }
 
+FMIStatus FMI3GetJacobian(FMIInstance *instance,
+    const fmi3ValueReference unknowns[],
+    size_t nUnknowns,
+    const fmi3ValueReference knowns[],
+    size_t nKnowns,
+    fmi3Float64 jacobian[]) {
+
+    if (nUnknowns == 0 || nKnowns == 0) {
+        return FMIOK;
+    }
+
+    // one derivative per column or row, whichever are fewer
+    const bool adjoint = nUnknowns < nKnowns;
+
+    const size_t nSeed        = adjoint ? nUnknowns : nKnowns;
+    const size_t nSensitivity = adjoint ? nKnowns   : nUnknowns;
+
+    FMIStatus status = FMIOK;
+
+    fmi3Float64 *seed        = (fmi3Float64*)calloc(nSeed, sizeof(fmi3Float64));
+    fmi3Float64 *sensitivity = (fmi3Float64*)calloc(nSensitivity, sizeof(fmi3Float64));
+
+    if (!seed || !sensitivity) {
+        status = FMIError;
+        goto TERMINATE;
+    }
+
+    for (size_t k = 0; k < nSeed; k++) {
+
+        seed[k] = 1.0;
+
+        if (adjoint) {
+            status = FMI3GetAdjointDerivative(instance, unknowns, nUnknowns, knowns, nKnowns, seed, nSeed, sensitivity, nSensitivity);
+        } else {
+            status = FMI3GetDirectionalDerivative(instance, unknowns, nUnknowns, knowns, nKnowns, seed, nSeed, sensitivity, nSensitivity);
+        }
+
+        if (status > FMIWarning) {
+            goto TERMINATE;
+        }
+
+        seed[k] = 0.0;
+
+        // row k of the adjoint or column k of the directional derivatives
+        for (size_t l = 0; l < nSensitivity; l++) {
+            if (adjoint) {
+                jacobian[k * nKnowns + l] = sensitivity[l];
+            } else {
+                jacobian[l * nKnowns + k] = sensitivity[l];
+            }
+        }
+    }
+
+TERMINATE:
+    free(seed);
+    free(sensitivity);
+
+    return status;
+}
+
 /* Entering and exiting the Configuration or Reconfiguration Mode */
 FMIStatus FMI3EnterConfigurationMode(FMIInstance *instance) {
     CALL(EnterConfigurationMode);
@@ -848,7 +1044,7 @@ FMI_STATIC FMIStatus FMI3GetIntervalDecimal(FMIInstance *instance,
     size_t nValueReferences,
     fmi3Float64 intervals[],
     fmi3IntervalQualifier qualifiers[]) {
-    CALL_ARGS(GetIntervalDecimal,
+    CALL_ARGS_RECORD(GetIntervalDecimal, valueReferences, nValueReferences, intervals, nValueReferences,
         "valueReferences=0x%p, nValueReferences=%zu, intervals=0x%p, qualifiers=0x%p",
         valueReferences, nValueReferences, intervals, qualifiers);
 }
@@ -859,7 +1055,7 @@ FMIStatus FMI3GetIntervalFraction(FMIInstance *instance,
     fmi3UInt64 intervalCounters[],
     fmi3UInt64 resolutions[],
     fmi3IntervalQualifier qualifiers[]) {
-    CALL_ARGS(GetIntervalFraction,
+    CALL_ARGS_RECORD(GetIntervalFraction, valueReferences, nValueReferences, intervalCounters, nValueReferences,
         "valueReferences=0x%p, nValueReferences=%zu, intervalCounters=0x%p, resolutions=0x%p, qualifiers=%d",
         valueReferences, nValueReferences, intervalCounters, resolutions, qualifiers);
 }
@@ -868,7 +1064,7 @@ FMIStatus FMI3GetShiftDecimal(FMIInstance *instance,
     const fmi3ValueReference valueReferences[],
     size_t nValueReferences,
     fmi3Float64 shifts[]) {
-    CALL_ARGS(GetShiftDecimal,
+    CALL_ARGS_RECORD(GetShiftDecimal, valueReferences, nValueReferences, shifts, nValueReferences,
         "valueReferences=0x%p, nValueReferences=%zu, shifts=0x%p",
         valueReferences, nValueReferences, shifts);
 }
@@ -878,7 +1074,7 @@ FMIStatus FMI3GetShiftFraction(FMIInstance *instance,
     size_t nValueReferences,
     fmi3UInt64 shiftCounters[],
     fmi3UInt64 resolutions[]) {
-    CALL_ARGS(GetShiftFraction,
+    CALL_ARGS_RECORD(GetShiftFraction, valueReferences, nValueReferences, shiftCounters, nValueReferences,
         "valueReferences=0x%p, nValueReferences=%zu, shiftCounters=0x%p, resolutions=0x%p",
         valueReferences, nValueReferences, shiftCounters, resolutions);
 }
@@ -887,7 +1083,7 @@ FMIStatus FMI3SetIntervalDecimal(FMIInstance *instance,
     const fmi3ValueReference valueReferences[],
     size_t nValueReferences,
     const fmi3Float64 intervals[]) {
-    CALL_ARGS(SetIntervalDecimal,
+    CALL_ARGS_RECORD(SetIntervalDecimal, valueReferences, nValueReferences, intervals, nValueReferences,
         "valueReferences=0x%p, nValueReferences=%zu, intervals=0x%p",
         valueReferences, nValueReferences, intervals);
 }
@@ -897,7 +1093,7 @@ FMIStatus FMI3SetIntervalFraction(FMIInstance *instance,
     size_t nValueReferences,
     const fmi3UInt64 intervalCounters[],
     const fmi3UInt64 resolutions[]) {
-    CALL_ARGS(SetIntervalFraction,
+    CALL_ARGS_RECORD(SetIntervalFraction, valueReferences, nValueReferences, intervalCounters, nValueReferences,
         "valueReferences=0x%p, nValueReferences=%zu, intervalCounters=0x%p, resolutions=0x%p",
         valueReferences, nValueReferences, intervalCounters, resolutions);
 }
@@ -906,7 +1102,7 @@ FMIStatus FMI3SetShiftDecimal(FMIInstance *instance,
     const fmi3ValueReference valueReferences[],
     size_t nValueReferences,
     const fmi3Float64 shifts[]) {
-    CALL_ARGS(SetShiftDecimal,
+    CALL_ARGS_RECORD(SetShiftDecimal, valueReferences, nValueReferences, shifts, nValueReferences,
         "valueReferences=0x%p, nValueReferences=%zu, shifts=0x%p",
         valueReferences, nValueReferences, shifts);
 }
@@ -916,7 +1112,7 @@ FMIStatus FMI3SetShiftFraction(FMIInstance *instance,
     size_t nValueReferences,
     const fmi3UInt64 shiftCounters[],
     const fmi3UInt64 resolutions[]) {
-    CALL_ARGS(SetShiftFraction,
+    CALL_ARGS_RECORD(SetShiftFraction, valueReferences, nValueReferences, shiftCounters, nValueReferences,
         "valueReferences=0x%p, nValueReferences=%zu, shiftCounters=0x%p, resolutions=0x%p",
         valueReferences, nValueReferences, shiftCounters, resolutions);
 }
@@ -943,7 +1139,10 @@ FMIStatus FMI3UpdateDiscreteStates(FMIInstance *instance,
 
     FMIStatus status = (FMIStatus)instance->fmi3Functions->fmi3UpdateDiscreteStates(instance->component, discreteStatesNeedUpdate, terminateSimulation, nominalsOfContinuousStatesChanged, valuesOfContinuousStatesChanged, nextEventTimeDefined, nextEventTime);
 
-    if (instance->logFunctionCall) {
+    RECORD_CALL(UpdateDiscreteStates, status, NULL, 0, ARGUMENTS(*discreteStatesNeedUpdate, *terminateSimulation,
+        *nominalsOfContinuousStatesChanged, *valuesOfContinuousStatesChanged, *nextEventTimeDefined, *nextEventTime), 6);
+
+    if (FMI_TRACE_CALL(instance, status)) {
         instance->logFunctionCall(instance, status,
             "fmi3UpdateDiscreteStates(discreteStatesNeedUpdate=%d, terminateSimulation=%d, nominalsOfContinuousStatesChanged=%d, valuesOfContinuousStatesChanged=%d, nextEventTimeDefined=%d, nextEventTime=%.16g)",
             *discreteStatesNeedUpdate, *terminateSimulation, *nominalsOfContinuousStatesChanged, *valuesOfContinuousStatesChanged, *nextEventTimeDefined, *nextEventTime);
@@ -968,7 +1167,9 @@ FMIStatus FMI3CompletedIntegratorStep(FMIInstance *instance,
 
     FMIStatus status = (FMIStatus)instance->fmi3Functions->fmi3CompletedIntegratorStep(instance->component, noSetFMUStatePriorToCurrentPoint, enterEventMode, terminateSimulation);
 
-    if (instance->logFunctionCall) {
+    RECORD_CALL(CompletedIntegratorStep, status, NULL, 0, ARGUMENTS(noSetFMUStatePriorToCurrentPoint, *enterEventMode, *terminateSimulation), 3);
+
+    if (FMI_TRACE_CALL(instance, status)) {
         instance->logFunctionCall(instance, status,
             "fmi3CompletedIntegratorStep(noSetFMUStatePriorToCurrentPoint=%d, enterEventMode=%d, terminateSimulation=%d)",
             noSetFMUStatePriorToCurrentPoint, *enterEventMode, *terminateSimulation);
@@ -980,7 +1181,7 @@ FMIStatus FMI3CompletedIntegratorStep(FMIInstance *instance,
 /* Providing independent variables and re-initialization of caching */
 FMIStatus FMI3SetTime(FMIInstance *instance, fmi3Float64 time) {
     instance->time = time;
-    CALL_ARGS(SetTime, "time=%.16g", time);
+    CALL_ARGS_RECORD(SetTime, NULL, 0, &time, 1, "time=%.16g", time);
 }
 
 FMIStatus FMI3SetContinuousStates(FMIInstance *instance,
@@ -989,7 +1190,9 @@ FMIStatus FMI3SetContinuousStates(FMIInstance *instance,
 
     FMIStatus status = (FMIStatus)instance->fmi3Functions->fmi3SetContinuousStates(instance->component, continuousStates, nContinuousStates);
 
-    if (instance->logFunctionCall) {
+    RECORD_CALL(SetContinuousStates, status, NULL, 0, continuousStates, nContinuousStates);
+
+    if (FMI_TRACE_CALL(instance, status)) {
         FMIValuesToString(instance, nContinuousStates, NULL, continuousStates, FMIFloat64Type);
         instance->logFunctionCall(instance, status,
             "fmi3SetContinuousStates(continuousStates=%s, nContinuousStates=%zu)",
@@ -1006,7 +1209,9 @@ FMIStatus FMI3GetContinuousStateDerivatives(FMIInstance *instance,
 
     FMIStatus status = (FMIStatus)instance->fmi3Functions->fmi3GetContinuousStateDerivatives(instance->component, derivatives, nContinuousStates);
 
-    if (instance->logFunctionCall) {
+    RECORD_CALL(GetContinuousStateDerivatives, status, NULL, 0, derivatives, nContinuousStates);
+
+    if (FMI_TRACE_CALL(instance, status)) {
         FMIValuesToString(instance, nContinuousStates, NULL, derivatives, FMIFloat64Type);
         instance->logFunctionCall(instance, status,
             "fmi3GetContinuousStateDerivatives(derivatives=%s, nContinuousStates=%zu)",
@@ -1022,7 +1227,9 @@ FMIStatus FMI3GetEventIndicators(FMIInstance *instance,
 
     FMIStatus status = (FMIStatus)instance->fmi3Functions->fmi3GetEventIndicators(instance->component, eventIndicators, nEventIndicators);
 
-    if (instance->logFunctionCall) {
+    RECORD_CALL(GetEventIndicators, status, NULL, 0, eventIndicators, nEventIndicators);
+
+    if (FMI_TRACE_CALL(instance, status)) {
         FMIValuesToString(instance, nEventIndicators, NULL, eventIndicators, FMIFloat64Type);
         instance->logFunctionCall(instance, status,
             "fmi3GetEventIndicators(eventIndicators=%s, nEventIndicators=%zu)",
@@ -1038,7 +1245,9 @@ FMIStatus FMI3GetContinuousStates(FMIInstance *instance,
 
     FMIStatus status = (FMIStatus)instance->fmi3Functions->fmi3GetContinuousStates(instance->component, continuousStates, nContinuousStates);
 
-    if (instance->logFunctionCall) {
+    RECORD_CALL(GetContinuousStates, status, NULL, 0, continuousStates, nContinuousStates);
+
+    if (FMI_TRACE_CALL(instance, status)) {
         FMIValuesToString(instance, nContinuousStates, NULL, continuousStates, FMIFloat64Type);
         instance->logFunctionCall(instance, status,
             "fmi3GetContinuousStates(continuousStates=%s, nContinuousStates=%zu)",
@@ -1097,7 +1306,10 @@ FMIStatus FMI3DoStep(FMIInstance *instance,
 
     FMIStatus status = (FMIStatus)instance->fmi3Functions->fmi3DoStep(instance->component, currentCommunicationPoint, communicationStepSize, noSetFMUStatePriorToCurrentPoint, eventEncountered, terminate, earlyReturn, lastSuccessfulTime);
 
-    if (instance->logFunctionCall) {
+    RECORD_CALL(DoStep, status, NULL, 0, ARGUMENTS(currentCommunicationPoint, communicationStepSize, noSetFMUStatePriorToCurrentPoint,
+        *eventEncountered, *terminate, *earlyReturn, *lastSuccessfulTime), 7);
+
+    if (FMI_TRACE_CALL(instance, status)) {
         instance->logFunctionCall(instance, status,
             "fmi3DoStep(currentCommunicationPoint=%.16g, communicationStepSize=%.16g, noSetFMUStatePriorToCurrentPoint=%d, eventEncountered=%d, terminate=%d, earlyReturn=%d, lastSuccessfulTime=%.16g)",
             currentCommunicationPoint, communicationStepSize, noSetFMUStatePriorToCurrentPoint, *eventEncountered, *terminate, *earlyReturn, *lastSuccessfulTime);
@@ -1111,7 +1323,7 @@ FMIStatus FMI3DoStep(FMIInstance *instance,
 FMIStatus FMI3ActivateModelPartition(FMIInstance *instance,
     fmi3ValueReference clockReference,
     fmi3Float64 activationTime) {
-    CALL_ARGS(ActivateModelPartition,
+    CALL_ARGS_RECORD(ActivateModelPartition, &clockReference, 1, &activationTime, 1,
         "clockReference=%u, activationTime=%.16g",
         clockReference, activationTime);
 }
@@ -1119,4 +1331,7 @@ FMIStatus FMI3ActivateModelPartition(FMIInstance *instance,
 #undef LOAD_SYMBOL
 #undef CALL
 #undef CALL_ARGS
+#undef CALL_ARGS_RECORD
+#undef RECORD_CALL
+#undef RECORD_INSTANTIATION
 #undef CALL_ARRAY
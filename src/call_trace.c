@@ -0,0 +1,297 @@
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+typedef SRWLOCK Lock;
+#define LOCK_INIT(l)  InitializeSRWLock(l)
+#define LOCK(l)       AcquireSRWLockExclusive(l)
+#define UNLOCK(l)     ReleaseSRWLockExclusive(l)
+#define LOCK_FREE(l)
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <pthread.h>
+typedef pthread_mutex_t Lock;
+#define LOCK_INIT(l)  pthread_mutex_init(l, NULL)
+#define LOCK(l)       pthread_mutex_lock(l)
+#define UNLOCK(l)     pthread_mutex_unlock(l)
+#define LOCK_FREE(l)  pthread_mutex_destroy(l)
+#endif
+
+#include "call_trace.h"
+
+#define CALL_TRACE_FUNCTION_NAME(a, f) "fmi3" #f,
+
+static const char* const functionNames[N_CALL_TRACE_FUNCTIONS] = { FMI3_FUNCTIONS(CALL_TRACE_FUNCTION_NAME, _) };
+
+struct CallTrace_ {
+
+#ifdef _WIN32
+    HANDLE file;
+    HANDLE mapping;
+#else
+    int file;
+#endif
+
+    void *memory;
+    size_t size;
+    bool writable;
+
+    CallTraceHeader *header;
+    CallTraceRecord *records;
+
+    // guards the header and the records
+    Lock lock;
+};
+
+static void copyString(char *destination, const char *source, size_t size) {
+    strncpy(destination, source ? source : "", size - 1);
+    destination[size - 1] = '\0';
+}
+
+/* Maps size bytes of the file, which is resized if writable. */
+static CallTrace* mapFile(const char *path, size_t size, bool writable) {
+
+    CallTrace *trace = (CallTrace*)calloc(1, sizeof(CallTrace));
+
+    if (!trace) {
+        return NULL;
+    }
+
+    trace->writable = writable;
+
+#ifdef _WIN32
+    trace->file = CreateFileA(path, writable ? GENERIC_READ | GENERIC_WRITE : GENERIC_READ, FILE_SHARE_READ, NULL,
+        writable ? CREATE_ALWAYS : OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+
+    if (trace->file == INVALID_HANDLE_VALUE) {
+        free(trace);
+        return NULL;
+    }
+
+    if (!writable) {
+        LARGE_INTEGER fileSize;
+        GetFileSizeEx(trace->file, &fileSize);
+        size = (size_t)fileSize.QuadPart;
+    }
+
+    trace->mapping = size > 0 ? CreateFileMappingA(trace->file, NULL, writable ? PAGE_READWRITE : PAGE_READONLY,
+        (DWORD)((uint64_t)size >> 32), (DWORD)size, NULL) : NULL;
+
+    if (trace->mapping) {
+        trace->memory = MapViewOfFile(trace->mapping, writable ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, size);
+    }
+#else
+    trace->file = open(path, writable ? O_RDWR | O_CREAT | O_TRUNC : O_RDONLY, 0644);
+
+    if (trace->file < 0) {
+        free(trace);
+        return NULL;
+    }
+
+    if (writable) {
+        if (ftruncate(trace->file, (off_t)size)) {
+            size = 0;
+        }
+    } else {
+        struct stat status;
+        size = fstat(trace->file, &status) ? 0 : (size_t)status.st_size;
+    }
+
+    if (size > 0) {
+        trace->memory = mmap(NULL, size, writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, trace->file, 0);
+        if (trace->memory == MAP_FAILED) {
+            trace->memory = NULL;
+        }
+    }
+#endif
+
+    trace->size = size;
+
+    LOCK_INIT(&trace->lock);
+
+    if (!trace->memory) {
+        CallTraceFree(trace);
+        return NULL;
+    }
+
+    trace->header  = (CallTraceHeader*)trace->memory;
+    trace->records = (CallTraceRecord*)((char*)trace->memory + sizeof(CallTraceHeader));
+
+    return trace;
+}
+
+CallTrace* CallTraceCreate(const char *path, size_t capacity) {
+
+    if (capacity == 0) {
+        return NULL;
+    }
+
+    CallTrace *trace = mapFile(path, sizeof(CallTraceHeader) + capacity * sizeof(CallTraceRecord), true);
+
+    if (!trace) {
+        return NULL;
+    }
+
+    CallTraceHeader *header = trace->header;
+
+    memcpy(header->magic, CALL_TRACE_MAGIC, sizeof(CALL_TRACE_MAGIC));
+    header->version    = CALL_TRACE_VERSION;
+    header->recordSize = sizeof(CallTraceRecord);
+    header->capacity   = capacity;
+
+    return trace;
+}
+
+CallTrace* CallTraceOpen(const char *path) {
+
+    CallTrace *trace = mapFile(path, 0, false);
+
+    if (!trace) {
+        return NULL;
+    }
+
+    const CallTraceHeader *header = trace->header;
+
+    if (trace->size < sizeof(CallTraceHeader) ||
+        memcmp(header->magic, CALL_TRACE_MAGIC, sizeof(CALL_TRACE_MAGIC)) ||
+        header->version != CALL_TRACE_VERSION ||
+        header->recordSize != sizeof(CallTraceRecord) ||
+        header->nInstances > CALL_TRACE_MAX_INSTANCES ||
+        header->capacity == 0 ||
+        header->capacity > (trace->size - sizeof(CallTraceHeader)) / sizeof(CallTraceRecord)) {
+        CallTraceFree(trace);
+        return NULL;
+    }
+
+    return trace;
+}
+
+void CallTraceFree(CallTrace *trace) {
+
+    if (!trace) {
+        return;
+    }
+
+#ifdef _WIN32
+    if (trace->memory) {
+        if (trace->writable) {
+            FlushViewOfFile(trace->memory, 0);
+        }
+        UnmapViewOfFile(trace->memory);
+    }
+    if (trace->mapping) {
+        CloseHandle(trace->mapping);
+    }
+    CloseHandle(trace->file);
+#else
+    if (trace->memory) {
+        if (trace->writable) {
+            msync(trace->memory, trace->size, MS_SYNC);
+        }
+        munmap(trace->memory, trace->size);
+    }
+    close(trace->file);
+#endif
+
+    LOCK_FREE(&trace->lock);
+
+    free(trace);
+}
+
+FMIStatus CallTraceAddInstance(CallTrace *trace, FMIInstance *instance) {
+
+    if (!trace->writable) {
+        return FMIError;
+    }
+
+    LOCK(&trace->lock);
+
+    CallTraceHeader *header = trace->header;
+
+    if (header->nInstances == CALL_TRACE_MAX_INSTANCES) {
+        UNLOCK(&trace->lock);
+        return FMIError;
+    }
+
+    CallTraceInstance *entry = &header->instances[header->nInstances];
+
+    copyString(entry->name, instance->name, sizeof(entry->name));
+    copyString(entry->libraryPath, FMIGetLibraryPath(instance), sizeof(entry->libraryPath));
+
+    instance->callTrace = trace;
+    instance->callTraceIndex = header->nInstances++;
+
+    UNLOCK(&trace->lock);
+
+    return FMIOK;
+}
+
+const CallTraceHeader* CallTraceGetHeader(const CallTrace *trace) {
+    return trace->header;
+}
+
+const CallTraceRecord* CallTraceGetRecord(const CallTrace *trace, uint64_t sequence) {
+
+    const CallTraceHeader *header = trace->header;
+
+    if (sequence >= header->nRecords || header->nRecords - sequence > header->capacity) {
+        return NULL;
+    }
+
+    return &trace->records[sequence % header->capacity];
+}
+
+const char* CallTraceFunctionName(CallTraceFunction function) {
+    return function < N_CALL_TRACE_FUNCTIONS ? functionNames[function] : "unknown";
+}
+
+void CallTraceWrite(FMIInstance *instance, CallTraceFunction function, FMIStatus status,
+    const fmi3ValueReference valueReferences[], size_t nValueReferences,
+    const void *values, size_t valueSize, size_t nValues) {
+
+    CallTrace *trace = instance->callTrace;
+
+    const size_t nStoredValueReferences = nValueReferences < CALL_TRACE_MAX_VALUE_REFERENCES ? nValueReferences : CALL_TRACE_MAX_VALUE_REFERENCES;
+    const size_t nStoredValues = valueSize == 0 ? 0 : (nValues < CALL_TRACE_MAX_VALUE_BYTES / valueSize ? nValues : CALL_TRACE_MAX_VALUE_BYTES / valueSize);
+
+    LOCK(&trace->lock);
+
+    const uint64_t sequence = trace->header->nRecords++;
+
+    CallTraceRecord *record = &trace->records[sequence % trace->header->capacity];
+
+    record->sequence         = sequence;
+    record->function         = (uint16_t)function;
+    record->instance         = (uint8_t)instance->callTraceIndex;
+    record->status           = (uint8_t)status;
+    record->nValueReferences = (uint32_t)nValueReferences;
+    record->nValues          = (uint32_t)nValues;
+    record->valueSize        = (uint32_t)valueSize;
+
+    for (size_t i = 0; i < nStoredValueReferences; i++) {
+        record->valueReferences[i] = valueReferences[i];
+    }
+
+    if (nStoredValues > 0) {
+        memcpy(record->values, values, nStoredValues * valueSize);
+    }
+
+    UNLOCK(&trace->lock);
+}
+
+void CallTraceSetInstantiationToken(FMIInstance *instance, fmi3String instantiationToken) {
+
+    CallTrace *trace = instance->callTrace;
+
+    LOCK(&trace->lock);
+
+    CallTraceInstance *entry = &trace->header->instances[instance->callTraceIndex];
+
+    copyString(entry->instantiationToken, instantiationToken, sizeof(entry->instantiationToken));
+
+    UNLOCK(&trace->lock);
+}
@@ -0,0 +1,354 @@
+/*
+Re-drives the FMUs of a binary call trace, see call_trace.h.
+
+    synchronous_control_cs --call-trace=synchronous_control_cs.trace
+    call_trace_replay synchronous_control_cs.trace
+
+The library paths of the instances are relative, so the trace is replayed in the
+directory where it has been recorded. The mode changes, the setters and the steps
+are called with the recorded arguments in the recorded order. The getters are called
+with the recorded value references and their results and the returned status of
+every call are compared with the trace. Calls that cannot be replayed from their
+record, e.g. of FMU states or truncated records, are skipped.
+*/
+
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+
+#include "FMI3.h"
+#include "call_trace.h"
+
+// Mismatches that are printed
+#define MAX_REPORTED_MISMATCHES 10
+
+#define N_ARGUMENTS (CALL_TRACE_MAX_VALUE_BYTES / sizeof(fmi3Float64))
+
+typedef struct {
+    size_t nReplayed;
+    size_t nSkipped;
+    size_t nMismatches;
+} ReplayStatistics;
+
+static void logMessage(FMIInstance* instance, FMIStatus status, const char* category, const char* message) {
+    if (status > FMIOK) {
+        printf("[%s] [%s] %s\n", instance->name, category, message);
+    }
+}
+
+// The clocks of Scheduled Execution are activated by the recorded calls
+static void clockUpdate(fmi3InstanceEnvironment instanceEnvironment) {}
+
+static void lockPreemption(void) {}
+
+static void unlockPreemption(void) {}
+
+static void reportMismatch(ReplayStatistics* statistics, const CallTraceRecord* record, const char* instanceName, const char* message) {
+
+    if (statistics->nMismatches++ < MAX_REPORTED_MISMATCHES) {
+        printf("Call %" PRIu64 ": %s() of %s %s.\n", record->sequence,
+            CallTraceFunctionName((CallTraceFunction)record->function), instanceName, message);
+    }
+}
+
+#define REPLAY_SET(t) \
+    case CallTraceFMI3Set ## t: \
+        status = FMI3Set ## t(instance, valueReferences, nValueReferences, (const fmi3 ## t*)arguments, nValues); \
+        break;
+
+#define REPLAY_GET(t) \
+    case CallTraceFMI3Get ## t: \
+        status = FMI3Get ## t(instance, valueReferences, nValueReferences, (fmi3 ## t*)results, nValues); \
+        compareResults = true; \
+        break;
+
+/* Calls the function of the record. Returns false if the call cannot be replayed. */
+static bool replayCall(FMIInstance* instance, const CallTraceInstance* entry, const CallTraceRecord* record, ReplayStatistics* statistics) {
+
+    const size_t nValueReferences = record->nValueReferences;
+    const size_t nValues = record->nValues;
+
+    // truncated records
+    if (nValueReferences > CALL_TRACE_MAX_VALUE_REFERENCES || nValues * record->valueSize > CALL_TRACE_MAX_VALUE_BYTES) {
+        return false;
+    }
+
+    fmi3ValueReference valueReferences[CALL_TRACE_MAX_VALUE_REFERENCES];
+    fmi3Float64 arguments[N_ARGUMENTS];
+    fmi3Float64 results[N_ARGUMENTS];
+    fmi3UInt64 resolutions[N_ARGUMENTS];
+    fmi3IntervalQualifier qualifiers[N_ARGUMENTS];
+    fmi3Boolean flags[4] = { fmi3False, fmi3False, fmi3False, fmi3False };
+
+    for (size_t i = 0; i < nValueReferences; i++) {
+        valueReferences[i] = record->valueReferences[i];
+    }
+
+    memcpy(arguments, record->values, nValues * record->valueSize);
+    memset(results, 0, sizeof(results));
+
+    FMIStatus status = FMIOK;
+    bool compareResults = false;
+
+    switch ((CallTraceFunction)record->function) {
+
+    case CallTraceFMI3InstantiateModelExchange:
+        status = FMI3InstantiateModelExchange(instance, entry->instantiationToken, NULL, arguments[0] != 0, arguments[1] != 0);
+        break;
+
+    case CallTraceFMI3InstantiateCoSimulation:
+        status = FMI3InstantiateCoSimulation(instance, entry->instantiationToken, NULL, arguments[0] != 0, arguments[1] != 0,
+            arguments[2] != 0, arguments[3] != 0, NULL, 0, NULL);
+        break;
+
+    case CallTraceFMI3InstantiateScheduledExecution:
+        status = FMI3InstantiateScheduledExecution(instance, entry->instantiationToken, NULL, arguments[0] != 0, arguments[1] != 0,
+            NULL, NULL, clockUpdate, lockPreemption, unlockPreemption);
+        break;
+
+    case CallTraceFMI3FreeInstance:
+        status = FMI3FreeInstance(instance);
+        break;
+
+    case CallTraceFMI3EnterInitializationMode:
+        status = FMI3EnterInitializationMode(instance, arguments[0] != 0, arguments[1], arguments[2], arguments[3] != 0, arguments[4]);
+        break;
+
+    case CallTraceFMI3ExitInitializationMode:
+        status = FMI3ExitInitializationMode(instance);
+        break;
+
+    case CallTraceFMI3EnterEventMode:
+        status = FMI3EnterEventMode(instance);
+        break;
+
+    case CallTraceFMI3Terminate:
+        status = FMI3Terminate(instance);
+        break;
+
+    case CallTraceFMI3Reset:
+        status = FMI3Reset(instance);
+        break;
+
+    REPLAY_SET(Float32)
+    REPLAY_SET(Float64)
+    REPLAY_SET(Int8)
+    REPLAY_SET(UInt8)
+    REPLAY_SET(Int16)
+    REPLAY_SET(UInt16)
+    REPLAY_SET(Int32)
+    REPLAY_SET(UInt32)
+    REPLAY_SET(Int64)
+    REPLAY_SET(UInt64)
+    REPLAY_SET(Boolean)
+
+    REPLAY_GET(Float32)
+    REPLAY_GET(Float64)
+    REPLAY_GET(Int8)
+    REPLAY_GET(UInt8)
+    REPLAY_GET(Int16)
+    REPLAY_GET(UInt16)
+    REPLAY_GET(Int32)
+    REPLAY_GET(UInt32)
+    REPLAY_GET(Int64)
+    REPLAY_GET(UInt64)
+    REPLAY_GET(Boolean)
+
+    // without nValues
+    case CallTraceFMI3SetClock:
+        status = FMI3SetClock(instance, valueReferences, nValueReferences, (const fmi3Clock*)arguments);
+        break;
+
+    case CallTraceFMI3GetClock:
+        status = FMI3GetClock(instance, valueReferences, nValueReferences, (fmi3Clock*)results);
+        compareResults = true;
+        break;
+
+    case CallTraceFMI3GetIntervalDecimal:
+        status = FMI3GetIntervalDecimal(instance, valueReferences, nValueReferences, results, qualifiers);
+        compareResults = true;
+        break;
+
+    case CallTraceFMI3GetIntervalFraction:
+        status = FMI3GetIntervalFraction(instance, valueReferences, nValueReferences, (fmi3UInt64*)results, resolutions, qualifiers);
+        compareResults = true;
+        break;
+
+    case CallTraceFMI3GetShiftDecimal:
+        status = FMI3GetShiftDecimal(instance, valueReferences, nValueReferences, results);
+        compareResults = true;
+        break;
+
+    case CallTraceFMI3GetShiftFraction:
+        status = FMI3GetShiftFraction(instance, valueReferences, nValueReferences, (fmi3UInt64*)results, resolutions);
+        compareResults = true;
+        break;
+
+    case CallTraceFMI3SetIntervalDecimal:
+        status = FMI3SetIntervalDecimal(instance, valueReferences, nValueReferences, arguments);
+        break;
+
+    case CallTraceFMI3SetShiftDecimal:
+        status = FMI3SetShiftDecimal(instance, valueReferences, nValueReferences, arguments);
+        break;
+
+    case CallTraceFMI3EnterConfigurationMode:
+        status = FMI3EnterConfigurationMode(instance);
+        break;
+
+    case CallTraceFMI3ExitConfigurationMode:
+        status = FMI3ExitConfigurationMode(instance);
+        break;
+
+    case CallTraceFMI3EvaluateDiscreteStates:
+        status = FMI3EvaluateDiscreteStates(instance);
+        break;
+
+    case CallTraceFMI3UpdateDiscreteStates: {
+        fmi3Boolean terminateSimulation;
+        fmi3Boolean nextEventTimeDefined;
+        fmi3Float64 nextEventTime;
+        status = FMI3UpdateDiscreteStates(instance, &flags[0], &terminateSimulation, &flags[1], &flags[2], &nextEventTimeDefined, &nextEventTime);
+        const fmi3Float64 outputs[] = { flags[0], terminateSimulation, flags[1], flags[2], nextEventTimeDefined, nextEventTime };
+        memcpy(results, outputs, sizeof(outputs));
+        compareResults = true;
+        break;
+    }
+
+    case CallTraceFMI3EnterContinuousTimeMode:
+        status = FMI3EnterContinuousTimeMode(instance);
+        break;
+
+    case CallTraceFMI3CompletedIntegratorStep:
+        status = FMI3CompletedIntegratorStep(instance, arguments[0] != 0, &flags[0], &flags[1]);
+        results[0] = arguments[0];
+        results[1] = flags[0];
+        results[2] = flags[1];
+        compareResults = true;
+        break;
+
+    case CallTraceFMI3SetTime:
+        status = FMI3SetTime(instance, arguments[0]);
+        break;
+
+    case CallTraceFMI3SetContinuousStates:
+        status = FMI3SetContinuousStates(instance, arguments, nValues);
+        break;
+
+    case CallTraceFMI3GetContinuousStateDerivatives:
+        status = FMI3GetContinuousStateDerivatives(instance, results, nValues);
+        compareResults = true;
+        break;
+
+    case CallTraceFMI3GetEventIndicators:
+        status = FMI3GetEventIndicators(instance, results, nValues);
+        compareResults = true;
+        break;
+
+    case CallTraceFMI3GetContinuousStates:
+        status = FMI3GetContinuousStates(instance, results, nValues);
+        compareResults = true;
+        break;
+
+    case CallTraceFMI3EnterStepMode:
+        status = FMI3EnterStepMode(instance);
+        break;
+
+    case CallTraceFMI3DoStep: {
+        fmi3Float64 lastSuccessfulTime;
+        status = FMI3DoStep(instance, arguments[0], arguments[1], arguments[2] != 0, &flags[0], &flags[1], &flags[2], &lastSuccessfulTime);
+        const fmi3Float64 outputs[] = { arguments[0], arguments[1], arguments[2], flags[0], flags[1], flags[2], lastSuccessfulTime };
+        memcpy(results, outputs, sizeof(outputs));
+        compareResults = true;
+        break;
+    }
+
+    case CallTraceFMI3ActivateModelPartition:
+        status = FMI3ActivateModelPartition(instance, valueReferences[0], arguments[0]);
+        break;
+
+    default:
+        return false;
+    }
+
+    if (status != (FMIStatus)record->status) {
+        char message[64];
+        snprintf(message, sizeof(message), "returned %d instead of %d", status, record->status);
+        reportMismatch(statistics, record, entry->name, message);
+    } else if (compareResults && memcmp(results, record->values, nValues * record->valueSize)) {
+        reportMismatch(statistics, record, entry->name, "returned other values");
+    }
+
+    return true;
+}
+
+#undef REPLAY_SET
+#undef REPLAY_GET
+
+int main(int argc, char *argv[])
+{
+    if (argc != 2) {
+        printf("Usage: call_trace_replay <trace>\n");
+        return EXIT_FAILURE;
+    }
+
+    int exitCode = EXIT_FAILURE;
+    ReplayStatistics statistics = { 0, 0, 0 };
+    FMIInstance* instances[CALL_TRACE_MAX_INSTANCES] = { NULL };
+
+    CallTrace* trace = CallTraceOpen(argv[1]);
+
+    if (!trace) {
+        printf("Failed to open the call trace %s.\n", argv[1]);
+        return EXIT_FAILURE;
+    }
+
+    const CallTraceHeader* header = CallTraceGetHeader(trace);
+
+    if (header->nRecords > header->capacity) {
+        printf("The first %" PRIu64 " calls have been overwritten, record the trace with a larger capacity.\n", header->nRecords - header->capacity);
+        goto TERMINATE;
+    }
+
+    for (size_t i = 0; i < header->nInstances; i++) {
+
+        instances[i] = FMICreateInstance(header->instances[i].name, header->instances[i].libraryPath, logMessage, NULL);
+
+        if (!instances[i]) {
+            printf("Failed to load %s.\n", header->instances[i].libraryPath);
+            goto TERMINATE;
+        }
+    }
+
+    for (uint64_t sequence = 0; sequence < header->nRecords; sequence++) {
+
+        const CallTraceRecord* record = CallTraceGetRecord(trace, sequence);
+
+        if (record->instance >= header->nInstances) {
+            printf("Call %" PRIu64 " has an unknown instance.\n", sequence);
+            goto TERMINATE;
+        }
+
+        if (replayCall(instances[record->instance], &header->instances[record->instance], record, &statistics)) {
+            statistics.nReplayed++;
+        } else {
+            statistics.nSkipped++;
+        }
+    }
+
+    printf("Replayed %zu calls, skipped %zu calls, %zu mismatches.\n", statistics.nReplayed, statistics.nSkipped, statistics.nMismatches);
+
+    exitCode = statistics.nMismatches == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+
+TERMINATE:
+
+    for (size_t i = 0; i < CALL_TRACE_MAX_INSTANCES; i++) {
+        FMIFreeInstance(instances[i]);
+    }
+
+    CallTraceFree(trace);
+
+    return exitCode;
+}
@@ -0,0 +1,222 @@
+#include <stdlib.h>
+#include <stdbool.h>
+
+#include "clock_calendar.h"
+
+typedef struct {
+    fmi3UInt64 ticks;     // time of the next tick
+    fmi3UInt64 interval;  // in ticks of the time base
+    size_t id;
+} ClockEntry;
+
+struct ClockCalendar_ {
+
+    fmi3UInt64 resolution;
+
+    ClockEntry *heap;
+    size_t nEntries;
+    size_t capacity;
+};
+
+static fmi3UInt64 gcd(fmi3UInt64 a, fmi3UInt64 b) {
+
+    while (b) {
+        const fmi3UInt64 r = a % b;
+        a = b;
+        b = r;
+    }
+
+    return a;
+}
+
+static bool isEarlier(const ClockEntry *a, const ClockEntry *b) {
+    return a->ticks < b->ticks || (a->ticks == b->ticks && a->id < b->id);
+}
+
+static void siftUp(ClockCalendar *calendar, size_t i) {
+
+    ClockEntry *heap = calendar->heap;
+
+    while (i > 0) {
+
+        const size_t parent = (i - 1) / 2;
+
+        if (!isEarlier(&heap[i], &heap[parent])) {
+            break;
+        }
+
+        const ClockEntry entry = heap[i];
+        heap[i] = heap[parent];
+        heap[parent] = entry;
+
+        i = parent;
+    }
+}
+
+static void siftDown(ClockCalendar *calendar, size_t i) {
+
+    ClockEntry *heap = calendar->heap;
+
+    for (;;) {
+
+        const size_t left = 2 * i + 1;
+        const size_t right = left + 1;
+
+        size_t first = i;
+
+        if (left < calendar->nEntries && isEarlier(&heap[left], &heap[first])) {
+            first = left;
+        }
+
+        if (right < calendar->nEntries && isEarlier(&heap[right], &heap[first])) {
+            first = right;
+        }
+
+        if (first == i) {
+            break;
+        }
+
+        const ClockEntry entry = heap[i];
+        heap[i] = heap[first];
+        heap[first] = entry;
+
+        i = first;
+    }
+}
+
+/* Converts counter / resolution seconds to ticks of the time base. The resolution must divide the one of the time base. */
+static fmi3UInt64 toTicks(const ClockCalendar *calendar, fmi3UInt64 counter, fmi3UInt64 resolution) {
+    return counter * (calendar->resolution / resolution);
+}
+
+ClockCalendar* ClockCalendarCreate(void) {
+
+    ClockCalendar *calendar = (ClockCalendar*)calloc(1, sizeof(ClockCalendar));
+
+    if (!calendar) {
+        return NULL;
+    }
+
+    calendar->resolution = 1;
+
+    return calendar;
+}
+
+void ClockCalendarFree(ClockCalendar *calendar) {
+
+    if (!calendar) {
+        return;
+    }
+
+    free(calendar->heap);
+    free(calendar);
+}
+
+FMIStatus ClockCalendarAddResolution(ClockCalendar *calendar, fmi3UInt64 resolution) {
+
+    if (resolution == 0) {
+        return FMIError;
+    }
+
+    const fmi3UInt64 factor = resolution / gcd(calendar->resolution, resolution);
+
+    if (factor == 1) {
+        return FMIOK;
+    }
+
+    calendar->resolution *= factor;
+
+    // Scaling all entries by the same factor preserves the heap order
+    for (size_t i = 0; i < calendar->nEntries; i++) {
+        calendar->heap[i].ticks *= factor;
+        calendar->heap[i].interval *= factor;
+    }
+
+    return FMIOK;
+}
+
+FMIStatus ClockCalendarAddPeriodicClock(ClockCalendar *calendar, size_t id,
+    fmi3UInt64 intervalCounter, fmi3UInt64 intervalResolution,
+    fmi3UInt64 shiftCounter, fmi3UInt64 shiftResolution) {
+
+    if (intervalCounter == 0) {
+        return FMIError;
+    }
+
+    if (ClockCalendarAddResolution(calendar, intervalResolution) > FMIOK ||
+        ClockCalendarAddResolution(calendar, shiftResolution) > FMIOK) {
+        return FMIError;
+    }
+
+    if (calendar->nEntries == calendar->capacity) {
+
+        const size_t capacity = calendar->capacity ? 2 * calendar->capacity : 4;
+
+        ClockEntry *heap = (ClockEntry*)realloc(calendar->heap, capacity * sizeof(ClockEntry));
+
+        if (!heap) {
+            return FMIError;
+        }
+
+        calendar->heap = heap;
+        calendar->capacity = capacity;
+    }
+
+    ClockEntry *entry = &calendar->heap[calendar->nEntries++];
+
+    entry->ticks    = toTicks(calendar, shiftCounter, shiftResolution);
+    entry->interval = toTicks(calendar, intervalCounter, intervalResolution);
+    entry->id       = id;
+
+    siftUp(calendar, calendar->nEntries - 1);
+
+    return FMIOK;
+}
+
+bool ClockCalendarNextTick(const ClockCalendar *calendar, fmi3UInt64 *ticks) {
+
+    if (calendar->nEntries == 0) {
+        return false;
+    }
+
+    *ticks = calendar->heap[0].ticks;
+
+    return true;
+}
+
+size_t ClockCalendarPopDue(ClockCalendar *calendar, fmi3UInt64 ticks, size_t ids[], size_t nIds) {
+
+    size_t n = 0;
+
+    while (calendar->nEntries > 0 && calendar->heap[0].ticks <= ticks) {
+
+        ClockEntry *entry = &calendar->heap[0];
+
+        bool reported = false;
+
+        for (size_t i = 0; i < n; i++) {
+            if (ids[i] == entry->id) {
+                reported = true;
+            }
+        }
+
+        if (!reported && n < nIds) {
+            ids[n++] = entry->id;
+        }
+
+        // Reschedule at the first tick after ticks
+        entry->ticks += ((ticks - entry->ticks) / entry->interval + 1) * entry->interval;
+
+        siftDown(calendar, 0);
+    }
+
+    return n;
+}
+
+fmi3UInt64 ClockCalendarResolution(const ClockCalendar *calendar) {
+    return calendar->resolution;
+}
+
+fmi3Float64 ClockCalendarToTime(const ClockCalendar *calendar, fmi3UInt64 ticks) {
+    return (fmi3Float64)ticks / (fmi3Float64)calendar->resolution;
+}
@@ -0,0 +1,245 @@
+#include <stdlib.h>
+
+#include "connection_plan.h"
+
+#define CALL(f) do { status = f; if (status > FMIOK) goto TERMINATE; } while (0)
+
+// The value references of one instance and their values, in the arrays of the plan
+typedef struct {
+    FMIInstance *instance;
+    size_t nValueReferences;
+    const fmi3ValueReference *valueReferences;
+    fmi3Float64 *values;
+} Batch;
+
+// An output or input of a connection, sorted by instance and value reference
+typedef struct {
+    size_t instance;
+    fmi3ValueReference valueReference;
+    size_t connection;
+} Endpoint;
+
+struct ConnectionPlan_ {
+
+    size_t nConnections;
+
+    size_t nSources;
+    Batch *sources;
+
+    size_t nTargets;
+    Batch *targets;
+
+    // gathered outputs
+    size_t nOutputs;
+    fmi3ValueReference *outputReferences;
+    fmi3Float64 *outputs;
+
+    // scattered inputs, the value of input i is outputs[scatter[i]]
+    fmi3ValueReference *inputReferences;
+    fmi3Float64 *inputs;
+    size_t *scatter;
+};
+
+static int compareEndpoints(const void *a, const void *b) {
+
+    const Endpoint *e1 = (const Endpoint*)a;
+    const Endpoint *e2 = (const Endpoint*)b;
+
+    if (e1->instance != e2->instance) {
+        return e1->instance < e2->instance ? -1 : 1;
+    }
+
+    if (e1->valueReference != e2->valueReference) {
+        return e1->valueReference < e2->valueReference ? -1 : 1;
+    }
+
+    // keep the order of the connections
+    return e1->connection < e2->connection ? -1 : e1->connection > e2->connection;
+}
+
+static size_t countInstances(const Endpoint endpoints[], size_t n) {
+
+    size_t nInstances = 0;
+
+    for (size_t i = 0; i < n; i++) {
+        if (i == 0 || endpoints[i].instance != endpoints[i - 1].instance) {
+            nInstances++;
+        }
+    }
+
+    return nInstances;
+}
+
+ConnectionPlan* ConnectionPlanCreate(const Scheduler *scheduler, const Connection *const connections[], size_t nConnections) {
+
+    const size_t n = nConnections;
+
+    for (size_t i = 0; i < n; i++) {
+        if (connections[i]->from->type != ModelVariableFloat64 || connections[i]->to->type != ModelVariableFloat64) {
+            return NULL;
+        }
+    }
+
+    ConnectionPlan *plan = (ConnectionPlan*)calloc(1, sizeof(ConnectionPlan));
+    Endpoint *outputs = (Endpoint*)calloc(n + 1, sizeof(Endpoint));
+    Endpoint *inputs = (Endpoint*)calloc(n + 1, sizeof(Endpoint));
+    size_t *slots = (size_t*)calloc(n + 1, sizeof(size_t));  // of the output of every connection
+
+    if (!plan || !outputs || !inputs || !slots) {
+        goto FAILED;
+    }
+
+    plan->nConnections = n;
+
+    for (size_t i = 0; i < n; i++) {
+        outputs[i].instance       = connections[i]->fromInstance;
+        outputs[i].valueReference = connections[i]->from->valueReference;
+        outputs[i].connection     = i;
+        inputs[i].instance        = connections[i]->toInstance;
+        inputs[i].valueReference  = connections[i]->to->valueReference;
+        inputs[i].connection      = i;
+    }
+
+    qsort(outputs, n, sizeof(Endpoint), compareEndpoints);
+    qsort(inputs, n, sizeof(Endpoint), compareEndpoints);
+
+    plan->nSources = countInstances(outputs, n);
+    plan->nTargets = countInstances(inputs, n);
+
+    plan->sources          = (Batch*)calloc(plan->nSources + 1, sizeof(Batch));
+    plan->targets          = (Batch*)calloc(plan->nTargets + 1, sizeof(Batch));
+    plan->outputReferences = (fmi3ValueReference*)calloc(n + 1, sizeof(fmi3ValueReference));
+    plan->outputs          = (fmi3Float64*)calloc(n + 1, sizeof(fmi3Float64));
+    plan->inputReferences  = (fmi3ValueReference*)calloc(n + 1, sizeof(fmi3ValueReference));
+    plan->inputs           = (fmi3Float64*)calloc(n + 1, sizeof(fmi3Float64));
+    plan->scatter          = (size_t*)calloc(n + 1, sizeof(size_t));
+
+    if (!plan->sources || !plan->targets || !plan->outputReferences || !plan->outputs ||
+        !plan->inputReferences || !plan->inputs || !plan->scatter) {
+        goto FAILED;
+    }
+
+    // Gather: one slot per distinct output
+    Batch *batch = NULL;
+    size_t nBatches = 0;
+
+    for (size_t i = 0; i < n; i++) {
+
+        const Endpoint *e = &outputs[i];
+
+        if (i == 0 || e->instance != outputs[i - 1].instance) {
+            batch = &plan->sources[nBatches++];
+            batch->instance = SchedulerGetInstance(scheduler, e->instance);
+            batch->valueReferences = &plan->outputReferences[plan->nOutputs];
+            batch->values = &plan->outputs[plan->nOutputs];
+        }
+
+        if (i == 0 || e->instance != outputs[i - 1].instance || e->valueReference != outputs[i - 1].valueReference) {
+            plan->outputReferences[plan->nOutputs++] = e->valueReference;
+            batch->nValueReferences++;
+        }
+
+        slots[e->connection] = plan->nOutputs - 1;
+    }
+
+    // Scatter: one slot per connection
+    nBatches = 0;
+
+    for (size_t i = 0; i < n; i++) {
+
+        const Endpoint *e = &inputs[i];
+
+        if (i == 0 || e->instance != inputs[i - 1].instance) {
+            batch = &plan->targets[nBatches++];
+            batch->instance = SchedulerGetInstance(scheduler, e->instance);
+            batch->valueReferences = &plan->inputReferences[i];
+            batch->values = &plan->inputs[i];
+        }
+
+        plan->inputReferences[i] = e->valueReference;
+        plan->scatter[i] = slots[e->connection];
+        batch->nValueReferences++;
+    }
+
+    free(outputs);
+    free(inputs);
+    free(slots);
+
+    return plan;
+
+FAILED:
+    free(outputs);
+    free(inputs);
+    free(slots);
+    ConnectionPlanFree(plan);
+
+    return NULL;
+}
+
+ConnectionPlan* ConnectionPlanCreateContinuous(const Scheduler *scheduler) {
+
+    const size_t nConnections = SchedulerGetNumberOfConnections(scheduler);
+    const Connection **connections = (const Connection**)calloc(nConnections + 1, sizeof(Connection*));
+    size_t n = 0;
+
+    if (!connections) {
+        return NULL;
+    }
+
+    for (size_t i = 0; i < nConnections; i++) {
+
+        const Connection *c = SchedulerGetConnection(scheduler, i);
+
+        if (!SchedulerIsClockedConnection(c)) {
+            connections[n++] = c;
+        }
+    }
+
+    ConnectionPlan *plan = ConnectionPlanCreate(scheduler, connections, n);
+
+    free(connections);
+
+    return plan;
+}
+
+void ConnectionPlanFree(ConnectionPlan *plan) {
+
+    if (!plan) {
+        return;
+    }
+
+    free(plan->sources);
+    free(plan->targets);
+    free(plan->outputReferences);
+    free(plan->outputs);
+    free(plan->inputReferences);
+    free(plan->inputs);
+    free(plan->scatter);
+    free(plan);
+}
+
+size_t ConnectionPlanGetNumberOfConnections(const ConnectionPlan *plan) {
+    return plan->nConnections;
+}
+
+FMIStatus ConnectionPlanExchange(ConnectionPlan *plan) {
+
+    FMIStatus status = FMIOK;
+
+    for (size_t i = 0; i < plan->nSources; i++) {
+        const Batch *b = &plan->sources[i];
+        CALL(FMI3GetFloat64(b->instance, b->valueReferences, b->nValueReferences, b->values, b->nValueReferences));
+    }
+
+    for (size_t i = 0; i < plan->nConnections; i++) {
+        plan->inputs[i] = plan->outputs[plan->scatter[i]];
+    }
+
+    for (size_t i = 0; i < plan->nTargets; i++) {
+        const Batch *b = &plan->targets[i];
+        CALL(FMI3SetFloat64(b->instance, b->valueReferences, b->nValueReferences, b->values, b->nValueReferences));
+    }
+
+TERMINATE:
+    return status;
+}
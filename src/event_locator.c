@@ -0,0 +1,174 @@
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <stdbool.h>
+
+#include "event_locator.h"
+
+#define CALL(f) do { status = f; if (status > FMIOK) goto TERMINATE; } while (0)
+
+typedef enum {
+    SideNone,
+    SideLeft,
+    SideRight
+} BracketSide;
+
+struct EventLocator_ {
+
+    size_t nz;
+
+    fmi3Float64 tolerance;
+    size_t maxIterations;
+
+    fmi3Float64 *zLeft;
+    fmi3Float64 *zRight;
+    fmi3Float64 *zMid;
+
+    EventLocatorStatistics statistics;
+};
+
+/* Only a strict change of sign counts, so that the indicators are never zero at a located event. */
+static bool isCrossing(fmi3Float64 zLeft, fmi3Float64 zRight) {
+    return zLeft * zRight < 0.0;
+}
+
+static bool anyCrossing(const EventLocator *locator, const fmi3Float64 zLeft[], const fmi3Float64 zRight[]) {
+
+    for (size_t i = 0; i < locator->nz; i++) {
+        if (isCrossing(zLeft[i], zRight[i])) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/* Earliest secant estimate over all crossing indicators. The weights implement the Illinois modification. */
+static fmi3Float64 secantEstimate(const EventLocator *locator, fmi3Float64 tLeft, fmi3Float64 tRight, fmi3Float64 wLeft, fmi3Float64 wRight) {
+
+    fmi3Float64 tEstimate = tRight;
+
+    for (size_t i = 0; i < locator->nz; i++) {
+
+        if (!isCrossing(locator->zLeft[i], locator->zRight[i])) {
+            continue;
+        }
+
+        const fmi3Float64 zl = wLeft  * locator->zLeft[i];
+        const fmi3Float64 zr = wRight * locator->zRight[i];
+
+        const fmi3Float64 t = (tLeft * zr - tRight * zl) / (zr - zl);
+
+        if (t < tEstimate) {
+            tEstimate = t;
+        }
+    }
+
+    return tEstimate;
+}
+
+EventLocator* EventLocatorCreate(size_t nEventIndicators, fmi3Float64 tolerance, size_t maxIterations) {
+
+    EventLocator *locator = (EventLocator*)calloc(1, sizeof(EventLocator));
+
+    if (!locator) {
+        return NULL;
+    }
+
+    locator->nz            = nEventIndicators;
+    locator->tolerance     = tolerance;
+    locator->maxIterations = maxIterations;
+    locator->zLeft         = (fmi3Float64*)calloc(nEventIndicators + 1, sizeof(fmi3Float64));
+    locator->zRight        = (fmi3Float64*)calloc(nEventIndicators + 1, sizeof(fmi3Float64));
+    locator->zMid          = (fmi3Float64*)calloc(nEventIndicators + 1, sizeof(fmi3Float64));
+
+    if (!locator->zLeft || !locator->zRight || !locator->zMid) {
+        EventLocatorFree(locator);
+        return NULL;
+    }
+
+    return locator;
+}
+
+void EventLocatorFree(EventLocator *locator) {
+
+    if (!locator) {
+        return;
+    }
+
+    free(locator->zLeft);
+    free(locator->zRight);
+    free(locator->zMid);
+    free(locator);
+}
+
+bool EventLocatorCrossed(const EventLocator *locator, const fmi3Float64 zLeft[], const fmi3Float64 zRight[]) {
+    return anyCrossing(locator, zLeft, zRight);
+}
+
+FMIStatus EventLocatorFind(EventLocator *locator, EventIndicatorFunction *function, void *context,
+    fmi3Float64 tLeft, const fmi3Float64 zLeft[],
+    fmi3Float64 tRight, const fmi3Float64 zRight[],
+    fmi3Float64 *tEvent, fmi3Float64 zEvent[]) {
+
+    FMIStatus status = FMIOK;
+
+    const size_t size = locator->nz * sizeof(fmi3Float64);
+
+    // zEvent may alias zLeft or zRight
+    memcpy(locator->zLeft, zLeft, size);
+    memcpy(locator->zRight, zRight, size);
+
+    fmi3Float64 wLeft = 1.0;
+    fmi3Float64 wRight = 1.0;
+    BracketSide retained = SideNone;
+
+    for (size_t i = 0; i < locator->maxIterations && tRight - tLeft > locator->tolerance; i++) {
+
+        fmi3Float64 tMid = secantEstimate(locator, tLeft, tRight, wLeft, wRight);
+
+        // Keep the estimate away from the ends of the bracket, so that it shrinks by at least the tolerance
+        const fmi3Float64 margin = 0.5 * locator->tolerance;
+        tMid = fmax(tLeft + margin, fmin(tRight - margin, tMid));
+
+        CALL(function(context, tMid, locator->zMid));
+        locator->statistics.nEvaluations++;
+
+        if (anyCrossing(locator, locator->zLeft, locator->zMid)) {
+            // The crossing lies in [tLeft, tMid]
+            tRight = tMid;
+            memcpy(locator->zRight, locator->zMid, size);
+            wRight = 1.0;
+            if (retained == SideLeft) {
+                wLeft *= 0.5;
+            }
+            retained = SideLeft;
+        } else {
+            // The crossing lies in [tMid, tRight]
+            // An indicator that is exactly zero keeps its previous sign
+            tLeft = tMid;
+            for (size_t j = 0; j < locator->nz; j++) {
+                if (locator->zMid[j] != 0.0) {
+                    locator->zLeft[j] = locator->zMid[j];
+                }
+            }
+            wLeft = 1.0;
+            if (retained == SideRight) {
+                wRight *= 0.5;
+            }
+            retained = SideRight;
+        }
+    }
+
+    *tEvent = tRight;
+    memcpy(zEvent, locator->zRight, size);
+
+    locator->statistics.nEvents++;
+
+TERMINATE:
+    return status;
+}
+
+const EventLocatorStatistics* EventLocatorGetStatistics(const EventLocator *locator) {
+    return &locator->statistics;
+}
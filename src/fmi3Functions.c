@@ -13,12 +13,12 @@ const char* fmi3GetVersion(void) {
     return fmi3Version;
 }
 
-fmi3Status fmi3SetDebugLogging(fmi3Instance instance,
-    fmi3Boolean loggingOn,
-    size_t nCategories,
-    const fmi3String categories[]) {
-    return fmi3OK;
-}
+// fmi3Status fmi3SetDebugLogging(fmi3Instance instance,
+//     fmi3Boolean loggingOn,
+//     size_t nCategories,
+//     const fmi3String categories[]) {
+//     return fmi3OK;
+// }
 
 /* Creation and destruction of FMU instances and setting debug status */
 // fmi3Instance fmi3InstantiateModelExchange(
@@ -48,19 +48,19 @@ fmi3Status fmi3SetDebugLogging(fmi3Instance instance,
 //     return (fmi3Instance)NULL;
 // }
 
-fmi3Instance fmi3InstantiateScheduledExecution(
-    fmi3String                     instanceName,
-    fmi3String                     instantiationToken,
-    fmi3String                     resourcePath,
-    fmi3Boolean                    visible,
-    fmi3Boolean                    loggingOn,
-    fmi3InstanceEnvironment        instanceEnvironment,
-    fmi3LogMessageCallback         logMessage,
-    fmi3ClockUpdateCallback        clockUpdate,
-    fmi3LockPreemptionCallback     lockPreemption,
-    fmi3UnlockPreemptionCallback   unlockPreemption) {
-    return (fmi3Instance)NULL;
-}
+// fmi3Instance fmi3InstantiateScheduledExecution(
+//     fmi3String                     instanceName,
+//     fmi3String                     instantiationToken,
+//     fmi3String                     resourcePath,
+//     fmi3Boolean                    visible,
+//     fmi3Boolean                    loggingOn,
+//     fmi3InstanceEnvironment        instanceEnvironment,
+//     fmi3LogMessageCallback         logMessage,
+//     fmi3ClockUpdateCallback        clockUpdate,
+//     fmi3LockPreemptionCallback     lockPreemption,
+//     fmi3UnlockPreemptionCallback   unlockPreemption) {
+//     return (fmi3Instance)NULL;
+// }
 
 /* Enter and exit initialization mode, enter event mode, terminate and reset */
 // fmi3Status fmi3EnterInitializationMode(fmi3Instance instance,
@@ -323,56 +323,56 @@ fmi3Status fmi3GetVariableDependencies(fmi3Instance instance,
 }
 
 /* Getting and setting the internal FMU state */
-fmi3Status fmi3GetFMUState(fmi3Instance instance, fmi3FMUState* FMUState) { NOT_IMPLEMENTED; }
+// fmi3Status fmi3GetFMUState(fmi3Instance instance, fmi3FMUState* FMUState) { NOT_IMPLEMENTED; }
 
-fmi3Status fmi3SetFMUState(fmi3Instance instance, fmi3FMUState  FMUState) { NOT_IMPLEMENTED; }
+// fmi3Status fmi3SetFMUState(fmi3Instance instance, fmi3FMUState  FMUState) { NOT_IMPLEMENTED; }
 
-fmi3Status fmi3FreeFMUState(fmi3Instance instance, fmi3FMUState* FMUState) { NOT_IMPLEMENTED; }
+// fmi3Status fmi3FreeFMUState(fmi3Instance instance, fmi3FMUState* FMUState) { NOT_IMPLEMENTED; }
 
-fmi3Status fmi3SerializedFMUStateSize(fmi3Instance instance,
-    fmi3FMUState FMUState,
-    size_t* size) {
-    NOT_IMPLEMENTED;
-}
+// fmi3Status fmi3SerializedFMUStateSize(fmi3Instance instance,
+//     fmi3FMUState FMUState,
+//     size_t* size) {
+//     NOT_IMPLEMENTED;
+// }
 
-fmi3Status fmi3SerializeFMUState(fmi3Instance instance,
-    fmi3FMUState FMUState,
-    fmi3Byte serializedState[],
-    size_t size) {
-    NOT_IMPLEMENTED;
-}
+// fmi3Status fmi3SerializeFMUState(fmi3Instance instance,
+//     fmi3FMUState FMUState,
+//     fmi3Byte serializedState[],
+//     size_t size) {
+//     NOT_IMPLEMENTED;
+// }
 
-fmi3Status fmi3DeserializeFMUState(fmi3Instance instance,
-    const fmi3Byte serializedState[],
-    size_t size,
-    fmi3FMUState* FMUState) {
-    NOT_IMPLEMENTED;
-}
+// fmi3Status fmi3DeserializeFMUState(fmi3Instance instance,
+//     const fmi3Byte serializedState[],
+//     size_t size,
+//     fmi3FMUState* FMUState) {
+//     NOT_IMPLEMENTED;
+// }
 
 /* Getting partial derivatives */
-fmi3Status fmi3GetDirectionalDerivative(fmi3Instance instance,
-    const fmi3ValueReference unknowns[],
-    size_t nUnknowns,
-    const fmi3ValueReference knowns[],
-    size_t nKnowns,
-    const fmi3Float64 seed[],
-    size_t nSeed,
-    fmi3Float64 sensitivity[],
-    size_t nSensitivity) {
-    NOT_IMPLEMENTED;
-}
-
-fmi3Status fmi3GetAdjointDerivative(fmi3Instance instance,
-    const fmi3ValueReference unknowns[],
-    size_t nUnknowns,
-    const fmi3ValueReference knowns[],
-    size_t nKnowns,
-    const fmi3Float64 seed[],
-    size_t nSeed,
-    fmi3Float64 sensitivity[],
-    size_t nSensitivity) {
-    NOT_IMPLEMENTED;
-}
+// fmi3Status fmi3GetDirectionalDerivative(fmi3Instance instance,
+//     const fmi3ValueReference unknowns[],
+//     size_t nUnknowns,
+//     const fmi3ValueReference knowns[],
+//     size_t nKnowns,
+//     const fmi3Float64 seed[],
+//     size_t nSeed,
+//     fmi3Float64 sensitivity[],
+//     size_t nSensitivity) {
+//     NOT_IMPLEMENTED;
+// }
+//
+// fmi3Status fmi3GetAdjointDerivative(fmi3Instance instance,
+//     const fmi3ValueReference unknowns[],
+//     size_t nUnknowns,
+//     const fmi3ValueReference knowns[],
+//     size_t nKnowns,
+//     const fmi3Float64 seed[],
+//     size_t nSeed,
+//     fmi3Float64 sensitivity[],
+//     size_t nSensitivity) {
+//     NOT_IMPLEMENTED;
+// }
 
 /* Entering and exiting the Configuration or Reconfiguration Mode */
 
@@ -516,14 +516,14 @@ Types for Functions for Co-Simulation
 
 // fmi3Status fmi3EnterStepMode(fmi3Instance instance) { NOT_IMPLEMENTED; }
 
-fmi3Status fmi3GetOutputDerivatives(fmi3Instance instance,
-    const fmi3ValueReference valueReferences[],
-    size_t nValueReferences,
-    const fmi3Int32 orders[],
-    fmi3Float64 values[],
-    size_t nValues) {
-    NOT_IMPLEMENTED;
-}
+// fmi3Status fmi3GetOutputDerivatives(fmi3Instance instance,
+//     const fmi3ValueReference valueReferences[],
+//     size_t nValueReferences,
+//     const fmi3Int32 orders[],
+//     fmi3Float64 values[],
+//     size_t nValues) {
+//     NOT_IMPLEMENTED;
+// }
 
 // fmi3Status fmi3DoStep(fmi3Instance instance,
 //    fmi3Float64 currentCommunicationPoint,
@@ -540,9 +540,9 @@ fmi3Status fmi3GetOutputDerivatives(fmi3Instance instance,
 Types for Functions for Scheduled Execution
 ****************************************************/
 
-fmi3Status fmi3ActivateModelPartition(fmi3Instance instance,
-    fmi3ValueReference clockReference,
-    fmi3Float64 activationTime) {
-    NOT_IMPLEMENTED;
-}
+// fmi3Status fmi3ActivateModelPartition(fmi3Instance instance,
+//     fmi3ValueReference clockReference,
+//     fmi3Float64 activationTime) {
+//     NOT_IMPLEMENTED;
+// }
 
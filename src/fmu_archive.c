@@ -0,0 +1,908 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <direct.h>
+#include <process.h>
+#define MAKE_DIRECTORY(path) _mkdir(path)
+#define PROCESS_ID()         _getpid()
+#define FULL_PATH(path)      _fullpath(NULL, path, 0)
+#define SEPARATOR            '\\'
+#else
+#include <dirent.h>
+#include <unistd.h>
+#define MAKE_DIRECTORY(path) mkdir(path, 0755)
+#define PROCESS_ID()         getpid()
+#define FULL_PATH(path)      realpath(path, NULL)
+#define SEPARATOR            '/'
+#endif
+
+#include "fmu_archive.h"
+
+#define MAX_PATH_LENGTH 1024
+
+// Signatures of the zip records
+#define LOCAL_FILE_HEADER_SIGNATURE     0x04034b50
+#define CENTRAL_DIRECTORY_SIGNATURE     0x02014b50
+#define END_OF_CENTRAL_DIRECTORY_SIGNATURE 0x06054b50
+
+#define END_OF_CENTRAL_DIRECTORY_SIZE 22
+#define MAX_COMMENT_SIZE 0xFFFF
+
+#define METHOD_STORED   0
+#define METHOD_DEFLATED 8
+
+// Host of the external file attributes that are Unix file modes
+#define HOST_UNIX 3
+
+static uint16_t read16(const uint8_t *p) {
+    return (uint16_t)(p[0] | p[1] << 8);
+}
+
+static uint32_t read32(const uint8_t *p) {
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+static uint64_t hashContent(const uint8_t *data, size_t size) {
+
+    uint64_t hash = 14695981039346656037ULL;
+
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ data[i]) * 1099511628211ULL;
+    }
+
+    return hash;
+}
+
+static uint32_t crc32(const uint8_t *data, size_t size) {
+
+    uint32_t table[256];
+
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t c = i;
+        for (int k = 0; k < 8; k++) {
+            c = c & 1 ? 0xEDB88320U ^ (c >> 1) : c >> 1;
+        }
+        table[i] = c;
+    }
+
+    uint32_t crc = 0xFFFFFFFFU;
+
+    for (size_t i = 0; i < size; i++) {
+        crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    }
+
+    return crc ^ 0xFFFFFFFFU;
+}
+
+//****************** Inflate (RFC 1951) ******************//
+
+#define MAX_BITS 15
+#define MAX_LITERAL_LENGTH_CODES 288
+#define MAX_DISTANCE_CODES 30
+
+typedef struct {
+    const uint8_t *input;
+    size_t inputSize;
+    size_t inputPosition;
+    uint32_t bitBuffer;
+    int nBits;
+    uint8_t *output;
+    size_t outputSize;
+    size_t outputPosition;
+    bool error;
+} Inflater;
+
+// Canonical Huffman code as the number of codes per length and the symbols ordered by code
+typedef struct {
+    uint16_t count[MAX_BITS + 1];
+    uint16_t symbol[MAX_LITERAL_LENGTH_CODES];
+} Huffman;
+
+static uint32_t readBits(Inflater *s, int n) {
+
+    while (s->nBits < n) {
+        if (s->inputPosition == s->inputSize) {
+            s->error = true;
+            return 0;
+        }
+        s->bitBuffer |= (uint32_t)s->input[s->inputPosition++] << s->nBits;
+        s->nBits += 8;
+    }
+
+    const uint32_t value = s->bitBuffer & ((1U << n) - 1);
+
+    s->bitBuffer >>= n;
+    s->nBits -= n;
+
+    return value;
+}
+
+/* Builds the code from the code lengths. Returns false for over-subscribed codes, incomplete ones are allowed. */
+static bool buildHuffman(Huffman *h, const uint8_t lengths[], size_t n) {
+
+    uint16_t offsets[MAX_BITS + 1];
+
+    memset(h->count, 0, sizeof(h->count));
+
+    for (size_t i = 0; i < n; i++) {
+        h->count[lengths[i]]++;
+    }
+
+    int left = 1;
+
+    for (int length = 1; length <= MAX_BITS; length++) {
+        left = (left << 1) - h->count[length];
+        if (left < 0) {
+            return false;
+        }
+    }
+
+    offsets[1] = 0;
+
+    for (int length = 1; length < MAX_BITS; length++) {
+        offsets[length + 1] = offsets[length] + h->count[length];
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        if (lengths[i] != 0) {
+            h->symbol[offsets[lengths[i]]++] = (uint16_t)i;
+        }
+    }
+
+    return true;
+}
+
+/* Returns the next symbol or -1 for an invalid code. */
+static int decodeSymbol(Inflater *s, const Huffman *h) {
+
+    int code = 0;   // of length bits
+    int first = 0;  // first code of length bits
+    int index = 0;  // of the first code of length bits in h->symbol
+
+    for (int length = 1; length <= MAX_BITS; length++) {
+
+        code |= (int)readBits(s, 1);
+
+        if (s->error) {
+            return -1;
+        }
+
+        const int count = h->count[length];
+
+        if (code - count < first) {
+            return h->symbol[index + (code - first)];
+        }
+
+        index += count;
+        first += count;
+        first <<= 1;
+        code <<= 1;
+    }
+
+    return -1;
+}
+
+static bool inflateStored(Inflater *s) {
+
+    // the length is byte aligned
+    s->bitBuffer = 0;
+    s->nBits = 0;
+
+    if (s->inputSize - s->inputPosition < 4) {
+        return false;
+    }
+
+    const uint16_t length = read16(&s->input[s->inputPosition]);
+    const uint16_t complement = read16(&s->input[s->inputPosition + 2]);
+
+    s->inputPosition += 4;
+
+    if ((uint16_t)(length ^ complement) != 0xFFFF ||
+        s->inputSize - s->inputPosition < length ||
+        s->outputSize - s->outputPosition < length) {
+        return false;
+    }
+
+    memcpy(&s->output[s->outputPosition], &s->input[s->inputPosition], length);
+
+    s->inputPosition += length;
+    s->outputPosition += length;
+
+    return true;
+}
+
+static bool inflateCodes(Inflater *s, const Huffman *literalLengths, const Huffman *distances) {
+
+    static const uint16_t lengthBase[29] = {
+        3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+    static const uint8_t lengthExtra[29] = {
+        0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+    static const uint16_t distanceBase[30] = {
+        1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145,
+        8193, 12289, 16385, 24577 };
+    static const uint8_t distanceExtra[30] = {
+        0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+    for (;;) {
+
+        int symbol = decodeSymbol(s, literalLengths);
+
+        if (symbol < 0) {
+            return false;
+        }
+
+        if (symbol < 256) {
+
+            if (s->outputPosition == s->outputSize) {
+                return false;
+            }
+
+            s->output[s->outputPosition++] = (uint8_t)symbol;
+
+        } else if (symbol == 256) {
+
+            return true;
+
+        } else {
+
+            symbol -= 257;
+
+            if (symbol >= 29) {
+                return false;
+            }
+
+            const size_t length = lengthBase[symbol] + readBits(s, lengthExtra[symbol]);
+
+            symbol = decodeSymbol(s, distances);
+
+            if (symbol < 0 || symbol >= MAX_DISTANCE_CODES) {
+                return false;
+            }
+
+            const size_t distance = distanceBase[symbol] + readBits(s, distanceExtra[symbol]);
+
+            if (s->error || distance > s->outputPosition || s->outputSize - s->outputPosition < length) {
+                return false;
+            }
+
+            // the copy may overlap
+            for (size_t i = 0; i < length; i++) {
+                s->output[s->outputPosition] = s->output[s->outputPosition - distance];
+                s->outputPosition++;
+            }
+        }
+    }
+}
+
+static bool inflateFixed(Inflater *s) {
+
+    uint8_t lengths[MAX_LITERAL_LENGTH_CODES];
+    Huffman literalLengths, distances;
+
+    size_t i = 0;
+
+    for (; i < 144; i++) lengths[i] = 8;
+    for (; i < 256; i++) lengths[i] = 9;
+    for (; i < 280; i++) lengths[i] = 7;
+    for (; i < MAX_LITERAL_LENGTH_CODES; i++) lengths[i] = 8;
+
+    buildHuffman(&literalLengths, lengths, MAX_LITERAL_LENGTH_CODES);
+
+    for (i = 0; i < MAX_DISTANCE_CODES; i++) lengths[i] = 5;
+
+    buildHuffman(&distances, lengths, MAX_DISTANCE_CODES);
+
+    return inflateCodes(s, &literalLengths, &distances);
+}
+
+static bool inflateDynamic(Inflater *s) {
+
+    // order of the code length code lengths
+    static const uint8_t order[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+
+    uint8_t lengths[MAX_LITERAL_LENGTH_CODES + MAX_DISTANCE_CODES];
+    Huffman codeLengths, literalLengths, distances;
+
+    const size_t nLiteralLengths = readBits(s, 5) + 257;
+    const size_t nDistances = readBits(s, 5) + 1;
+    const size_t nCodeLengths = readBits(s, 4) + 4;
+
+    if (s->error || nLiteralLengths > MAX_LITERAL_LENGTH_CODES || nDistances > MAX_DISTANCE_CODES) {
+        return false;
+    }
+
+    memset(lengths, 0, sizeof(lengths));
+
+    for (size_t i = 0; i < nCodeLengths; i++) {
+        lengths[order[i]] = (uint8_t)readBits(s, 3);
+    }
+
+    if (s->error || !buildHuffman(&codeLengths, lengths, 19)) {
+        return false;
+    }
+
+    size_t i = 0;
+
+    while (i < nLiteralLengths + nDistances) {
+
+        const int symbol = decodeSymbol(s, &codeLengths);
+
+        if (symbol < 0) {
+            return false;
+        }
+
+        if (symbol < 16) {
+            lengths[i++] = (uint8_t)symbol;
+            continue;
+        }
+
+        uint8_t length = 0;
+        size_t repeat;
+
+        if (symbol == 16) {
+            if (i == 0) {
+                return false;
+            }
+            length = lengths[i - 1];
+            repeat = 3 + readBits(s, 2);
+        } else if (symbol == 17) {
+            repeat = 3 + readBits(s, 3);
+        } else {
+            repeat = 11 + readBits(s, 7);
+        }
+
+        if (s->error || i + repeat > nLiteralLengths + nDistances) {
+            return false;
+        }
+
+        while (repeat--) {
+            lengths[i++] = length;
+        }
+    }
+
+    // the end of block code is required
+    if (lengths[256] == 0) {
+        return false;
+    }
+
+    if (!buildHuffman(&literalLengths, lengths, nLiteralLengths) ||
+        !buildHuffman(&distances, &lengths[nLiteralLengths], nDistances)) {
+        return false;
+    }
+
+    return inflateCodes(s, &literalLengths, &distances);
+}
+
+/* Inflates the raw deflate stream, which must decompress to exactly outputSize bytes. */
+static bool inflate(const uint8_t *input, size_t inputSize, uint8_t *output, size_t outputSize) {
+
+    Inflater s;
+
+    memset(&s, 0, sizeof(s));
+
+    s.input = input;
+    s.inputSize = inputSize;
+    s.output = output;
+    s.outputSize = outputSize;
+
+    bool last;
+
+    do {
+
+        last = readBits(&s, 1);
+
+        const uint32_t type = readBits(&s, 2);
+
+        bool success;
+
+        if (s.error) {
+            return false;
+        }
+
+        switch (type) {
+        case 0:
+            success = inflateStored(&s);
+            break;
+        case 1:
+            success = inflateFixed(&s);
+            break;
+        case 2:
+            success = inflateDynamic(&s);
+            break;
+        default:
+            success = false;
+            break;
+        }
+
+        if (!success || s.error) {
+            return false;
+        }
+
+    } while (!last);
+
+    return s.outputPosition == outputSize;
+}
+
+//****************** Files and directories ******************//
+
+static uint8_t* readArchive(const char *path, size_t *size) {
+
+    FILE *file = fopen(path, "rb");
+
+    if (!file) {
+        return NULL;
+    }
+
+    fseek(file, 0, SEEK_END);
+    const long length = ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    uint8_t *buffer = length > 0 ? (uint8_t*)malloc((size_t)length) : NULL;
+
+    if (buffer && fread(buffer, 1, (size_t)length, file) != (size_t)length) {
+        free(buffer);
+        buffer = NULL;
+    }
+
+    fclose(file);
+
+    *size = (size_t)length;
+
+    return buffer;
+}
+
+static bool isDirectory(const char *path) {
+    struct stat status;
+    return !stat(path, &status) && (status.st_mode & S_IFMT) == S_IFDIR;
+}
+
+/* Creates the directory and its parents. */
+static bool makeDirectories(const char *path) {
+
+    char buffer[MAX_PATH_LENGTH];
+
+    if (strlen(path) >= sizeof(buffer)) {
+        return false;
+    }
+
+    strcpy(buffer, path);
+
+    for (char *p = buffer + 1; *p; p++) {
+        if (*p == '/' || *p == '\\') {
+            const char c = *p;
+            *p = '\0';
+            if (!isDirectory(buffer)) {
+                MAKE_DIRECTORY(buffer);
+            }
+            *p = c;
+        }
+    }
+
+    if (!isDirectory(buffer)) {
+        MAKE_DIRECTORY(buffer);
+    }
+
+    return isDirectory(buffer);
+}
+
+/* Removes the directory and its content, e.g. an extraction that lost the race against another process. */
+static void removeDirectory(const char *path) {
+
+    char child[MAX_PATH_LENGTH];
+
+#ifdef _WIN32
+    WIN32_FIND_DATAA entry;
+
+    snprintf(child, sizeof(child), "%s\\*", path);
+
+    HANDLE find = FindFirstFileA(child, &entry);
+
+    if (find != INVALID_HANDLE_VALUE) {
+        do {
+            if (!strcmp(entry.cFileName, ".") || !strcmp(entry.cFileName, "..")) {
+                continue;
+            }
+            snprintf(child, sizeof(child), "%s\\%s", path, entry.cFileName);
+            if (entry.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) {
+                removeDirectory(child);
+            } else {
+                DeleteFileA(child);
+            }
+        } while (FindNextFileA(find, &entry));
+        FindClose(find);
+    }
+
+    RemoveDirectoryA(path);
+#else
+    DIR *directory = opendir(path);
+
+    if (directory) {
+        for (struct dirent *entry = readdir(directory); entry; entry = readdir(directory)) {
+            if (!strcmp(entry->d_name, ".") || !strcmp(entry->d_name, "..")) {
+                continue;
+            }
+            snprintf(child, sizeof(child), "%s/%s", path, entry->d_name);
+            if (isDirectory(child)) {
+                removeDirectory(child);
+            } else {
+                unlink(child);
+            }
+        }
+        closedir(directory);
+    }
+
+    rmdir(path);
+#endif
+}
+
+/* Rejects absolute paths and paths that leave the directory. */
+static bool isSafeEntryName(const char *name) {
+
+    if (name[0] == '\0' || name[0] == '/' || name[0] == '\\' || strchr(name, ':')) {
+        return false;
+    }
+
+    for (const char *p = name; *p; ) {
+
+        const size_t length = strcspn(p, "/\\");
+
+        if (length == 2 && p[0] == '.' && p[1] == '.') {
+            return false;
+        }
+
+        p += length;
+
+        if (*p) {
+            p++;
+        }
+    }
+
+    return true;
+}
+
+//****************** Zip archives ******************//
+
+static bool extractEntry(const uint8_t *archive, size_t archiveSize, const uint8_t *header, const char *directory) {
+
+    const uint16_t versionMadeBy  = read16(&header[4]);
+    const uint16_t flags          = read16(&header[8]);
+    const uint16_t method         = read16(&header[10]);
+    const uint32_t crc            = read32(&header[16]);
+    const uint32_t compressedSize = read32(&header[20]);
+    const uint32_t size           = read32(&header[24]);
+    const uint16_t nameLength     = read16(&header[28]);
+    const uint32_t attributes     = read32(&header[38]);
+    const uint32_t offset         = read32(&header[42]);
+
+    char name[MAX_PATH_LENGTH];
+    char path[MAX_PATH_LENGTH];
+
+    // encrypted entries and ZIP64 are not supported
+    if ((flags & 1) || compressedSize == 0xFFFFFFFFU || size == 0xFFFFFFFFU || offset == 0xFFFFFFFFU ||
+        nameLength >= sizeof(name)) {
+        return false;
+    }
+
+    memcpy(name, &header[46], nameLength);
+    name[nameLength] = '\0';
+
+    if (!isSafeEntryName(name)) {
+        return false;
+    }
+
+    if (snprintf(path, sizeof(path), "%s%c%s", directory, SEPARATOR, name) >= (int)sizeof(path)) {
+        return false;
+    }
+
+    if (name[nameLength - 1] == '/') {
+        return makeDirectories(path);
+    }
+
+    // the parent directory, not all archivers store the directories
+    char *lastSeparator = strrchr(path, '/');
+
+    if (lastSeparator > path + strlen(directory)) {
+        *lastSeparator = '\0';
+        const bool created = makeDirectories(path);
+        *lastSeparator = '/';
+        if (!created) {
+            return false;
+        }
+    }
+
+    if (archiveSize < 30 || offset > archiveSize - 30 || read32(&archive[offset]) != LOCAL_FILE_HEADER_SIGNATURE) {
+        return false;
+    }
+
+    const size_t dataOffset = (size_t)offset + 30 + read16(&archive[offset + 26]) + read16(&archive[offset + 28]);
+
+    if (dataOffset > archiveSize || archiveSize - dataOffset < compressedSize) {
+        return false;
+    }
+
+    const uint8_t *data = &archive[dataOffset];
+    uint8_t *content = (uint8_t*)malloc(size > 0 ? size : 1);
+
+    if (!content) {
+        return false;
+    }
+
+    bool success;
+
+    if (method == METHOD_STORED) {
+        success = compressedSize == size;
+        if (success) {
+            memcpy(content, data, size);
+        }
+    } else if (method == METHOD_DEFLATED) {
+        success = inflate(data, compressedSize, content, size);
+    } else {
+        success = false;
+    }
+
+    success = success && crc32(content, size) == crc;
+
+    if (success) {
+
+        FILE *file = fopen(path, "wb");
+
+        success = file && fwrite(content, 1, size, file) == size;
+
+        if (file) {
+            success = !fclose(file) && success;
+        }
+    }
+
+    free(content);
+
+#ifndef _WIN32
+    // e.g. the permissions of the shared libraries
+    const mode_t mode = (mode_t)(attributes >> 16) & 0777;
+
+    if (success && versionMadeBy >> 8 == HOST_UNIX && mode != 0) {
+        chmod(path, mode);
+    }
+#else
+    (void)versionMadeBy;
+    (void)attributes;
+#endif
+
+    return success;
+}
+
+static bool extractArchive(const uint8_t *archive, size_t size, const char *directory) {
+
+    if (size < END_OF_CENTRAL_DIRECTORY_SIZE) {
+        return false;
+    }
+
+    // the end of central directory record is followed by a comment of up to 64 KB
+    const size_t last = size - END_OF_CENTRAL_DIRECTORY_SIZE;
+    const size_t first = last > MAX_COMMENT_SIZE ? last - MAX_COMMENT_SIZE : 0;
+
+    const uint8_t *end = NULL;
+
+    for (size_t i = last + 1; i-- > first; ) {
+        if (read32(&archive[i]) == END_OF_CENTRAL_DIRECTORY_SIGNATURE) {
+            end = &archive[i];
+            break;
+        }
+    }
+
+    if (!end) {
+        return false;
+    }
+
+    const uint16_t nEntries = read16(&end[10]);
+    const uint32_t directorySize = read32(&end[12]);
+    const uint32_t directoryOffset = read32(&end[16]);
+
+    if (directoryOffset > size || size - directoryOffset < directorySize) {
+        return false;
+    }
+
+    const uint8_t *header = &archive[directoryOffset];
+    const uint8_t *directoryEnd = header + directorySize;
+
+    for (uint16_t i = 0; i < nEntries; i++) {
+
+        if (directoryEnd - header < 46 || read32(header) != CENTRAL_DIRECTORY_SIGNATURE) {
+            return false;
+        }
+
+        const size_t headerSize = 46 + (size_t)read16(&header[28]) + read16(&header[30]) + read16(&header[32]);
+
+        if ((size_t)(directoryEnd - header) < headerSize || !extractEntry(archive, size, header, directory)) {
+            return false;
+        }
+
+        header += headerSize;
+    }
+
+    return true;
+}
+
+//****************** Cache ******************//
+
+typedef struct {
+    unsigned long long size;
+    unsigned long long modificationTime;  // in the finest unit of the file system
+} FileStamp;
+
+/* Gets the size and the modification time of a file at the full precision of the file system. */
+static bool getFileStamp(const char *path, FileStamp *stamp) {
+#ifdef _WIN32
+    WIN32_FILE_ATTRIBUTE_DATA data;
+
+    if (!GetFileAttributesExA(path, GetFileExInfoStandard, &data)) {
+        return false;
+    }
+
+    stamp->size = (unsigned long long)data.nFileSizeHigh << 32 | data.nFileSizeLow;
+    stamp->modificationTime = (unsigned long long)data.ftLastWriteTime.dwHighDateTime << 32 | data.ftLastWriteTime.dwLowDateTime;
+#else
+    struct stat status;
+
+    if (stat(path, &status)) {
+        return false;
+    }
+
+    stamp->size = (unsigned long long)status.st_size;
+#ifdef __APPLE__
+    stamp->modificationTime = (unsigned long long)status.st_mtimespec.tv_sec * 1000000000ULL + (unsigned long long)status.st_mtimespec.tv_nsec;
+#else
+    stamp->modificationTime = (unsigned long long)status.st_mtim.tv_sec * 1000000000ULL + (unsigned long long)status.st_mtim.tv_nsec;
+#endif
+#endif
+    return true;
+}
+
+/* Reads the hash of the archive from the index if it has been written for the same
+   path and the size and modification time have not changed. */
+static bool readIndex(const char *indexPath, const char *archivePath, const FileStamp *stamp, uint64_t *hash) {
+
+    FILE *file = fopen(indexPath, "r");
+
+    if (!file) {
+        return false;
+    }
+
+    unsigned long long size, modificationTime, value;
+    char path[MAX_PATH_LENGTH];
+
+    bool match = fscanf(file, "%llu %llu %llx ", &size, &modificationTime, &value) == 3 &&
+        size == stamp->size &&
+        modificationTime == stamp->modificationTime &&
+        fgets(path, sizeof(path), file);
+
+    fclose(file);
+
+    if (match) {
+        path[strcspn(path, "\r\n")] = '\0';
+        match = !strcmp(path, archivePath);
+    }
+
+    if (match) {
+        *hash = value;
+    }
+
+    return match;
+}
+
+static void writeIndex(const char *indexPath, const char *archivePath, const FileStamp *stamp, uint64_t hash) {
+
+    FILE *file = fopen(indexPath, "w");
+
+    if (file) {
+        fprintf(file, "%llu %llu %016llx\n%s\n", stamp->size, stamp->modificationTime, (unsigned long long)hash, archivePath);
+        fclose(file);
+    }
+}
+
+FMIStatus FMUArchiveExtract(const char *archivePath, const char *cacheDirectory, char *unzipdir, size_t size) {
+
+    FileStamp stamp;
+    char stem[MAX_PATH_LENGTH];
+    char fullPath[MAX_PATH_LENGTH];
+    char indexPath[MAX_PATH_LENGTH];
+    char temporaryDirectory[MAX_PATH_LENGTH];
+    uint64_t hash;
+
+    if (!getFileStamp(archivePath, &stamp) || !makeDirectories(cacheDirectory)) {
+        return FMIError;
+    }
+
+    // the file name of the archive without the extension, e.g. "Plant" for "../fmus/Plant.fmu"
+    const char *slash = strrchr(archivePath, '/');
+    const char *backslash = strrchr(archivePath, '\\');
+    const char *basename = slash > backslash ? slash + 1 : backslash ? backslash + 1 : archivePath;
+
+    strncpy(stem, basename, sizeof(stem) - 1);
+    stem[sizeof(stem) - 1] = '\0';
+
+    char *extension = strrchr(stem, '.');
+
+    if (extension && extension != stem) {
+        *extension = '\0';
+    }
+
+    // archives of the same name in different directories have their own index
+    char *canonicalPath = FULL_PATH(archivePath);
+
+    if (!canonicalPath) {
+        return FMIError;
+    }
+
+    const int length = snprintf(fullPath, sizeof(fullPath), "%s", canonicalPath);
+
+    free(canonicalPath);
+
+    const uint64_t pathHash = hashContent((const uint8_t*)fullPath, strlen(fullPath));
+
+    if (length >= (int)sizeof(fullPath) ||
+        snprintf(indexPath, sizeof(indexPath), "%s%c%s-%016llx.index", cacheDirectory, SEPARATOR, stem, (unsigned long long)pathHash) >= (int)sizeof(indexPath)) {
+        return FMIError;
+    }
+
+    // unchanged since the last run
+    if (readIndex(indexPath, fullPath, &stamp, &hash)) {
+
+        if (snprintf(unzipdir, size, "%s%c%s-%016llx", cacheDirectory, SEPARATOR, stem, (unsigned long long)hash) < (int)size &&
+            isDirectory(unzipdir)) {
+            return FMIOK;
+        }
+    }
+
+    size_t archiveSize;
+    uint8_t *archive = readArchive(archivePath, &archiveSize);
+
+    if (!archive) {
+        return FMIError;
+    }
+
+    hash = hashContent(archive, archiveSize);
+
+    if (snprintf(unzipdir, size, "%s%c%s-%016llx", cacheDirectory, SEPARATOR, stem, (unsigned long long)hash) >= (int)size ||
+        snprintf(temporaryDirectory, sizeof(temporaryDirectory), "%s.%d.tmp", unzipdir, (int)PROCESS_ID()) >= (int)sizeof(temporaryDirectory)) {
+        free(archive);
+        return FMIError;
+    }
+
+    // the same content has been extracted before, e.g. from a copy of the archive
+    if (isDirectory(unzipdir)) {
+        free(archive);
+        writeIndex(indexPath, fullPath, &stamp, hash);
+        return FMIOK;
+    }
+
+    removeDirectory(temporaryDirectory);
+
+    const bool extracted = makeDirectories(temporaryDirectory) && extractArchive(archive, archiveSize, temporaryDirectory);
+
+    free(archive);
+
+    if (!extracted) {
+        removeDirectory(temporaryDirectory);
+        return FMIError;
+    }
+
+    if (rename(temporaryDirectory, unzipdir)) {
+
+        removeDirectory(temporaryDirectory);
+
+        // extracted by a concurrent run
+        if (!isDirectory(unzipdir)) {
+            return FMIError;
+        }
+    }
+
+    writeIndex(indexPath, fullPath, &stamp, hash);
+
+    return FMIOK;
+}
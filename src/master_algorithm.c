@@ -0,0 +1,624 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+
+#include "master_algorithm.h"
+#include "worker_pool.h"
+#include "connection_plan.h"
+
+#define CALL(f) do { status = f; if (status > FMIOK) goto TERMINATE; } while (0)
+
+typedef struct {
+    const char *name;
+    MasterAlgorithmType type;
+} MasterAlgorithmName;
+
+static const MasterAlgorithmName names[] = {
+    { "gauss-seidel", MasterGaussSeidel },
+    { "jacobi",       MasterJacobi      },
+    { "hybrid",       MasterHybrid      },
+};
+
+// Arguments and results of FMI3DoStep for one instance
+typedef struct {
+    FMIInstance *instance;
+    fmi3Float64 time;
+    fmi3Float64 h;
+    fmi3Boolean noSetFMUStatePriorToCurrentPoint;
+    fmi3Boolean eventHandlingNeeded;
+    fmi3Boolean terminateSimulation;
+    fmi3Boolean earlyReturn;
+    fmi3Float64 lastSuccessfulTime;
+    bool earlyReturnAllowed;    // steps before the waves
+} DoStepTask;
+
+typedef struct {
+    size_t nInstances;
+    size_t *instances;
+    ConnectionPlan *plan;  // outputs of the wave
+} Wave;
+
+struct MasterAlgorithm_ {
+
+    Scheduler *scheduler;
+
+    MasterAlgorithmType type;
+
+    WorkerPool *pool;
+
+    size_t nInstances;
+    DoStepTask *tasks;
+    void **arguments;   // tasks of the current wave
+
+    size_t nWaves;
+    Wave *waves;
+
+    // snapshots at the start of the step for the event location
+    fmi3FMUState *states;
+
+    // inputs of the instances that may return early, extrapolated from the start of the step
+    size_t nEarlyReturn;
+    fmi3Float64 stepTime;
+    fmi3Float64 *values;
+    fmi3Float64 *derivatives;
+    FMIStatus intermediateStatus;
+
+    MasterAlgorithmStatistics statistics;
+};
+
+static FMIStatus doStep(void *argument) {
+
+    DoStepTask *task = (DoStepTask*)argument;
+
+    return FMI3DoStep(task->instance, task->time, task->h, task->noSetFMUStatePriorToCurrentPoint,
+        &task->eventHandlingNeeded, &task->terminateSimulation, &task->earlyReturn, &task->lastSuccessfulTime);
+}
+
+/* Orders the instances by the connections that are exchanged between steps and assigns each one a level. */
+static bool sortInstances(const Scheduler *scheduler, size_t *order, size_t *level) {
+
+    const size_t n = SchedulerGetNumberOfInstances(scheduler);
+    const size_t nConnections = SchedulerGetNumberOfConnections(scheduler);
+
+    bool *done = (bool*)calloc(n + 1, sizeof(bool));
+    size_t *nPredecessors = (size_t*)calloc(n + 1, sizeof(size_t));
+
+    if (!done || !nPredecessors) {
+        free(done);
+        free(nPredecessors);
+        return false;
+    }
+
+    for (size_t i = 0; i < nConnections; i++) {
+
+        const Connection *c = SchedulerGetConnection(scheduler, i);
+
+        if (!SchedulerIsClockedConnection(c) && c->fromInstance != c->toInstance) {
+            nPredecessors[c->toInstance]++;
+        }
+    }
+
+    for (size_t k = 0; k < n; k++) {
+
+        size_t next = n;
+
+        for (size_t i = 0; i < n && next == n; i++) {
+            if (!done[i] && nPredecessors[i] == 0) {
+                next = i;
+            }
+        }
+
+        // Break a cycle at the first remaining instance
+        for (size_t i = 0; i < n && next == n; i++) {
+            if (!done[i]) {
+                next = i;
+            }
+        }
+
+        done[next] = true;
+        order[k] = next;
+        level[next] = 0;
+
+        for (size_t i = 0; i < nConnections; i++) {
+
+            const Connection *c = SchedulerGetConnection(scheduler, i);
+
+            if (SchedulerIsClockedConnection(c) || c->fromInstance == c->toInstance) {
+                continue;
+            }
+
+            // predecessors that have already been sorted
+            if (c->toInstance == next && done[c->fromInstance] && level[c->fromInstance] + 1 > level[next]) {
+                level[next] = level[c->fromInstance] + 1;
+            }
+
+            if (c->fromInstance == next && nPredecessors[c->toInstance] > 0) {
+                nPredecessors[c->toInstance]--;
+            }
+        }
+    }
+
+    free(done);
+    free(nPredecessors);
+
+    return true;
+}
+
+static bool addToWave(Wave *wave, size_t instance) {
+
+    size_t *instances = (size_t*)realloc(wave->instances, (wave->nInstances + 1) * sizeof(size_t));
+
+    if (!instances) {
+        return false;
+    }
+
+    wave->instances = instances;
+    wave->instances[wave->nInstances++] = instance;
+
+    return true;
+}
+
+static bool createWaves(MasterAlgorithm *master) {
+
+    const size_t n = master->nInstances;
+
+    bool success = false;
+
+    size_t *order = (size_t*)calloc(n + 1, sizeof(size_t));
+    size_t *level = (size_t*)calloc(n + 1, sizeof(size_t));
+    size_t *wave = (size_t*)calloc(n + 1, sizeof(size_t));  // wave of every instance
+    const size_t nConnections = SchedulerGetNumberOfConnections(master->scheduler);
+    const Connection **connections = NULL;
+
+    if (!order || !level || !wave || !sortInstances(master->scheduler, order, level)) {
+        goto TERMINATE;
+    }
+
+    for (size_t k = 0; k < n; k++) {
+
+        const size_t i = order[k];
+
+        switch (master->type) {
+        case MasterGaussSeidel:
+            wave[i] = k;
+            break;
+        case MasterJacobi:
+            wave[i] = 0;
+            break;
+        case MasterHybrid:
+            wave[i] = level[i];
+            break;
+        }
+
+        if (wave[i] + 1 > master->nWaves) {
+            master->nWaves = wave[i] + 1;
+        }
+    }
+
+    master->waves = (Wave*)calloc(master->nWaves + 1, sizeof(Wave));
+
+    if (!master->waves) {
+        goto TERMINATE;
+    }
+
+    // Within a wave the instances keep the order of the graph
+    for (size_t k = 0; k < n; k++) {
+        if (!addToWave(&master->waves[wave[order[k]]], order[k])) {
+            goto TERMINATE;
+        }
+    }
+
+    connections = (const Connection**)calloc(nConnections + 1, sizeof(Connection*));
+
+    if (!connections) {
+        goto TERMINATE;
+    }
+
+    // The outputs of a wave are exchanged with one get and one set call per instance
+    for (size_t w = 0; w < master->nWaves; w++) {
+
+        size_t nWaveConnections = 0;
+
+        for (size_t i = 0; i < nConnections; i++) {
+
+            const Connection *c = SchedulerGetConnection(master->scheduler, i);
+
+            if (!SchedulerIsClockedConnection(c) && wave[c->fromInstance] == w) {
+                connections[nWaveConnections++] = c;
+            }
+        }
+
+        master->waves[w].plan = ConnectionPlanCreate(master->scheduler, connections, nWaveConnections);
+
+        if (!master->waves[w].plan) {
+            goto TERMINATE;
+        }
+    }
+
+    success = true;
+
+TERMINATE:
+    free(order);
+    free(level);
+    free(wave);
+    free(connections);
+
+    return success;
+}
+
+MasterAlgorithm* MasterAlgorithmCreate(Scheduler *scheduler, MasterAlgorithmType type, size_t nThreads) {
+
+    MasterAlgorithm *master = (MasterAlgorithm*)calloc(1, sizeof(MasterAlgorithm));
+
+    if (!master) {
+        return NULL;
+    }
+
+    master->scheduler = scheduler;
+    master->type = type;
+    master->nInstances = SchedulerGetNumberOfInstances(scheduler);
+    master->tasks = (DoStepTask*)calloc(master->nInstances + 1, sizeof(DoStepTask));
+    master->arguments = (void**)calloc(master->nInstances + 1, sizeof(void*));
+    master->states = (fmi3FMUState*)calloc(master->nInstances + 1, sizeof(fmi3FMUState));
+    master->values = (fmi3Float64*)calloc(SchedulerGetNumberOfConnections(scheduler) + 1, sizeof(fmi3Float64));
+    master->derivatives = (fmi3Float64*)calloc(SchedulerGetNumberOfConnections(scheduler) + 1, sizeof(fmi3Float64));
+
+    if (!master->tasks || !master->arguments || !master->states || !master->values || !master->derivatives || !createWaves(master)) {
+        MasterAlgorithmFree(master);
+        return NULL;
+    }
+
+    for (size_t i = 0; i < master->nInstances; i++) {
+        master->tasks[i].instance = SchedulerGetInstance(scheduler, i);
+    }
+
+    // Gauss-Seidel steps one instance at a time
+    if (nThreads > 0 && type != MasterGaussSeidel) {
+
+        master->pool = WorkerPoolCreate(nThreads);
+
+        if (!master->pool) {
+            MasterAlgorithmFree(master);
+            return NULL;
+        }
+    }
+
+    return master;
+}
+
+void MasterAlgorithmFree(MasterAlgorithm *master) {
+
+    if (!master) {
+        return;
+    }
+
+    WorkerPoolFree(master->pool);
+
+    for (size_t i = 0; i < master->nInstances && master->states; i++) {
+        if (master->states[i]) {
+            FMI3FreeFMUState(master->tasks[i].instance, &master->states[i]);
+        }
+    }
+
+    for (size_t i = 0; i < master->nWaves; i++) {
+        free(master->waves[i].instances);
+        ConnectionPlanFree(master->waves[i].plan);
+    }
+
+    free(master->waves);
+    free(master->tasks);
+    free(master->arguments);
+    free(master->states);
+    free(master->values);
+    free(master->derivatives);
+    free(master);
+}
+
+/* Steps the instances that may return early from the same inputs and limits the step of the others to the earliest return. */
+static FMIStatus stepEarlyReturn(MasterAlgorithm *master, fmi3Float64 time, fmi3Float64 h, fmi3Float64 *hTaken) {
+
+    FMIStatus status = FMIOK;
+
+    // The inputs are extrapolated with the first output derivative of their sources
+    for (size_t i = 0; i < SchedulerGetNumberOfConnections(master->scheduler); i++) {
+
+        const Connection *c = SchedulerGetConnection(master->scheduler, i);
+
+        if (SchedulerIsClockedConnection(c) || !master->tasks[c->toInstance].earlyReturnAllowed) {
+            continue;
+        }
+
+        const fmi3Int32 order[] = { 1 };
+
+        CALL(FMI3GetFloat64(master->tasks[c->fromInstance].instance, &c->from->valueReference, 1, &master->values[i], 1));
+        CALL(FMI3GetOutputDerivatives(master->tasks[c->fromInstance].instance, &c->from->valueReference, 1, order, &master->derivatives[i], 1));
+    }
+
+    master->stepTime = time;
+    master->intermediateStatus = FMIOK;
+
+    // The intermediate updates set the inputs on the calling thread
+    for (size_t i = 0; i < master->nInstances; i++) {
+
+        DoStepTask *task = &master->tasks[i];
+
+        if (!task->earlyReturnAllowed) {
+            continue;
+        }
+
+        task->time = time;
+        task->h = h;
+        task->noSetFMUStatePriorToCurrentPoint = fmi3True;
+
+        CALL(doStep(task));
+        CALL(master->intermediateStatus);
+
+        if (task->earlyReturn) {
+            master->statistics.nEarlyReturns++;
+        }
+
+        if (task->earlyReturn && task->lastSuccessfulTime - time < *hTaken) {
+            *hTaken = task->lastSuccessfulTime - time;
+        }
+    }
+
+    for (size_t i = 0; i < master->nInstances; i++) {
+
+        const DoStepTask *task = &master->tasks[i];
+
+        if (task->earlyReturnAllowed && (task->earlyReturn ? task->lastSuccessfulTime - time : h) > *hTaken) {
+            printf("The instances returned early at different times.\n");
+            status = FMIError;
+            goto TERMINATE;
+        }
+    }
+
+TERMINATE:
+    return status;
+}
+
+static FMIStatus stepWaves(MasterAlgorithm *master, fmi3Float64 time, fmi3Float64 h, fmi3Boolean noSetFMUStatePriorToCurrentPoint, fmi3Float64 *hTaken) {
+
+    FMIStatus status = FMIOK;
+
+    *hTaken = h;
+
+    if (master->nEarlyReturn > 0) {
+        CALL(stepEarlyReturn(master, time, h, hTaken));
+    }
+
+    for (size_t i = 0; i < master->nWaves; i++) {
+
+        const Wave *wave = &master->waves[i];
+
+        size_t nTasks = 0;
+
+        for (size_t j = 0; j < wave->nInstances; j++) {
+
+            DoStepTask *task = &master->tasks[wave->instances[j]];
+
+            if (task->earlyReturnAllowed) {
+                continue;
+            }
+
+            task->time = time;
+            task->h = *hTaken;
+            task->noSetFMUStatePriorToCurrentPoint = noSetFMUStatePriorToCurrentPoint;
+
+            master->arguments[nTasks++] = task;
+        }
+
+        if (master->pool && nTasks > 1) {
+            CALL(WorkerPoolRun(master->pool, doStep, master->arguments, nTasks));
+        } else {
+            for (size_t j = 0; j < nTasks; j++) {
+                CALL(doStep(master->arguments[j]));
+            }
+        }
+
+        // Propagate the outputs of the wave
+        CALL(ConnectionPlanExchange(wave->plan));
+    }
+
+TERMINATE:
+    return status;
+}
+
+static bool eventReported(const MasterAlgorithm *master) {
+
+    for (size_t i = 0; i < master->nInstances; i++) {
+        if (master->tasks[i].eventHandlingNeeded) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static FMIStatus finishStep(MasterAlgorithm *master, bool *eventHandlingNeeded, bool *terminateSimulation) {
+
+    FMIStatus status = FMIOK;
+
+    *eventHandlingNeeded = false;
+    *terminateSimulation = false;
+
+    for (size_t i = 0; i < master->nInstances; i++) {
+
+        const DoStepTask *task = &master->tasks[i];
+
+        if (task->eventHandlingNeeded) {
+            *eventHandlingNeeded = true;
+            CALL(SchedulerSetStateEvent(master->scheduler, task->instance));
+        }
+
+        if (task->terminateSimulation) {
+            *terminateSimulation = true;
+        }
+    }
+
+TERMINATE:
+    return status;
+}
+
+FMIStatus MasterAlgorithmDoStep(MasterAlgorithm *master, fmi3Float64 time, fmi3Float64 h, fmi3Float64 *hTaken, bool *eventHandlingNeeded, bool *terminateSimulation) {
+
+    FMIStatus status = FMIOK;
+
+    CALL(stepWaves(master, time, h, fmi3True, hTaken));
+    CALL(finishStep(master, eventHandlingNeeded, terminateSimulation));
+
+TERMINATE:
+    return status;
+}
+
+static FMIStatus restoreStates(MasterAlgorithm *master) {
+
+    FMIStatus status = FMIOK;
+
+    for (size_t i = 0; i < master->nInstances; i++) {
+        CALL(FMI3SetFMUState(master->tasks[i].instance, master->states[i]));
+    }
+
+TERMINATE:
+    return status;
+}
+
+FMIStatus MasterAlgorithmDoStepLocateEvents(MasterAlgorithm *master, fmi3Float64 time, fmi3Float64 h, fmi3Float64 tolerance, fmi3Float64 *hTaken, bool *eventHandlingNeeded, bool *terminateSimulation) {
+
+    FMIStatus status = FMIOK;
+
+    // The states are overwritten, so the FMUs only allocate them once
+    for (size_t i = 0; i < master->nInstances; i++) {
+        CALL(FMI3GetFMUState(master->tasks[i].instance, &master->states[i]));
+    }
+
+    CALL(stepWaves(master, time, h, fmi3False, hTaken));
+
+    if (eventReported(master) && h > tolerance) {
+
+        // The event is reported after a step of hR but not after a step of hL
+        fmi3Float64 hL = 0.0;
+        fmi3Float64 hR = h;
+        fmi3Float64 hLast = h;
+
+        while (hR - hL > tolerance) {
+
+            hLast = 0.5 * (hL + hR);
+
+            CALL(restoreStates(master));
+            CALL(stepWaves(master, time, hLast, fmi3False, hTaken));
+
+            master->statistics.nRollbacks++;
+
+            if (eventReported(master)) {
+                hR = hLast;
+            } else {
+                hL = hLast;
+            }
+        }
+
+        // Re-step to the end of the bracket
+        if (hLast != hR) {
+            CALL(restoreStates(master));
+            CALL(stepWaves(master, time, hR, fmi3False, hTaken));
+            master->statistics.nRollbacks++;
+        }
+
+        *hTaken = hR;
+
+        master->statistics.nEvents++;
+    }
+
+    CALL(finishStep(master, eventHandlingNeeded, terminateSimulation));
+
+TERMINATE:
+    return status;
+}
+
+FMIStatus MasterAlgorithmAllowEarlyReturn(MasterAlgorithm *master, FMIInstance *instance) {
+
+    for (size_t i = 0; i < master->nInstances; i++) {
+
+        if (master->tasks[i].instance == instance) {
+
+            if (!master->tasks[i].earlyReturnAllowed) {
+                master->tasks[i].earlyReturnAllowed = true;
+                master->nEarlyReturn++;
+            }
+
+            // to find the master in the intermediate updates
+            instance->userData = master;
+
+            return FMIOK;
+        }
+    }
+
+    return FMIError;
+}
+
+void MasterAlgorithmIntermediateUpdate(
+    fmi3InstanceEnvironment instanceEnvironment,
+    fmi3Float64  intermediateUpdateTime,
+    fmi3Boolean  intermediateVariableSetRequested,
+    fmi3Boolean  intermediateVariableGetAllowed,
+    fmi3Boolean  intermediateStepFinished,
+    fmi3Boolean  canReturnEarly,
+    fmi3Boolean* earlyReturnRequested,
+    fmi3Float64* earlyReturnTime) {
+
+    FMIInstance *instance = (FMIInstance*)instanceEnvironment;
+    MasterAlgorithm *master = (MasterAlgorithm*)instance->userData;
+
+    *earlyReturnRequested = fmi3False;
+
+    if (!master || !intermediateVariableSetRequested) {
+        return;
+    }
+
+    const fmi3Float64 dt = intermediateUpdateTime - master->stepTime;
+
+    for (size_t i = 0; i < SchedulerGetNumberOfConnections(master->scheduler); i++) {
+
+        const Connection *c = SchedulerGetConnection(master->scheduler, i);
+
+        if (SchedulerIsClockedConnection(c) || master->tasks[c->toInstance].instance != instance) {
+            continue;
+        }
+
+        const fmi3Float64 value = master->values[i] + dt * master->derivatives[i];
+
+        const FMIStatus status = FMI3SetFloat64(instance, &c->to->valueReference, 1, &value, 1);
+
+        if (status > master->intermediateStatus) {
+            master->intermediateStatus = status;
+        }
+    }
+}
+
+const MasterAlgorithmStatistics* MasterAlgorithmGetStatistics(const MasterAlgorithm *master) {
+    return &master->statistics;
+}
+
+const char* MasterAlgorithmTypeToString(MasterAlgorithmType type) {
+
+    for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); i++) {
+        if (names[i].type == type) {
+            return names[i].name;
+        }
+    }
+
+    return "unknown";
+}
+
+bool MasterAlgorithmTypeFromString(const char *name, MasterAlgorithmType *type) {
+
+    for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); i++) {
+        if (!strcmp(names[i].name, name)) {
+            *type = names[i].type;
+            return true;
+        }
+    }
+
+    return false;
+}
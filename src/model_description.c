@@ -0,0 +1,630 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "model_description.h"
+
+#define MAX_ATTRIBUTES 32
+
+// Initial capacity of the arrays, which grow by doubling
+#define INITIAL_CAPACITY 8
+
+typedef struct {
+    char *name;
+    bool isEndTag;
+    bool isEmpty;  // <element ... />
+    size_t nAttributes;
+    char *keys[MAX_ATTRIBUTES];
+    char *values[MAX_ATTRIBUTES];
+} Element;
+
+typedef enum {
+    SectionNone,
+    SectionModelVariables,
+    SectionModelStructure
+} Section;
+
+static char* readFile(const char *filename) {
+
+    FILE *file = fopen(filename, "rb");
+
+    if (!file) {
+        return NULL;
+    }
+
+    fseek(file, 0, SEEK_END);
+    const long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    char *buffer = size >= 0 ? (char*)calloc((size_t)size + 1, sizeof(char)) : NULL;
+
+    if (buffer && fread(buffer, 1, (size_t)size, file) != (size_t)size) {
+        free(buffer);
+        buffer = NULL;
+    }
+
+    fclose(file);
+
+    return buffer;
+}
+
+static bool isSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+/* Replaces the predefined entities in place. */
+static void decodeEntities(char *s) {
+
+    static const char *entities[][2] = {
+        { "&lt;", "<" }, { "&gt;", ">" }, { "&amp;", "&" }, { "&quot;", "\"" }, { "&apos;", "'" }
+    };
+
+    char *out = s;
+
+    while (*s) {
+
+        bool decoded = false;
+
+        if (*s == '&') {
+            for (size_t i = 0; i < sizeof(entities) / sizeof(entities[0]); i++) {
+                const size_t length = strlen(entities[i][0]);
+                if (!strncmp(s, entities[i][0], length)) {
+                    *out++ = entities[i][1][0];
+                    s += length;
+                    decoded = true;
+                    break;
+                }
+            }
+        }
+
+        if (!decoded) {
+            *out++ = *s++;
+        }
+    }
+
+    *out = '\0';
+}
+
+/* Parses the next element and terminates its name and attributes in place. Returns false at the end of the document or on a syntax error. */
+static bool nextElement(char **position, Element *element, bool *error) {
+
+    char *p = *position;
+
+    for (;;) {
+
+        p = strchr(p, '<');
+
+        if (!p) {
+            return false;
+        }
+
+        if (!strncmp(p, "<!--", 4)) {
+            p = strstr(p, "-->");
+            if (!p) {
+                *error = true;
+                return false;
+            }
+        } else if (p[1] == '?' || p[1] == '!') {
+            p = strchr(p, '>');
+            if (!p) {
+                *error = true;
+                return false;
+            }
+        } else {
+            break;
+        }
+    }
+
+    memset(element, 0, sizeof(Element));
+
+    p++;
+
+    if (*p == '/') {
+        element->isEndTag = true;
+        p++;
+    }
+
+    element->name = p;
+
+    while (*p && !isSpace(*p) && *p != '>' && *p != '/') {
+        p++;
+    }
+
+    for (;;) {
+
+        while (isSpace(*p)) {
+            *p++ = '\0';
+        }
+
+        if (*p == '>') {
+            *p++ = '\0';
+            break;
+        }
+
+        if (*p == '/' && p[1] == '>') {
+            *p = '\0';
+            p += 2;
+            element->isEmpty = true;
+            break;
+        }
+
+        if (!*p || element->nAttributes == MAX_ATTRIBUTES) {
+            *error = true;
+            return false;
+        }
+
+        // key="value"
+        char *key = p;
+
+        while (*p && *p != '=' && !isSpace(*p)) {
+            p++;
+        }
+
+        while (isSpace(*p)) {
+            *p++ = '\0';
+        }
+
+        if (*p != '=') {
+            *error = true;
+            return false;
+        }
+
+        *p++ = '\0';
+
+        while (isSpace(*p)) {
+            p++;
+        }
+
+        const char quote = *p;
+
+        if (quote != '"' && quote != '\'') {
+            *error = true;
+            return false;
+        }
+
+        char *value = ++p;
+
+        p = strchr(p, quote);
+
+        if (!p) {
+            *error = true;
+            return false;
+        }
+
+        *p++ = '\0';
+
+        decodeEntities(value);
+
+        element->keys[element->nAttributes] = key;
+        element->values[element->nAttributes] = value;
+        element->nAttributes++;
+    }
+
+    *position = p;
+
+    return true;
+}
+
+static const char* getAttribute(const Element *element, const char *key) {
+
+    for (size_t i = 0; i < element->nAttributes; i++) {
+        if (!strcmp(element->keys[i], key)) {
+            return element->values[i];
+        }
+    }
+
+    return NULL;
+}
+
+static bool getBooleanAttribute(const Element *element, const char *key) {
+    const char *value = getAttribute(element, key);
+    return value && !strcmp(value, "true");
+}
+
+/* Makes room for the element n of an array with n elements. */
+static bool grow(void **array, size_t n, size_t size) {
+
+    // the capacity is INITIAL_CAPACITY * 2^k
+    if (n != 0 && (n < INITIAL_CAPACITY || (n & (n - 1)))) {
+        return true;
+    }
+
+    void *grown = realloc(*array, (n == 0 ? INITIAL_CAPACITY : 2 * n) * size);
+
+    if (!grown) {
+        return false;
+    }
+
+    *array = grown;
+
+    return true;
+}
+
+/* FNV-1a */
+static size_t hashName(const char *name) {
+
+    uint32_t hash = 2166136261u;
+
+    for (const char *c = name; *c; c++) {
+        hash = (hash ^ (uint8_t)*c) * 16777619u;
+    }
+
+    return hash;
+}
+
+static size_t hashValueReference(fmi3ValueReference valueReference) {
+    return (size_t)(valueReference * 2654435761u);
+}
+
+/* Indexes the variables by name and value reference, the first of equal keys is found. */
+static bool buildIndex(ModelDescription *modelDescription) {
+
+    size_t nBuckets = INITIAL_CAPACITY;
+
+    // load factor <= 0.5
+    while (nBuckets < 2 * modelDescription->nVariables) {
+        nBuckets *= 2;
+    }
+
+    size_t *buckets = (size_t*)calloc(2 * nBuckets, sizeof(size_t));
+
+    if (!buckets) {
+        return false;
+    }
+
+    free(modelDescription->nameBuckets);
+
+    modelDescription->nBuckets = nBuckets;
+    modelDescription->nameBuckets = buckets;
+    modelDescription->valueReferenceBuckets = buckets + nBuckets;
+
+    for (size_t i = 0; i < modelDescription->nVariables; i++) {
+
+        const ModelVariable *variable = &modelDescription->variables[i];
+
+        size_t j = hashName(variable->name) & (nBuckets - 1);
+
+        while (modelDescription->nameBuckets[j]) {
+            j = (j + 1) & (nBuckets - 1);
+        }
+
+        modelDescription->nameBuckets[j] = i + 1;
+
+        j = hashValueReference(variable->valueReference) & (nBuckets - 1);
+
+        while (modelDescription->valueReferenceBuckets[j]) {
+            j = (j + 1) & (nBuckets - 1);
+        }
+
+        modelDescription->valueReferenceBuckets[j] = i + 1;
+    }
+
+    return true;
+}
+
+/* Parses a list of value references separated by white space. */
+static bool parseValueReferences(const char *s, size_t *n, fmi3ValueReference **valueReferences) {
+
+    *n = 0;
+    *valueReferences = NULL;
+
+    if (!s) {
+        return true;
+    }
+
+    // every value reference is followed by white space or the end of the string
+    size_t capacity = 0;
+
+    for (const char *c = s; *c; c++) {
+        if (!isSpace(*c) && (isSpace(c[1]) || !c[1])) {
+            capacity++;
+        }
+    }
+
+    if (capacity == 0) {
+        return true;
+    }
+
+    *valueReferences = (fmi3ValueReference*)calloc(capacity, sizeof(fmi3ValueReference));
+
+    if (!*valueReferences) {
+        return false;
+    }
+
+    const char *p = s;
+
+    while (*n < capacity) {
+
+        char *end = NULL;
+
+        const unsigned long vr = strtoul(p, &end, 10);
+
+        if (end == p) {
+            return false;
+        }
+
+        (*valueReferences)[(*n)++] = (fmi3ValueReference)vr;
+
+        p = end;
+    }
+
+    return true;
+}
+
+static bool addVariable(ModelDescription *modelDescription, const Element *element) {
+
+    const char *name = getAttribute(element, "name");
+    const char *valueReference = getAttribute(element, "valueReference");
+    const char *causality = getAttribute(element, "causality");
+    const char *variability = getAttribute(element, "variability");
+
+    if (!name || !valueReference || !grow((void**)&modelDescription->variables, modelDescription->nVariables, sizeof(ModelVariable))) {
+        return false;
+    }
+
+    ModelVariable *variable = &modelDescription->variables[modelDescription->nVariables++];
+
+    memset(variable, 0, sizeof(ModelVariable));
+
+    variable->name = name;
+    variable->valueReference = (fmi3ValueReference)strtoul(valueReference, NULL, 10);
+
+    if (!strcmp(element->name, "Float64")) {
+        variable->type = ModelVariableFloat64;
+    } else if (!strcmp(element->name, "Clock")) {
+        variable->type = ModelVariableClock;
+    } else {
+        variable->type = ModelVariableOther;
+    }
+
+    if (causality && !strcmp(causality, "input")) {
+        variable->causality = CausalityInput;
+    } else if (causality && !strcmp(causality, "output")) {
+        variable->causality = CausalityOutput;
+    } else {
+        variable->causality = CausalityOther;
+    }
+
+    // variability defaults to continuous for Float64 variables
+    variable->continuous = variability ? !strcmp(variability, "continuous") : variable->type == ModelVariableFloat64;
+
+    const char *priority = getAttribute(element, "priority");
+
+    if (priority) {
+        variable->priority = (fmi3UInt32)strtoul(priority, NULL, 10);
+    }
+
+    const char *derivative = getAttribute(element, "derivative");
+
+    if (derivative) {
+        variable->hasDerivative = true;
+        variable->derivative = (fmi3ValueReference)strtoul(derivative, NULL, 10);
+    }
+
+    return parseValueReferences(getAttribute(element, "clocks"), &variable->nClocks, &variable->clocks);
+}
+
+/* Adds the dependencies of an <Output> or <ContinuousStateDerivative>. */
+static bool addDependencies(ModelDescription *modelDescription, const Element *element) {
+
+    const char *valueReference = getAttribute(element, "valueReference");
+
+    if (!valueReference) {
+        return false;
+    }
+
+    ModelVariable *variable = (ModelVariable*)ModelDescriptionFindValueReference(modelDescription, (fmi3ValueReference)strtoul(valueReference, NULL, 10));
+
+    if (!variable) {
+        return false;
+    }
+
+    const char *dependencies = getAttribute(element, "dependencies");
+
+    free(variable->dependencies);
+
+    variable->hasDependencies = dependencies != NULL;
+
+    return parseValueReferences(dependencies, &variable->nDependencies, &variable->dependencies);
+}
+
+static bool addContinuousStateDerivative(ModelDescription *modelDescription, const Element *element) {
+
+    if (!addDependencies(modelDescription, element)) {
+        return false;
+    }
+
+    const size_t n = modelDescription->nContinuousStateDerivatives;
+
+    if (!grow((void**)&modelDescription->continuousStateDerivatives, n, sizeof(fmi3ValueReference))) {
+        return false;
+    }
+
+    modelDescription->continuousStateDerivatives[n] = (fmi3ValueReference)strtoul(getAttribute(element, "valueReference"), NULL, 10);
+    modelDescription->nContinuousStateDerivatives = n + 1;
+
+    return true;
+}
+
+static void readInterface(ModelInterface *modelInterface, const Element *element) {
+
+    modelInterface->provided                               = true;
+    modelInterface->modelIdentifier                        = getAttribute(element, "modelIdentifier");
+    modelInterface->providesDirectionalDerivatives         = getBooleanAttribute(element, "providesDirectionalDerivatives");
+    modelInterface->providesAdjointDerivatives             = getBooleanAttribute(element, "providesAdjointDerivatives");
+    modelInterface->canGetAndSetFMUState                   = getBooleanAttribute(element, "canGetAndSetFMUState");
+    modelInterface->canSerializeFMUState                   = getBooleanAttribute(element, "canSerializeFMUState");
+    modelInterface->canHandleVariableCommunicationStepSize = getBooleanAttribute(element, "canHandleVariableCommunicationStepSize");
+    modelInterface->hasEventMode                           = getBooleanAttribute(element, "hasEventMode");
+}
+
+ModelDescription* ModelDescriptionRead(const char *filename) {
+
+    char *buffer = readFile(filename);
+
+    if (!buffer) {
+        return NULL;
+    }
+
+    ModelDescription *modelDescription = (ModelDescription*)calloc(1, sizeof(ModelDescription));
+
+    if (!modelDescription) {
+        free(buffer);
+        return NULL;
+    }
+
+    modelDescription->buffer = buffer;
+
+    char *position = buffer;
+    Element element;
+    Section section = SectionNone;
+    size_t depth = 0;  // depth of nested elements within a section
+    bool error = false;
+
+    while (!error && nextElement(&position, &element, &error)) {
+
+        if (element.isEndTag) {
+
+            if (depth > 0) {
+                depth--;
+            } else {
+                // the <ModelStructure> refers to the variables by value reference
+                if (section == SectionModelVariables) {
+                    error = !buildIndex(modelDescription);
+                }
+                section = SectionNone;
+            }
+
+            continue;
+        }
+
+        if (!strcmp(element.name, "fmiModelDescription")) {
+
+            modelDescription->modelName = getAttribute(&element, "modelName");
+            modelDescription->instantiationToken = getAttribute(&element, "instantiationToken");
+
+        } else if (section == SectionNone && !strcmp(element.name, "ModelExchange")) {
+
+            readInterface(&modelDescription->modelExchange, &element);
+
+        } else if (section == SectionNone && !strcmp(element.name, "CoSimulation")) {
+
+            readInterface(&modelDescription->coSimulation, &element);
+
+        } else if (section == SectionNone && !strcmp(element.name, "ScheduledExecution")) {
+
+            readInterface(&modelDescription->scheduledExecution, &element);
+
+        } else if (section == SectionNone && !element.isEmpty && !strcmp(element.name, "ModelVariables")) {
+
+            section = SectionModelVariables;
+
+        } else if (section == SectionNone && !element.isEmpty && !strcmp(element.name, "ModelStructure")) {
+
+            section = SectionModelStructure;
+
+        } else if (section != SectionNone) {
+
+            if (depth == 0) {
+                if (section == SectionModelVariables) {
+                    error = !addVariable(modelDescription, &element);
+                } else if (!strcmp(element.name, "Output")) {
+                    error = !addDependencies(modelDescription, &element);
+                } else if (!strcmp(element.name, "ContinuousStateDerivative")) {
+                    error = !addContinuousStateDerivative(modelDescription, &element);
+                }
+            }
+
+            if (!element.isEmpty) {
+                depth++;
+            }
+        }
+    }
+
+    if (!error && modelDescription->nBuckets == 0) {
+        error = !buildIndex(modelDescription);
+    }
+
+    if (error) {
+        ModelDescriptionFree(modelDescription);
+        return NULL;
+    }
+
+    return modelDescription;
+}
+
+void ModelDescriptionFree(ModelDescription *modelDescription) {
+
+    if (!modelDescription) {
+        return;
+    }
+
+    for (size_t i = 0; i < modelDescription->nVariables; i++) {
+        free(modelDescription->variables[i].clocks);
+        free(modelDescription->variables[i].dependencies);
+    }
+
+    free(modelDescription->variables);
+    free(modelDescription->continuousStateDerivatives);
+    free(modelDescription->nameBuckets);
+    free(modelDescription->buffer);
+    free(modelDescription);
+}
+
+const ModelVariable* ModelDescriptionFindVariable(const ModelDescription *modelDescription, const char *name) {
+
+    const size_t mask = modelDescription->nBuckets - 1;
+
+    if (modelDescription->nBuckets > 0) {
+
+        for (size_t j = hashName(name) & mask; modelDescription->nameBuckets[j]; j = (j + 1) & mask) {
+
+            const ModelVariable *variable = &modelDescription->variables[modelDescription->nameBuckets[j] - 1];
+
+            if (!strcmp(variable->name, name)) {
+                return variable;
+            }
+        }
+
+        return NULL;
+    }
+
+    // while the variables are read
+    for (size_t i = 0; i < modelDescription->nVariables; i++) {
+        if (!strcmp(modelDescription->variables[i].name, name)) {
+            return &modelDescription->variables[i];
+        }
+    }
+
+    return NULL;
+}
+
+const ModelVariable* ModelDescriptionFindValueReference(const ModelDescription *modelDescription, fmi3ValueReference valueReference) {
+
+    const size_t mask = modelDescription->nBuckets - 1;
+
+    if (modelDescription->nBuckets > 0) {
+
+        for (size_t j = hashValueReference(valueReference) & mask; modelDescription->valueReferenceBuckets[j]; j = (j + 1) & mask) {
+
+            const ModelVariable *variable = &modelDescription->variables[modelDescription->valueReferenceBuckets[j] - 1];
+
+            if (variable->valueReference == valueReference) {
+                return variable;
+            }
+        }
+
+        return NULL;
+    }
+
+    // while the variables are read
+    for (size_t i = 0; i < modelDescription->nVariables; i++) {
+        if (modelDescription->variables[i].valueReference == valueReference) {
+            return &modelDescription->variables[i];
+        }
+    }
+
+    return NULL;
+}
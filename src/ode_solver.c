@@ -0,0 +1,817 @@
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <float.h>
+#include <stdbool.h>
+
+#include "ode_solver.h"
+
+#define CALL(f) do { status = f; if (status > FMIOK) goto TERMINATE; } while (0)
+
+// Relative distance below which the end of a step is snapped to tMax
+#define TIME_RESOLUTION 1e-12
+
+// Bounds for the change of the step size of adaptive methods
+#define SAFETY_FACTOR     0.9
+#define MIN_STEP_FACTOR   0.2
+#define MAX_STEP_FACTOR   5.0
+
+typedef FMIStatus SolverStepFunction(Solver *solver, fmi3Float64 tMax);
+
+typedef void SolverInterpolateFunction(const Solver *solver, fmi3Float64 time, fmi3Float64 continuousStates[]);
+
+typedef struct {
+    SolverType type;
+    const char *name;
+    size_t nWorkVectors;
+    bool implicit;  // needs the Jacobian
+    SolverStepFunction *step;
+    SolverInterpolateFunction *interpolate;
+} SolverMethod;
+
+struct Solver_ {
+
+    FMIInstance *instance;
+
+    const SolverMethod *method;
+
+    SolverSettings settings;
+
+    size_t nx;
+
+    fmi3Float64 time;
+    fmi3Float64 tPrevious;  // start of the last accepted step
+    fmi3Float64 h;          // proposed step of adaptive methods
+
+    fmi3Float64 *x;         // states at time
+    fmi3Float64 *xPrevious; // states at tPrevious
+    fmi3Float64 *dx;        // derivatives at time, valid if dxValid
+    bool dxValid;
+
+    fmi3Float64 *work;      // nWorkVectors * nx
+    fmi3Float64 *rcont;     // coefficients of the dense output
+
+    // Jacobian of the implicit methods
+    fmi3ValueReference *stateReferences;      // NULL for finite differences
+    fmi3ValueReference *derivativeReferences;
+    bool *pattern;          // nx * nx, row-major
+    size_t *colors;         // column groups of the finite differences
+    size_t nColors;
+    fmi3Float64 *jacobian;  // nx * nx, row-major, at time and x if jacobianValid
+    bool jacobianValid;
+    fmi3Float64 *jacobianWork;  // 2 * nx
+    fmi3Float64 *lu;        // nx * nx, LU decomposition of the iteration matrix
+    size_t *pivots;
+    fmi3Float64 hLU;        // step of the iteration matrix, 0 if it has to be updated
+
+    SolverStatistics statistics;
+};
+
+/* Calls the FMU at an arbitrary point. Leaves the FMU at that point. */
+static FMIStatus getDerivatives(Solver *solver, fmi3Float64 time, const fmi3Float64 x[], fmi3Float64 dx[]) {
+
+    FMIStatus status = FMIOK;
+
+    CALL(FMI3SetTime(solver->instance, time));
+    CALL(FMI3SetContinuousStates(solver->instance, x, solver->nx));
+    CALL(FMI3GetContinuousStateDerivatives(solver->instance, dx, solver->nx));
+
+    solver->statistics.nDerivativeEvaluations++;
+
+TERMINATE:
+    return status;
+}
+
+/* The FMU is already at (time, x) after SolverReset() and SolverStep(), so only the derivatives are requested. */
+static FMIStatus updateCurrentDerivatives(Solver *solver) {
+
+    FMIStatus status = FMIOK;
+
+    if (solver->dxValid) {
+        return status;
+    }
+
+    CALL(FMI3GetContinuousStateDerivatives(solver->instance, solver->dx, solver->nx));
+
+    solver->statistics.nDerivativeEvaluations++;
+    solver->dxValid = true;
+
+TERMINATE:
+    return status;
+}
+
+/* Groups the columns of the Jacobian that do not share a row, so they can be perturbed together. Returns the number of groups. */
+static size_t colorColumns(size_t nx, const bool pattern[], size_t colors[]) {
+
+    size_t nColors = 0;
+
+    for (size_t j = 0; j < nx; j++) {
+
+        // smallest color without a column that shares a row with column j
+        size_t color = 0;
+        bool conflict;
+
+        do {
+
+            conflict = false;
+
+            for (size_t k = 0; k < j && !conflict; k++) {
+                for (size_t i = 0; i < nx && colors[k] == color && !conflict; i++) {
+                    conflict = pattern[i * nx + j] && pattern[i * nx + k];
+                }
+            }
+
+            if (conflict) {
+                color++;
+            }
+
+        } while (conflict);
+
+        colors[j] = color;
+
+        if (color >= nColors) {
+            nColors = color + 1;
+        }
+    }
+
+    return nColors;
+}
+
+/* Evaluates the Jacobian at (time, x). The derivatives at that point must be valid. Leaves the FMU at an arbitrary point. */
+static FMIStatus updateJacobian(Solver *solver) {
+
+    FMIStatus status = FMIOK;
+
+    const size_t nx = solver->nx;
+    fmi3Float64 *jacobian = solver->jacobian;
+
+    if (solver->stateReferences) {
+
+        // the FMU may have been left at a stage of a rejected step
+        CALL(FMI3SetTime(solver->instance, solver->time));
+        CALL(FMI3SetContinuousStates(solver->instance, solver->x, nx));
+        CALL(FMI3GetJacobian(solver->instance, solver->derivativeReferences, nx, solver->stateReferences, nx, jacobian));
+
+    } else {
+
+        fmi3Float64 *x  = &solver->jacobianWork[0];
+        fmi3Float64 *dx = &solver->jacobianWork[nx];
+
+        for (size_t color = 0; color < solver->nColors; color++) {
+
+            memcpy(x, solver->x, nx * sizeof(fmi3Float64));
+
+            for (size_t j = 0; j < nx; j++) {
+                if (solver->colors[j] == color) {
+                    x[j] += sqrt(DBL_EPSILON) * fmax(fabs(x[j]), 1.0);
+                }
+            }
+
+            CALL(getDerivatives(solver, solver->time, x, dx));
+
+            for (size_t j = 0; j < nx; j++) {
+
+                if (solver->colors[j] != color) {
+                    continue;
+                }
+
+                const fmi3Float64 delta = x[j] - solver->x[j];
+
+                for (size_t i = 0; i < nx; i++) {
+                    jacobian[i * nx + j] = solver->pattern[i * nx + j] ? (dx[i] - solver->dx[i]) / delta : 0.0;
+                }
+            }
+        }
+    }
+
+    solver->jacobianValid = true;
+    solver->hLU = 0;
+    solver->statistics.nJacobianEvaluations++;
+
+TERMINATE:
+    return status;
+}
+
+/* LU decomposition with partial pivoting in place. Returns false if the matrix is singular. */
+static bool decompose(size_t n, fmi3Float64 a[], size_t pivots[]) {
+
+    for (size_t k = 0; k < n; k++) {
+
+        size_t p = k;
+
+        for (size_t i = k + 1; i < n; i++) {
+            if (fabs(a[i * n + k]) > fabs(a[p * n + k])) {
+                p = i;
+            }
+        }
+
+        pivots[k] = p;
+
+        if (a[p * n + k] == 0.0) {
+            return false;
+        }
+
+        if (p != k) {
+            for (size_t j = 0; j < n; j++) {
+                const fmi3Float64 tmp = a[k * n + j];
+                a[k * n + j] = a[p * n + j];
+                a[p * n + j] = tmp;
+            }
+        }
+
+        for (size_t i = k + 1; i < n; i++) {
+
+            const fmi3Float64 l = a[i * n + k] /= a[k * n + k];
+
+            for (size_t j = k + 1; j < n; j++) {
+                a[i * n + j] -= l * a[k * n + j];
+            }
+        }
+    }
+
+    return true;
+}
+
+/* Solves A x = b with the decomposition of A. b is overwritten with x. */
+static void solve(size_t n, const fmi3Float64 lu[], const size_t pivots[], fmi3Float64 b[]) {
+
+    for (size_t k = 0; k < n; k++) {
+        const fmi3Float64 tmp = b[k];
+        b[k] = b[pivots[k]];
+        b[pivots[k]] = tmp;
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        for (size_t k = 0; k < i; k++) {
+            b[i] -= lu[i * n + k] * b[k];
+        }
+    }
+
+    for (size_t i = n; i-- > 0;) {
+        for (size_t k = i + 1; k < n; k++) {
+            b[i] -= lu[i * n + k] * b[k];
+        }
+        b[i] /= lu[i * n + i];
+    }
+}
+
+static fmi3Float64 limitStep(const Solver *solver, fmi3Float64 h, fmi3Float64 tMax, bool *limited) {
+
+    const fmi3Float64 remaining = tMax - solver->time;
+
+    // snap to tMax instead of leaving a step that is only caused by round-off
+    *limited = h >= remaining - TIME_RESOLUTION * fmax(1.0, fabs(tMax));
+
+    return *limited ? remaining : h;
+}
+
+/***************************************************
+Explicit Euler
+****************************************************/
+
+static FMIStatus eulerStep(Solver *solver, fmi3Float64 tMax) {
+
+    FMIStatus status = FMIOK;
+
+    bool limited;
+    const fmi3Float64 h = limitStep(solver, solver->settings.fixedStep, tMax, &limited);
+
+    CALL(updateCurrentDerivatives(solver));
+
+    solver->tPrevious = solver->time;
+    memcpy(solver->xPrevious, solver->x, solver->nx * sizeof(fmi3Float64));
+
+    for (size_t i = 0; i < solver->nx; i++) {
+        solver->x[i] += h * solver->dx[i];
+    }
+
+    solver->time = limited ? tMax : solver->time + h;
+    solver->dxValid = false;
+
+    CALL(FMI3SetTime(solver->instance, solver->time));
+    CALL(FMI3SetContinuousStates(solver->instance, solver->x, solver->nx));
+
+    solver->statistics.nSteps++;
+
+TERMINATE:
+    return status;
+}
+
+static void eulerInterpolate(const Solver *solver, fmi3Float64 time, fmi3Float64 continuousStates[]) {
+
+    const fmi3Float64 h = solver->time - solver->tPrevious;
+    const fmi3Float64 theta = h > 0 ? (time - solver->tPrevious) / h : 1.0;
+
+    for (size_t i = 0; i < solver->nx; i++) {
+        continuousStates[i] = solver->xPrevious[i] + theta * (solver->x[i] - solver->xPrevious[i]);
+    }
+}
+
+/***************************************************
+Dormand-Prince 5(4)
+
+Coefficients and dense output from E. Hairer, S.P. Norsett, G. Wanner,
+"Solving Ordinary Differential Equations I", DOPRI5.
+****************************************************/
+
+static const fmi3Float64 c2 = 1.0 / 5, c3 = 3.0 / 10, c4 = 4.0 / 5, c5 = 8.0 / 9;
+
+static const fmi3Float64 a21 = 1.0 / 5;
+static const fmi3Float64 a31 = 3.0 / 40, a32 = 9.0 / 40;
+static const fmi3Float64 a41 = 44.0 / 45, a42 = -56.0 / 15, a43 = 32.0 / 9;
+static const fmi3Float64 a51 = 19372.0 / 6561, a52 = -25360.0 / 2187, a53 = 64448.0 / 6561, a54 = -212.0 / 729;
+static const fmi3Float64 a61 = 9017.0 / 3168, a62 = -355.0 / 33, a63 = 46732.0 / 5247, a64 = 49.0 / 176, a65 = -5103.0 / 18656;
+static const fmi3Float64 a71 = 35.0 / 384, a73 = 500.0 / 1113, a74 = 125.0 / 192, a75 = -2187.0 / 6784, a76 = 11.0 / 84;
+
+static const fmi3Float64 e1 = 71.0 / 57600, e3 = -71.0 / 16695, e4 = 71.0 / 1920, e5 = -17253.0 / 339200, e6 = 22.0 / 525, e7 = -1.0 / 40;
+
+static const fmi3Float64 d1 = -12715105075.0 / 11282082432, d3 = 87487479700.0 / 32700410799, d4 = -10690763975.0 / 1880347072,
+    d5 = 701980252875.0 / 199316789632, d6 = -1453857185.0 / 822651844, d7 = 69997945.0 / 29380423;
+
+static FMIStatus dormandPrinceStep(Solver *solver, fmi3Float64 tMax) {
+
+    FMIStatus status = FMIOK;
+
+    const size_t nx = solver->nx;
+    const fmi3Float64 rtol = solver->settings.tolerance;
+    const fmi3Float64 atol = solver->settings.tolerance;
+
+    fmi3Float64 *k2 = &solver->work[0 * nx];
+    fmi3Float64 *k3 = &solver->work[1 * nx];
+    fmi3Float64 *k4 = &solver->work[2 * nx];
+    fmi3Float64 *k5 = &solver->work[3 * nx];
+    fmi3Float64 *k6 = &solver->work[4 * nx];
+    fmi3Float64 *k7 = &solver->work[5 * nx];
+    fmi3Float64 *y  = &solver->work[6 * nx];
+    fmi3Float64 *y1 = &solver->work[7 * nx];
+
+    // first same as last: k1 is the derivative at the end of the previous step
+    CALL(updateCurrentDerivatives(solver));
+
+    const fmi3Float64 *x  = solver->x;
+    const fmi3Float64 *k1 = solver->dx;
+    const fmi3Float64 t = solver->time;
+
+    if (solver->h <= 0) {
+        solver->h = solver->settings.fixedStep;
+    }
+
+    for (;;) {
+
+        bool limited;
+        const fmi3Float64 h = limitStep(solver, fmin(solver->h, solver->settings.maxStep), tMax, &limited);
+        const fmi3Float64 tNew = limited ? tMax : t + h;
+
+        for (size_t i = 0; i < nx; i++) y[i] = x[i] + h * a21 * k1[i];
+        CALL(getDerivatives(solver, t + c2 * h, y, k2));
+
+        for (size_t i = 0; i < nx; i++) y[i] = x[i] + h * (a31 * k1[i] + a32 * k2[i]);
+        CALL(getDerivatives(solver, t + c3 * h, y, k3));
+
+        for (size_t i = 0; i < nx; i++) y[i] = x[i] + h * (a41 * k1[i] + a42 * k2[i] + a43 * k3[i]);
+        CALL(getDerivatives(solver, t + c4 * h, y, k4));
+
+        for (size_t i = 0; i < nx; i++) y[i] = x[i] + h * (a51 * k1[i] + a52 * k2[i] + a53 * k3[i] + a54 * k4[i]);
+        CALL(getDerivatives(solver, t + c5 * h, y, k5));
+
+        for (size_t i = 0; i < nx; i++) y[i] = x[i] + h * (a61 * k1[i] + a62 * k2[i] + a63 * k3[i] + a64 * k4[i] + a65 * k5[i]);
+        CALL(getDerivatives(solver, tNew, y, k6));
+
+        for (size_t i = 0; i < nx; i++) y1[i] = x[i] + h * (a71 * k1[i] + a73 * k3[i] + a74 * k4[i] + a75 * k5[i] + a76 * k6[i]);
+        CALL(getDerivatives(solver, tNew, y1, k7));
+
+        // scaled RMS norm of the difference to the embedded 4th order solution
+        fmi3Float64 err = 0.0;
+
+        for (size_t i = 0; i < nx; i++) {
+            const fmi3Float64 e = h * (e1 * k1[i] + e3 * k3[i] + e4 * k4[i] + e5 * k5[i] + e6 * k6[i] + e7 * k7[i]);
+            const fmi3Float64 sk = atol + rtol * fmax(fabs(x[i]), fabs(y1[i]));
+            err += (e / sk) * (e / sk);
+        }
+
+        err = nx > 0 ? sqrt(err / nx) : 0.0;
+
+        const fmi3Float64 factor = err > 0 ? fmin(MAX_STEP_FACTOR, fmax(MIN_STEP_FACTOR, SAFETY_FACTOR * pow(err, -0.2))) : MAX_STEP_FACTOR;
+
+        if (err <= 1.0) {
+
+            fmi3Float64 *rcont = solver->rcont;
+
+            for (size_t i = 0; i < nx; i++) {
+                const fmi3Float64 ydiff = y1[i] - x[i];
+                const fmi3Float64 bspl = h * k1[i] - ydiff;
+                rcont[0 * nx + i] = x[i];
+                rcont[1 * nx + i] = ydiff;
+                rcont[2 * nx + i] = bspl;
+                rcont[3 * nx + i] = ydiff - h * k7[i] - bspl;
+                rcont[4 * nx + i] = h * (d1 * k1[i] + d3 * k3[i] + d4 * k4[i] + d5 * k5[i] + d6 * k6[i] + d7 * k7[i]);
+            }
+
+            solver->tPrevious = t;
+            memcpy(solver->xPrevious, x, nx * sizeof(fmi3Float64));
+            memcpy(solver->x, y1, nx * sizeof(fmi3Float64));
+            memcpy(solver->dx, k7, nx * sizeof(fmi3Float64));
+
+            // the last evaluation left the FMU at (tNew, y1)
+            solver->time = tNew;
+            solver->dxValid = true;
+
+            // a step cut short by tMax must not shrink the following steps
+            solver->h = limited ? fmax(solver->h, h * factor) : h * factor;
+
+            solver->statistics.nSteps++;
+
+            break;
+        }
+
+        solver->statistics.nRejectedSteps++;
+
+        solver->h = h * factor;
+
+        if (solver->h < solver->settings.minStep) {
+            status = FMIError;
+            if (solver->instance->logMessage) {
+                solver->instance->logMessage(solver->instance, status, "Error", "Step size of the Dormand-Prince solver dropped below the minimum step size.");
+            }
+            goto TERMINATE;
+        }
+    }
+
+TERMINATE:
+    return status;
+}
+
+static void dormandPrinceInterpolate(const Solver *solver, fmi3Float64 time, fmi3Float64 continuousStates[]) {
+
+    const size_t nx = solver->nx;
+    const fmi3Float64 h = solver->time - solver->tPrevious;
+
+    if (h <= 0) {
+        memcpy(continuousStates, solver->x, nx * sizeof(fmi3Float64));
+        return;
+    }
+
+    const fmi3Float64 theta = (time - solver->tPrevious) / h;
+    const fmi3Float64 theta1 = 1.0 - theta;
+    const fmi3Float64 *rcont = solver->rcont;
+
+    for (size_t i = 0; i < nx; i++) {
+        continuousStates[i] = rcont[i] + theta * (rcont[nx + i] + theta1 * (rcont[2 * nx + i] + theta * (rcont[3 * nx + i] + theta1 * rcont[4 * nx + i])));
+    }
+}
+
+/***************************************************
+Rosenbrock 2(1)
+
+ROS2 from J.G. Verwer, E.J. Spee, J.G. Blom, W. Hundsdorfer, "A Second-Order
+Rosenbrock Method Applied to Photochemical Dispersion Problems", SIAM J. Sci.
+Comput. 20(4), 1999. The method is of second order for any approximation of
+the Jacobian, which allows to keep it over the steps. The derivative with
+respect to time is neglected, because the inputs are constant between events.
+The embedded first order solution is x + h * k1, the dense output a cubic
+Hermite polynomial.
+****************************************************/
+
+static const fmi3Float64 ros2Gamma = 1.0 + 0.70710678118654752440;
+
+// The step, and with it the iteration matrix, is kept if it would grow by less than this factor
+#define KEEP_STEP_FACTOR 1.2
+
+/* Decomposes the iteration matrix I - gamma * h * J unless it has already been decomposed for h. */
+static FMIStatus updateIterationMatrix(Solver *solver, fmi3Float64 h) {
+
+    const size_t nx = solver->nx;
+
+    if (solver->hLU == h) {
+        return FMIOK;
+    }
+
+    for (size_t i = 0; i < nx; i++) {
+        for (size_t j = 0; j < nx; j++) {
+            solver->lu[i * nx + j] = (i == j ? 1.0 : 0.0) - ros2Gamma * h * solver->jacobian[i * nx + j];
+        }
+    }
+
+    solver->statistics.nDecompositions++;
+
+    if (!decompose(nx, solver->lu, solver->pivots)) {
+        solver->hLU = 0;
+        if (solver->instance->logMessage) {
+            solver->instance->logMessage(solver->instance, FMIError, "Error", "The iteration matrix of the Rosenbrock solver is singular.");
+        }
+        return FMIError;
+    }
+
+    solver->hLU = h;
+
+    return FMIOK;
+}
+
+static FMIStatus rosenbrockStep(Solver *solver, fmi3Float64 tMax) {
+
+    FMIStatus status = FMIOK;
+
+    const size_t nx = solver->nx;
+    const fmi3Float64 rtol = solver->settings.tolerance;
+    const fmi3Float64 atol = solver->settings.tolerance;
+
+    fmi3Float64 *k1  = &solver->work[0 * nx];
+    fmi3Float64 *k2  = &solver->work[1 * nx];
+    fmi3Float64 *y1  = &solver->work[2 * nx];
+    fmi3Float64 *dx1 = &solver->work[3 * nx];
+
+    CALL(updateCurrentDerivatives(solver));
+
+    const fmi3Float64 *x  = solver->x;
+    const fmi3Float64 *f0 = solver->dx;
+    const fmi3Float64 t = solver->time;
+
+    bool jacobianUpdated = false;
+
+    if (!solver->jacobianValid) {
+        CALL(updateJacobian(solver));
+        jacobianUpdated = true;
+    }
+
+    if (solver->h <= 0) {
+        solver->h = solver->settings.fixedStep;
+    }
+
+    for (;;) {
+
+        bool limited;
+        const fmi3Float64 h = limitStep(solver, fmin(solver->h, solver->settings.maxStep), tMax, &limited);
+        const fmi3Float64 tNew = limited ? tMax : t + h;
+
+        CALL(updateIterationMatrix(solver, h));
+
+        // (I - gamma * h * J) k1 = f(t, x)
+        memcpy(k1, f0, nx * sizeof(fmi3Float64));
+        solve(nx, solver->lu, solver->pivots, k1);
+
+        // (I - gamma * h * J) k2 = f(t + h, x + h * k1) - 2 * k1
+        for (size_t i = 0; i < nx; i++) y1[i] = x[i] + h * k1[i];
+        CALL(getDerivatives(solver, tNew, y1, k2));
+
+        for (size_t i = 0; i < nx; i++) k2[i] -= 2.0 * k1[i];
+        solve(nx, solver->lu, solver->pivots, k2);
+
+        for (size_t i = 0; i < nx; i++) y1[i] = x[i] + h * (1.5 * k1[i] + 0.5 * k2[i]);
+
+        // scaled RMS norm of the difference to the embedded 1st order solution
+        fmi3Float64 err = 0.0;
+
+        for (size_t i = 0; i < nx; i++) {
+            const fmi3Float64 e = 0.5 * h * (k1[i] + k2[i]);
+            const fmi3Float64 sk = atol + rtol * fmax(fabs(x[i]), fabs(y1[i]));
+            err += (e / sk) * (e / sk);
+        }
+
+        err = nx > 0 ? sqrt(err / nx) : 0.0;
+
+        const fmi3Float64 factor = err > 0 ? fmin(MAX_STEP_FACTOR, fmax(MIN_STEP_FACTOR, SAFETY_FACTOR / sqrt(err))) : MAX_STEP_FACTOR;
+
+        if (err <= 1.0) {
+
+            // derivatives at the end for the dense output and the next step, leaves the FMU at (tNew, y1)
+            CALL(getDerivatives(solver, tNew, y1, dx1));
+
+            fmi3Float64 *rcont = solver->rcont;
+
+            for (size_t i = 0; i < nx; i++) {
+                rcont[0 * nx + i] = x[i];
+                rcont[1 * nx + i] = y1[i] - x[i];
+                rcont[2 * nx + i] = h * f0[i];
+                rcont[3 * nx + i] = h * dx1[i];
+            }
+
+            solver->tPrevious = t;
+            memcpy(solver->xPrevious, x, nx * sizeof(fmi3Float64));
+            memcpy(solver->x, y1, nx * sizeof(fmi3Float64));
+            memcpy(solver->dx, dx1, nx * sizeof(fmi3Float64));
+
+            solver->time = tNew;
+            solver->dxValid = true;
+
+            const fmi3Float64 hNew = factor >= 1.0 && factor < KEEP_STEP_FACTOR ? h : h * factor;
+
+            // a step cut short by tMax must not shrink the following steps
+            solver->h = limited ? fmax(solver->h, hNew) : hNew;
+
+            solver->statistics.nSteps++;
+
+            break;
+        }
+
+        solver->statistics.nRejectedSteps++;
+
+        solver->h = h * factor;
+
+        if (solver->h < solver->settings.minStep) {
+            status = FMIError;
+            if (solver->instance->logMessage) {
+                solver->instance->logMessage(solver->instance, status, "Error", "Step size of the Rosenbrock solver dropped below the minimum step size.");
+            }
+            goto TERMINATE;
+        }
+
+        // the rejection may be caused by a Jacobian from an earlier step
+        if (!jacobianUpdated) {
+            CALL(updateJacobian(solver));
+            jacobianUpdated = true;
+        }
+    }
+
+TERMINATE:
+    return status;
+}
+
+static void rosenbrockInterpolate(const Solver *solver, fmi3Float64 time, fmi3Float64 continuousStates[]) {
+
+    const size_t nx = solver->nx;
+    const fmi3Float64 h = solver->time - solver->tPrevious;
+
+    if (h <= 0) {
+        memcpy(continuousStates, solver->x, nx * sizeof(fmi3Float64));
+        return;
+    }
+
+    const fmi3Float64 theta = (time - solver->tPrevious) / h;
+    const fmi3Float64 *rcont = solver->rcont;
+
+    for (size_t i = 0; i < nx; i++) {
+        const fmi3Float64 ydiff = rcont[nx + i];
+        continuousStates[i] = rcont[i] + theta * ydiff
+            + theta * (theta - 1.0) * ((1.0 - 2.0 * theta) * ydiff + (theta - 1.0) * rcont[2 * nx + i] + theta * rcont[3 * nx + i]);
+    }
+}
+
+static const SolverMethod methods[] = {
+    { SolverEuler,         "euler", 0, false, eulerStep,         eulerInterpolate         },
+    { SolverDormandPrince, "rk45",  8, false, dormandPrinceStep, dormandPrinceInterpolate },
+    { SolverRosenbrock,    "ros2",  4, true,  rosenbrockStep,    rosenbrockInterpolate    },
+};
+
+/***************************************************
+Solver API
+****************************************************/
+
+Solver* SolverCreate(FMIInstance *instance, size_t nContinuousStates, const SolverSettings *settings) {
+
+    const SolverMethod *method = NULL;
+
+    for (size_t i = 0; i < sizeof(methods) / sizeof(methods[0]); i++) {
+        if (methods[i].type == settings->type) {
+            method = &methods[i];
+        }
+    }
+
+    if (!method) {
+        return NULL;
+    }
+
+    Solver *solver = (Solver*)calloc(1, sizeof(Solver));
+
+    if (!solver) {
+        return NULL;
+    }
+
+    const size_t nx = nContinuousStates;
+
+    solver->instance  = instance;
+    solver->method    = method;
+    solver->settings  = *settings;
+    solver->nx        = nx;
+    solver->x         = (fmi3Float64*)calloc(nx + 1, sizeof(fmi3Float64));
+    solver->xPrevious = (fmi3Float64*)calloc(nx + 1, sizeof(fmi3Float64));
+    solver->dx        = (fmi3Float64*)calloc(nx + 1, sizeof(fmi3Float64));
+    solver->work      = (fmi3Float64*)calloc(method->nWorkVectors * nx + 1, sizeof(fmi3Float64));
+    solver->rcont     = (fmi3Float64*)calloc(5 * nx + 1, sizeof(fmi3Float64));
+
+    if (!solver->x || !solver->xPrevious || !solver->dx || !solver->work || !solver->rcont) {
+        SolverFree(solver);
+        return NULL;
+    }
+
+    if (!method->implicit) {
+        return solver;
+    }
+
+    solver->pattern      = (bool*)calloc(nx * nx + 1, sizeof(bool));
+    solver->colors       = (size_t*)calloc(nx + 1, sizeof(size_t));
+    solver->jacobian     = (fmi3Float64*)calloc(nx * nx + 1, sizeof(fmi3Float64));
+    solver->jacobianWork = (fmi3Float64*)calloc(2 * nx + 1, sizeof(fmi3Float64));
+    solver->lu           = (fmi3Float64*)calloc(nx * nx + 1, sizeof(fmi3Float64));
+    solver->pivots       = (size_t*)calloc(nx + 1, sizeof(size_t));
+
+    if (!solver->pattern || !solver->colors || !solver->jacobian || !solver->jacobianWork || !solver->lu || !solver->pivots) {
+        SolverFree(solver);
+        return NULL;
+    }
+
+    if (settings->stateReferences && settings->derivativeReferences) {
+
+        solver->stateReferences      = (fmi3ValueReference*)calloc(nx + 1, sizeof(fmi3ValueReference));
+        solver->derivativeReferences = (fmi3ValueReference*)calloc(nx + 1, sizeof(fmi3ValueReference));
+
+        if (!solver->stateReferences || !solver->derivativeReferences) {
+            SolverFree(solver);
+            return NULL;
+        }
+
+        memcpy(solver->stateReferences, settings->stateReferences, nx * sizeof(fmi3ValueReference));
+        memcpy(solver->derivativeReferences, settings->derivativeReferences, nx * sizeof(fmi3ValueReference));
+    }
+
+    for (size_t i = 0; i < nx * nx; i++) {
+        solver->pattern[i] = settings->jacobianPattern ? settings->jacobianPattern[i] : true;
+    }
+
+    solver->nColors = colorColumns(nx, solver->pattern, solver->colors);
+
+    // the settings must not refer to the arrays of the caller
+    solver->settings.stateReferences = NULL;
+    solver->settings.derivativeReferences = NULL;
+    solver->settings.jacobianPattern = NULL;
+
+    return solver;
+}
+
+void SolverFree(Solver *solver) {
+
+    if (!solver) {
+        return;
+    }
+
+    free(solver->x);
+    free(solver->xPrevious);
+    free(solver->dx);
+    free(solver->work);
+    free(solver->rcont);
+    free(solver->stateReferences);
+    free(solver->derivativeReferences);
+    free(solver->pattern);
+    free(solver->colors);
+    free(solver->jacobian);
+    free(solver->jacobianWork);
+    free(solver->lu);
+    free(solver->pivots);
+    free(solver);
+}
+
+FMIStatus SolverReset(Solver *solver, fmi3Float64 time) {
+
+    FMIStatus status = FMIOK;
+
+    CALL(FMI3GetContinuousStates(solver->instance, solver->x, solver->nx));
+
+    memcpy(solver->xPrevious, solver->x, solver->nx * sizeof(fmi3Float64));
+
+    solver->time = time;
+    solver->tPrevious = time;
+    solver->dxValid = false;
+    solver->jacobianValid = false;
+
+TERMINATE:
+    return status;
+}
+
+FMIStatus SolverStep(Solver *solver, fmi3Float64 tMax, fmi3Float64 *tReached) {
+
+    FMIStatus status = solver->method->step(solver, tMax);
+
+    *tReached = solver->time;
+
+    return status;
+}
+
+void SolverInterpolate(const Solver *solver, fmi3Float64 time, fmi3Float64 continuousStates[]) {
+    solver->method->interpolate(solver, time, continuousStates);
+}
+
+const SolverStatistics* SolverGetStatistics(const Solver *solver) {
+    return &solver->statistics;
+}
+
+bool SolverTypeFromString(const char *name, SolverType *type) {
+
+    for (size_t i = 0; i < sizeof(methods) / sizeof(methods[0]); i++) {
+        if (!strcmp(methods[i].name, name)) {
+            *type = methods[i].type;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+const char* SolverTypeToString(SolverType type) {
+
+    for (size_t i = 0; i < sizeof(methods) / sizeof(methods[0]); i++) {
+        if (methods[i].type == type) {
+            return methods[i].name;
+        }
+    }
+
+    return "unknown";
+}
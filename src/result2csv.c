@@ -0,0 +1,171 @@
+/*
+Converts a binary result file of the examples to CSV, see result_sink.h.
+
+    synchronous_control_cs
+    result2csv synchronous_control_cs_out.res synchronous_control_cs_out.csv
+
+The Float64 values are written with 17 significant digits, so they are read back
+exactly. --precision=<digits> rounds them, e.g. --precision=6 like "%g".
+Without a CSV file the values are written to the standard output, and the
+messages to the standard error.
+*/
+
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+
+#include "result_sink.h"
+
+#define DEFAULT_PRECISION 17
+
+int main(int argc, char *argv[])
+{
+    const char* resultPath = NULL;
+    const char* csvPath = NULL;
+    int precision = DEFAULT_PRECISION;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strncmp(argv[i], "--precision=", 12)) {
+            precision = atoi(&argv[i][12]);
+        } else if (!resultPath) {
+            resultPath = argv[i];
+        } else if (!csvPath) {
+            csvPath = argv[i];
+        } else {
+            resultPath = NULL;
+            break;
+        }
+    }
+
+    if (!resultPath || precision < 1 || precision > DEFAULT_PRECISION) {
+        fprintf(stderr, "Usage: result2csv [--precision=<digits>] <result file> [<CSV file>]\n");
+        return EXIT_FAILURE;
+    }
+
+    int exitCode = EXIT_FAILURE;
+    ResultFileHeader header;
+    ResultChunkHeader chunkHeader;
+    ResultColumn* columns = NULL;
+    uint8_t** blocks = NULL;
+    FILE* csvFile = NULL;
+    uint64_t nRows = 0;
+
+    memset(&header, 0, sizeof(header));
+
+    FILE* resultFile = fopen(resultPath, "rb");
+
+    if (!resultFile) {
+        fprintf(stderr, "Failed to open %s.\n", resultPath);
+        return EXIT_FAILURE;
+    }
+
+    if (fread(&header, sizeof(header), 1, resultFile) != 1 ||
+        memcmp(header.magic, RESULT_FILE_MAGIC, sizeof(RESULT_FILE_MAGIC)) ||
+        header.version != RESULT_FILE_VERSION ||
+        header.chunkSize == 0) {
+        fprintf(stderr, "%s is not a result file.\n", resultPath);
+        goto TERMINATE;
+    }
+
+    columns = (ResultColumn*)calloc(header.nColumns + 1, sizeof(ResultColumn));
+    blocks = (uint8_t**)calloc(header.nColumns + 1, sizeof(uint8_t*));
+
+    if (!columns || !blocks || fread(columns, sizeof(ResultColumn), header.nColumns, resultFile) != header.nColumns) {
+        fprintf(stderr, "Failed to read the columns of %s.\n", resultPath);
+        goto TERMINATE;
+    }
+
+    for (size_t i = 0; i < header.nColumns; i++) {
+
+        columns[i].name[RESULT_MAX_NAME_LENGTH - 1] = '\0';
+
+        if (columns[i].type != ResultFloat64 && columns[i].type != ResultInt32) {
+            fprintf(stderr, "Column %s has an unknown type.\n", columns[i].name);
+            goto TERMINATE;
+        }
+
+        blocks[i] = (uint8_t*)malloc(ResultColumnBlockSize((ResultColumnType)columns[i].type, header.chunkSize));
+
+        if (!blocks[i]) {
+            fprintf(stderr, "Failed to allocate the chunks.\n");
+            goto TERMINATE;
+        }
+    }
+
+    csvFile = csvPath ? fopen(csvPath, "w") : stdout;
+
+    if (!csvFile) {
+        fprintf(stderr, "Failed to open %s.\n", csvPath);
+        goto TERMINATE;
+    }
+
+    for (size_t i = 0; i < header.nColumns; i++) {
+        fprintf(csvFile, i == 0 ? "%s" : ",%s", columns[i].name);
+    }
+
+    fputc('\n', csvFile);
+
+    while (fread(&chunkHeader, sizeof(chunkHeader), 1, resultFile) == 1) {
+
+        if (chunkHeader.nRows == 0 || chunkHeader.nRows > header.chunkSize) {
+            fprintf(stderr, "Chunk at row %" PRIu64 " is corrupt.\n", nRows);
+            goto TERMINATE;
+        }
+
+        for (size_t i = 0; i < header.nColumns; i++) {
+
+            const size_t blockSize = ResultColumnBlockSize((ResultColumnType)columns[i].type, chunkHeader.nRows);
+
+            if (fread(blocks[i], 1, blockSize, resultFile) != blockSize) {
+                fprintf(stderr, "Chunk at row %" PRIu64 " is truncated.\n", nRows);
+                goto TERMINATE;
+            }
+        }
+
+        for (size_t row = 0; row < chunkHeader.nRows; row++) {
+
+            for (size_t i = 0; i < header.nColumns; i++) {
+
+                if (i > 0) {
+                    fputc(',', csvFile);
+                }
+
+                if (columns[i].type == ResultInt32) {
+                    fprintf(csvFile, "%d", ((const fmi3Int32*)blocks[i])[row]);
+                } else {
+                    fprintf(csvFile, "%.*g", precision, ((const fmi3Float64*)blocks[i])[row]);
+                }
+            }
+
+            fputc('\n', csvFile);
+        }
+
+        nRows += chunkHeader.nRows;
+    }
+
+    if (ferror(resultFile)) {
+        fprintf(stderr, "Failed to read %s.\n", resultPath);
+        goto TERMINATE;
+    }
+
+    exitCode = EXIT_SUCCESS;
+
+TERMINATE:
+
+    for (size_t i = 0; i < header.nColumns && blocks; i++) {
+        free(blocks[i]);
+    }
+
+    free(blocks);
+    free(columns);
+
+    if (csvFile && csvFile != stdout) {
+        fclose(csvFile);
+    }
+
+    fclose(resultFile);
+
+    return exitCode;
+}
@@ -0,0 +1,441 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+
+#include "result_sink.h"
+#include "threading.h"
+
+#if defined(_MSC_VER) && !defined(__clang__)
+// the Interlocked functions are full barriers
+typedef volatile LONG64 Atomic;
+#define ATOMIC_LOAD(a, order)      ((uint64_t)InterlockedCompareExchange64(a, 0, 0))
+#define ATOMIC_STORE(a, v, order)  InterlockedExchange64(a, (LONG64)(v))
+#define ATOMIC_FENCE()             MemoryBarrier()
+#else
+#include <stdatomic.h>
+typedef _Atomic uint64_t Atomic;
+#define ATOMIC_LOAD(a, order)      atomic_load_explicit(a, memory_order_##order)
+#define ATOMIC_STORE(a, v, order)  atomic_store_explicit(a, v, memory_order_##order)
+#define ATOMIC_FENCE()             atomic_thread_fence(memory_order_seq_cst)
+#endif
+
+#define CACHE_LINE_SIZE 64
+
+// A value of a row in the ring
+typedef union {
+    fmi3Float64 float64;
+    fmi3Int32 int32;
+} ResultValue;
+
+struct ResultSink_ {
+
+    FILE *file;
+
+    size_t nColumns;
+    ResultColumnType *types;
+
+    // current chunk, owned by the writer
+    size_t chunkSize;
+    size_t nRows;
+    uint8_t **columns;  // chunkSize values per column
+
+    // ring of nColumns values per row, a single row without writer thread
+    size_t ringSize;  // power of 2
+    ResultValue *ring;
+    ResultValue *row;  // being recorded
+
+    // producer
+    uint64_t nRecorded;
+    uint64_t cachedWritten;
+    uint64_t wakeThreshold;  // number of pending rows to wake the writer
+
+    bool asynchronous;
+    Thread thread;
+    Mutex mutex;
+    Condition writerCondition;
+    Condition producerCondition;
+
+    // guarded by mutex
+    bool flushRequested;
+    bool shutdown;
+
+    // head and tail of the ring on separate cache lines
+    char padding0[CACHE_LINE_SIZE];
+    Atomic recorded;
+    char padding1[CACHE_LINE_SIZE];
+    Atomic written;
+    char padding2[CACHE_LINE_SIZE];
+
+    Atomic writerSleeping;
+    Atomic producerWaiting;
+    Atomic status;  // FMIStatus of the writes
+};
+
+size_t ResultColumnTypeSize(ResultColumnType type) {
+    return type == ResultInt32 ? sizeof(fmi3Int32) : sizeof(fmi3Float64);
+}
+
+size_t ResultColumnBlockSize(ResultColumnType type, size_t nRows) {
+    return (ResultColumnTypeSize(type) * nRows + 7) & ~(size_t)7;
+}
+
+static void setStatus(ResultSink *sink, FMIStatus status) {
+    if (status > (FMIStatus)ATOMIC_LOAD(&sink->status, relaxed)) {
+        ATOMIC_STORE(&sink->status, status, relaxed);
+    }
+}
+
+// Writes the rows of the current chunk
+static void writeChunk(ResultSink *sink) {
+
+    static const uint8_t padding[8] = { 0 };
+
+    if (sink->nRows == 0) {
+        return;
+    }
+
+    ResultChunkHeader header;
+
+    memset(&header, 0, sizeof(header));
+    header.nRows = (uint32_t)sink->nRows;
+
+    bool success = fwrite(&header, sizeof(header), 1, sink->file) == 1;
+
+    for (size_t i = 0; i < sink->nColumns && success; i++) {
+
+        const size_t size = ResultColumnTypeSize(sink->types[i]) * sink->nRows;
+        const size_t blockSize = ResultColumnBlockSize(sink->types[i], sink->nRows);
+
+        success = fwrite(sink->columns[i], 1, size, sink->file) == size &&
+            fwrite(padding, 1, blockSize - size, sink->file) == blockSize - size;
+    }
+
+    sink->nRows = 0;
+
+    if (!success) {
+        setStatus(sink, FMIError);
+    }
+}
+
+// Copies a row into the columns of the current chunk and writes the chunk when it is full
+static void appendRow(ResultSink *sink, const ResultValue *row) {
+
+    for (size_t i = 0; i < sink->nColumns; i++) {
+        if (sink->types[i] == ResultInt32) {
+            ((fmi3Int32*)sink->columns[i])[sink->nRows] = row[i].int32;
+        } else {
+            ((fmi3Float64*)sink->columns[i])[sink->nRows] = row[i].float64;
+        }
+    }
+
+    sink->nRows++;
+
+    if (sink->nRows == sink->chunkSize) {
+        writeChunk(sink);
+    }
+}
+
+// Appends the recorded rows, a chunk at a time, and releases their slots
+static void drainRing(ResultSink *sink) {
+
+    const uint64_t recorded = ATOMIC_LOAD(&sink->recorded, acquire);
+    uint64_t written = ATOMIC_LOAD(&sink->written, relaxed);
+
+    while (written != recorded) {
+
+        do {
+            appendRow(sink, &sink->ring[(written & (sink->ringSize - 1)) * sink->nColumns]);
+            written++;
+        } while (written != recorded && sink->nRows != 0);
+
+        ATOMIC_STORE(&sink->written, written, release);
+
+        ATOMIC_FENCE();
+
+        if (ATOMIC_LOAD(&sink->producerWaiting, relaxed)) {
+            MUTEX_LOCK(&sink->mutex);
+            COND_BROADCAST(&sink->producerCondition);
+            MUTEX_UNLOCK(&sink->mutex);
+        }
+    }
+}
+
+static void writeRows(ResultSink *sink) {
+
+    for (;;) {
+
+        drainRing(sink);
+
+        MUTEX_LOCK(&sink->mutex);
+
+        if (sink->flushRequested || sink->shutdown) {
+
+            const bool shutdown = sink->shutdown;
+
+            MUTEX_UNLOCK(&sink->mutex);
+
+            // the rows recorded before the request
+            drainRing(sink);
+            writeChunk(sink);
+
+            if (fflush(sink->file)) {
+                setStatus(sink, FMIError);
+            }
+
+            MUTEX_LOCK(&sink->mutex);
+            sink->flushRequested = false;
+            COND_BROADCAST(&sink->producerCondition);
+            MUTEX_UNLOCK(&sink->mutex);
+
+            if (shutdown) {
+                return;
+            }
+
+            continue;
+        }
+
+        // sleep until the producer has recorded wakeThreshold rows
+        ATOMIC_STORE(&sink->writerSleeping, 1, seq_cst);
+
+        ATOMIC_FENCE();
+
+        const uint64_t pending = ATOMIC_LOAD(&sink->recorded, seq_cst) - ATOMIC_LOAD(&sink->written, relaxed);
+
+        if (pending < sink->wakeThreshold) {
+            while (ATOMIC_LOAD(&sink->writerSleeping, relaxed) && !sink->flushRequested && !sink->shutdown) {
+                COND_WAIT(&sink->writerCondition, &sink->mutex);
+            }
+        }
+
+        ATOMIC_STORE(&sink->writerSleeping, 0, relaxed);
+
+        MUTEX_UNLOCK(&sink->mutex);
+    }
+}
+
+static ThreadResult THREAD_CALL threadMain(void *argument) {
+    writeRows((ResultSink*)argument);
+    return 0;
+}
+
+static void wakeWriter(ResultSink *sink) {
+    MUTEX_LOCK(&sink->mutex);
+    ATOMIC_STORE(&sink->writerSleeping, 0, relaxed);
+    COND_BROADCAST(&sink->writerCondition);
+    MUTEX_UNLOCK(&sink->mutex);
+}
+
+ResultSink* ResultSinkCreate(const char *path, size_t nColumns, const char *const names[], const ResultColumnType types[], size_t chunkSize, size_t ringSize) {
+
+    if (chunkSize == 0 || chunkSize > UINT32_MAX) {
+        return NULL;
+    }
+
+    ResultSink *sink = (ResultSink*)calloc(1, sizeof(ResultSink));
+
+    if (!sink) {
+        return NULL;
+    }
+
+    sink->nColumns = nColumns;
+    sink->chunkSize = chunkSize;
+    sink->types = (ResultColumnType*)calloc(nColumns + 1, sizeof(ResultColumnType));
+    sink->columns = (uint8_t**)calloc(nColumns + 1, sizeof(uint8_t*));
+
+    // without a writer thread the row is appended when it is complete
+    sink->ringSize = 1;
+
+    while (ringSize > 1 && sink->ringSize < ringSize) {
+        sink->ringSize <<= 1;
+    }
+
+    sink->ring = (ResultValue*)calloc(sink->ringSize * nColumns + 1, sizeof(ResultValue));
+    sink->row = sink->ring;
+
+    if (!sink->types || !sink->columns || !sink->ring) {
+        ResultSinkFree(sink);
+        return NULL;
+    }
+
+    for (size_t i = 0; i < nColumns; i++) {
+
+        sink->types[i] = types[i];
+        sink->columns[i] = (uint8_t*)malloc(ResultColumnBlockSize(types[i], chunkSize));
+
+        if (!sink->columns[i]) {
+            ResultSinkFree(sink);
+            return NULL;
+        }
+    }
+
+    sink->file = fopen(path, "wb");
+
+    if (!sink->file) {
+        ResultSinkFree(sink);
+        return NULL;
+    }
+
+    ResultFileHeader header;
+
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, RESULT_FILE_MAGIC, sizeof(RESULT_FILE_MAGIC));
+    header.version   = RESULT_FILE_VERSION;
+    header.nColumns  = (uint32_t)nColumns;
+    header.chunkSize = (uint32_t)chunkSize;
+
+    bool success = fwrite(&header, sizeof(header), 1, sink->file) == 1;
+
+    for (size_t i = 0; i < nColumns && success; i++) {
+
+        ResultColumn column;
+
+        memset(&column, 0, sizeof(column));
+        strncpy(column.name, names[i], RESULT_MAX_NAME_LENGTH - 1);
+        column.type = (uint32_t)types[i];
+
+        success = fwrite(&column, sizeof(column), 1, sink->file) == 1;
+    }
+
+    if (!success) {
+        ResultSinkFree(sink);
+        return NULL;
+    }
+
+    if (sink->ringSize == 1) {
+        return sink;
+    }
+
+    // wake the writer when a chunk is pending, or half of the ring is full
+    sink->wakeThreshold = sink->ringSize / 2 < chunkSize ? sink->ringSize / 2 : chunkSize;
+
+    MUTEX_INIT(&sink->mutex);
+    COND_INIT(&sink->writerCondition);
+    COND_INIT(&sink->producerCondition);
+
+    sink->asynchronous = THREAD_CREATE(&sink->thread, threadMain, sink);
+
+    if (!sink->asynchronous) {
+        COND_DESTROY(&sink->writerCondition);
+        COND_DESTROY(&sink->producerCondition);
+        MUTEX_DESTROY(&sink->mutex);
+        ResultSinkFree(sink);
+        return NULL;
+    }
+
+    return sink;
+}
+
+void ResultSinkFree(ResultSink *sink) {
+
+    if (!sink) {
+        return;
+    }
+
+    if (sink->asynchronous) {
+
+        MUTEX_LOCK(&sink->mutex);
+        sink->shutdown = true;
+        COND_BROADCAST(&sink->writerCondition);
+        MUTEX_UNLOCK(&sink->mutex);
+
+        THREAD_JOIN(sink->thread);
+
+        COND_DESTROY(&sink->writerCondition);
+        COND_DESTROY(&sink->producerCondition);
+        MUTEX_DESTROY(&sink->mutex);
+
+    } else if (sink->file) {
+        writeChunk(sink);
+    }
+
+    if (sink->file) {
+        fclose(sink->file);
+    }
+
+    for (size_t i = 0; i < sink->nColumns && sink->columns; i++) {
+        free(sink->columns[i]);
+    }
+
+    free(sink->columns);
+    free(sink->ring);
+    free(sink->types);
+    free(sink);
+}
+
+void ResultSinkSetFloat64(ResultSink *sink, size_t column, fmi3Float64 value) {
+    sink->row[column].float64 = value;
+}
+
+void ResultSinkSetInt32(ResultSink *sink, size_t column, fmi3Int32 value) {
+    sink->row[column].int32 = value;
+}
+
+FMIStatus ResultSinkEndRow(ResultSink *sink) {
+
+    if (!sink->asynchronous) {
+        appendRow(sink, sink->row);
+        return (FMIStatus)ATOMIC_LOAD(&sink->status, relaxed);
+    }
+
+    const uint64_t recorded = ++sink->nRecorded;
+
+    ATOMIC_STORE(&sink->recorded, recorded, release);
+
+    if (recorded - sink->cachedWritten >= sink->wakeThreshold) {
+
+        sink->cachedWritten = ATOMIC_LOAD(&sink->written, acquire);
+
+        if (recorded - sink->cachedWritten >= sink->wakeThreshold) {
+
+            ATOMIC_FENCE();
+
+            if (ATOMIC_LOAD(&sink->writerSleeping, relaxed)) {
+                wakeWriter(sink);
+            }
+        }
+    }
+
+    // wait for the writer to release a slot when the ring is full
+    if (recorded - sink->cachedWritten == sink->ringSize) {
+
+        MUTEX_LOCK(&sink->mutex);
+
+        ATOMIC_STORE(&sink->producerWaiting, 1, seq_cst);
+
+        ATOMIC_FENCE();
+
+        while (recorded - (sink->cachedWritten = ATOMIC_LOAD(&sink->written, acquire)) == sink->ringSize) {
+            COND_WAIT(&sink->producerCondition, &sink->mutex);
+        }
+
+        ATOMIC_STORE(&sink->producerWaiting, 0, relaxed);
+
+        MUTEX_UNLOCK(&sink->mutex);
+    }
+
+    sink->row = &sink->ring[(recorded & (sink->ringSize - 1)) * sink->nColumns];
+
+    return (FMIStatus)ATOMIC_LOAD(&sink->status, relaxed);
+}
+
+FMIStatus ResultSinkFlush(ResultSink *sink) {
+
+    if (!sink->asynchronous) {
+        writeChunk(sink);
+        return fflush(sink->file) ? FMIError : (FMIStatus)ATOMIC_LOAD(&sink->status, relaxed);
+    }
+
+    MUTEX_LOCK(&sink->mutex);
+
+    sink->flushRequested = true;
+    COND_BROADCAST(&sink->writerCondition);
+
+    while (sink->flushRequested) {
+        COND_WAIT(&sink->producerCondition, &sink->mutex);
+    }
+
+    MUTEX_UNLOCK(&sink->mutex);
+
+    return (FMIStatus)ATOMIC_LOAD(&sink->status, relaxed);
+}
@@ -0,0 +1,764 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+
+#include "scheduler.h"
+#include "connection_plan.h"
+
+#define CALL(f) do { status = f; if (status > FMIOK) goto TERMINATE; } while (0)
+
+#define NOT_FOUND ((size_t)-1)
+
+// Maximum number of calls to FMI3UpdateDiscreteStates at one event
+#define MAX_EVENT_ITERATIONS 100
+
+typedef struct {
+    FMIInstance *instance;
+    ModelDescription *modelDescription;
+    bool event;     // signalled a state event or its time event is due
+    bool touched;
+    bool nextEventTimeDefined;
+    fmi3Float64 nextEventTime;
+} SchedulerInstance;
+
+typedef struct {
+    size_t instance;
+    const ModelVariable *clock;
+    bool candidate;  // may tick at the current event
+    bool active;     // ticks at the current event
+    bool pending;    // activated by the master, the clock has not been set yet
+    ConnectionPlan *plan;  // clocked variables that are propagated when the partition is active
+} Partition;
+
+struct Scheduler_ {
+
+    size_t nInstances;
+    SchedulerInstance *instances;
+
+    size_t nPartitions;
+    Partition *partitions;
+
+    size_t nConnections;
+    Connection *connections;
+
+    // topological orders
+    size_t *instanceOrder;
+    size_t *partitionOrder;
+};
+
+static void logError(FMIInstance *instance, const char *format, const char *name) {
+
+    char message[FMI_MAX_MESSAGE_LENGTH];
+
+    snprintf(message, FMI_MAX_MESSAGE_LENGTH, format, name);
+
+    if (instance->logMessage) {
+        instance->logMessage(instance, FMIError, "logStatusError", message);
+    }
+}
+
+static size_t findInstance(const Scheduler *scheduler, const char *name, size_t length) {
+
+    for (size_t i = 0; i < scheduler->nInstances; i++) {
+        const char *instanceName = scheduler->instances[i].instance->name;
+        if (strlen(instanceName) == length && !strncmp(instanceName, name, length)) {
+            return i;
+        }
+    }
+
+    return NOT_FOUND;
+}
+
+/* Resolves "<instance name>.<variable name>". */
+static const ModelVariable* findVariable(const Scheduler *scheduler, const char *name, size_t *instance) {
+
+    const char *separator = strchr(name, '.');
+
+    if (!separator) {
+        return NULL;
+    }
+
+    *instance = findInstance(scheduler, name, separator - name);
+
+    if (*instance == NOT_FOUND) {
+        return NULL;
+    }
+
+    return ModelDescriptionFindVariable(scheduler->instances[*instance].modelDescription, separator + 1);
+}
+
+static size_t findPartition(const Scheduler *scheduler, size_t instance, fmi3ValueReference clock) {
+
+    for (size_t i = 0; i < scheduler->nPartitions; i++) {
+        if (scheduler->partitions[i].instance == instance && scheduler->partitions[i].clock->valueReference == clock) {
+            return i;
+        }
+    }
+
+    return NOT_FOUND;
+}
+
+static bool isClockedBy(const ModelVariable *variable, const ModelVariable *clock) {
+
+    for (size_t i = 0; i < variable->nClocks; i++) {
+        if (variable->clocks[i] == clock->valueReference) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/* Kahn's algorithm. Among the nodes without predecessors the one with the lowest rank comes first. */
+static bool sortTopologically(size_t n, const bool *edges, const size_t *rank, size_t *order) {
+
+    bool success = false;
+
+    size_t *nPredecessors = (size_t*)calloc(n + 1, sizeof(size_t));
+    bool *done = (bool*)calloc(n + 1, sizeof(bool));
+
+    if (!nPredecessors || !done) {
+        goto TERMINATE;
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        for (size_t j = 0; j < n; j++) {
+            if (edges[i * n + j]) {
+                nPredecessors[j]++;
+            }
+        }
+    }
+
+    for (size_t k = 0; k < n; k++) {
+
+        size_t next = NOT_FOUND;
+
+        for (size_t i = 0; i < n; i++) {
+            if (!done[i] && nPredecessors[i] == 0 && (next == NOT_FOUND || rank[i] < rank[next])) {
+                next = i;
+            }
+        }
+
+        if (next == NOT_FOUND) {
+            goto TERMINATE;  // cycle
+        }
+
+        done[next] = true;
+        order[k] = next;
+
+        for (size_t j = 0; j < n; j++) {
+            if (edges[next * n + j]) {
+                nPredecessors[j]--;
+            }
+        }
+    }
+
+    success = true;
+
+TERMINATE:
+    free(nPredecessors);
+    free(done);
+
+    return success;
+}
+
+Scheduler* SchedulerCreate(void) {
+    return (Scheduler*)calloc(1, sizeof(Scheduler));
+}
+
+void SchedulerFree(Scheduler *scheduler) {
+
+    if (!scheduler) {
+        return;
+    }
+
+    for (size_t i = 0; i < scheduler->nInstances; i++) {
+        ModelDescriptionFree(scheduler->instances[i].modelDescription);
+    }
+
+    for (size_t i = 0; i < scheduler->nPartitions; i++) {
+        ConnectionPlanFree(scheduler->partitions[i].plan);
+    }
+
+    free(scheduler->instances);
+    free(scheduler->partitions);
+    free(scheduler->connections);
+    free(scheduler->instanceOrder);
+    free(scheduler->partitionOrder);
+    free(scheduler);
+}
+
+FMIStatus SchedulerAddInstance(Scheduler *scheduler, FMIInstance *instance, const char *modelDescriptionPath) {
+
+    ModelDescription *modelDescription = ModelDescriptionRead(modelDescriptionPath);
+
+    if (!modelDescription) {
+        logError(instance, "Failed to read %s.", modelDescriptionPath);
+        return FMIError;
+    }
+
+    SchedulerInstance *instances = (SchedulerInstance*)realloc(scheduler->instances, (scheduler->nInstances + 1) * sizeof(SchedulerInstance));
+
+    if (!instances) {
+        ModelDescriptionFree(modelDescription);
+        return FMIError;
+    }
+
+    scheduler->instances = instances;
+
+    SchedulerInstance *schedulerInstance = &instances[scheduler->nInstances++];
+
+    memset(schedulerInstance, 0, sizeof(SchedulerInstance));
+
+    schedulerInstance->instance = instance;
+    schedulerInstance->modelDescription = modelDescription;
+
+    // Every clock defines a partition
+    for (size_t i = 0; i < modelDescription->nVariables; i++) {
+
+        const ModelVariable *variable = &modelDescription->variables[i];
+
+        if (variable->type != ModelVariableClock) {
+            continue;
+        }
+
+        Partition *partitions = (Partition*)realloc(scheduler->partitions, (scheduler->nPartitions + 1) * sizeof(Partition));
+
+        if (!partitions) {
+            return FMIError;
+        }
+
+        scheduler->partitions = partitions;
+
+        Partition *partition = &partitions[scheduler->nPartitions++];
+
+        memset(partition, 0, sizeof(Partition));
+
+        partition->instance = scheduler->nInstances - 1;
+        partition->clock = variable;
+    }
+
+    return FMIOK;
+}
+
+FMIStatus SchedulerAddConnection(Scheduler *scheduler, const char *from, const char *to) {
+
+    Connection connection;
+
+    connection.from = findVariable(scheduler, from, &connection.fromInstance);
+    connection.to = findVariable(scheduler, to, &connection.toInstance);
+
+    if (!connection.from || !connection.to) {
+        printf("Failed to connect %s to %s: unknown variable.\n", from, to);
+        return FMIError;
+    }
+
+    if (connection.from->causality != CausalityOutput || connection.to->causality != CausalityInput) {
+        printf("Failed to connect %s to %s: connections must go from an output to an input.\n", from, to);
+        return FMIError;
+    }
+
+    if (connection.from->type != connection.to->type || connection.from->type == ModelVariableOther) {
+        printf("Failed to connect %s to %s: only Float64 variables and clocks of the same type can be connected.\n", from, to);
+        return FMIError;
+    }
+
+    Connection *connections = (Connection*)realloc(scheduler->connections, (scheduler->nConnections + 1) * sizeof(Connection));
+
+    if (!connections) {
+        return FMIError;
+    }
+
+    scheduler->connections = connections;
+    scheduler->connections[scheduler->nConnections++] = connection;
+
+    return FMIOK;
+}
+
+/* Compiles the connections of the clocked variables of every partition. */
+static bool compilePartitions(Scheduler *scheduler) {
+
+    const Connection **connections = (const Connection**)calloc(scheduler->nConnections + 1, sizeof(Connection*));
+
+    if (!connections) {
+        return false;
+    }
+
+    bool success = true;
+
+    for (size_t i = 0; i < scheduler->nPartitions && success; i++) {
+
+        Partition *partition = &scheduler->partitions[i];
+
+        size_t n = 0;
+
+        for (size_t j = 0; j < scheduler->nConnections; j++) {
+
+            const Connection *c = &scheduler->connections[j];
+
+            if (c->fromInstance == partition->instance && c->from->type != ModelVariableClock && isClockedBy(c->from, partition->clock)) {
+                connections[n++] = c;
+            }
+        }
+
+        ConnectionPlanFree(partition->plan);
+
+        partition->plan = ConnectionPlanCreate(scheduler, connections, n);
+
+        success = partition->plan != NULL;
+    }
+
+    free(connections);
+
+    return success;
+}
+
+FMIStatus SchedulerInitialize(Scheduler *scheduler) {
+
+    FMIStatus status = FMIError;
+
+    const size_t nI = scheduler->nInstances;
+    const size_t nP = scheduler->nPartitions;
+
+    bool *instanceEdges = (bool*)calloc(nI * nI + 1, sizeof(bool));
+    bool *partitionEdges = (bool*)calloc(nP * nP + 1, sizeof(bool));
+    size_t *instanceRank = (size_t*)calloc(nI + 1, sizeof(size_t));
+    size_t *partitionRank = (size_t*)calloc(nP + 1, sizeof(size_t));
+
+    free(scheduler->instanceOrder);
+    free(scheduler->partitionOrder);
+
+    scheduler->instanceOrder = (size_t*)calloc(nI + 1, sizeof(size_t));
+    scheduler->partitionOrder = (size_t*)calloc(nP + 1, sizeof(size_t));
+
+    if (!instanceEdges || !partitionEdges || !instanceRank || !partitionRank || !scheduler->instanceOrder || !scheduler->partitionOrder) {
+        goto TERMINATE;
+    }
+
+    for (size_t i = 0; i < scheduler->nConnections; i++) {
+
+        const Connection *c = &scheduler->connections[i];
+
+        // Clocks and clocked variables order the instances. Continuous connections are exchanged outside of events.
+        if (SchedulerIsClockedConnection(c)) {
+            if (c->fromInstance != c->toInstance) {
+                instanceEdges[c->fromInstance * nI + c->toInstance] = true;
+            }
+        }
+
+        if (c->from->type == ModelVariableClock) {
+
+            const size_t p = findPartition(scheduler, c->fromInstance, c->from->valueReference);
+            const size_t q = findPartition(scheduler, c->toInstance, c->to->valueReference);
+
+            partitionEdges[p * nP + q] = true;
+
+            continue;
+        }
+
+        // clocked output -> clocked input
+        for (size_t j = 0; j < c->from->nClocks; j++) {
+            for (size_t k = 0; k < c->to->nClocks; k++) {
+
+                const size_t p = findPartition(scheduler, c->fromInstance, c->from->clocks[j]);
+                const size_t q = findPartition(scheduler, c->toInstance, c->to->clocks[k]);
+
+                if (p != NOT_FOUND && q != NOT_FOUND) {
+                    partitionEdges[p * nP + q] = true;
+                }
+            }
+        }
+    }
+
+    // Within an instance: the partition of an output depends on the partitions of its dependencies
+    for (size_t i = 0; i < nI; i++) {
+
+        const ModelDescription *modelDescription = scheduler->instances[i].modelDescription;
+
+        for (size_t j = 0; j < modelDescription->nVariables; j++) {
+
+            const ModelVariable *output = &modelDescription->variables[j];
+
+            for (size_t k = 0; k < output->nDependencies; k++) {
+
+                const ModelVariable *dependency = ModelDescriptionFindValueReference(modelDescription, output->dependencies[k]);
+
+                if (!dependency) {
+                    continue;
+                }
+
+                for (size_t l = 0; l < dependency->nClocks; l++) {
+                    for (size_t m = 0; m < output->nClocks; m++) {
+
+                        const size_t p = findPartition(scheduler, i, dependency->clocks[l]);
+                        const size_t q = findPartition(scheduler, i, output->clocks[m]);
+
+                        if (p != NOT_FOUND && q != NOT_FOUND && p != q) {
+                            partitionEdges[p * nP + q] = true;
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    for (size_t i = 0; i < nI; i++) {
+        instanceRank[i] = i;
+    }
+
+    if (!sortTopologically(nI, instanceEdges, instanceRank, scheduler->instanceOrder)) {
+        printf("The clocked connections between the instances are cyclic.\n");
+        goto TERMINATE;
+    }
+
+    // Partitions of upstream instances come first
+    for (size_t i = 0; i < nI; i++) {
+        for (size_t j = 0; j < nP; j++) {
+            if (scheduler->partitions[j].instance == scheduler->instanceOrder[i]) {
+                partitionRank[j] = i * nP + j;
+            }
+        }
+    }
+
+    if (!sortTopologically(nP, partitionEdges, partitionRank, scheduler->partitionOrder)) {
+        printf("The dependencies between the clocked partitions are cyclic.\n");
+        goto TERMINATE;
+    }
+
+    if (!compilePartitions(scheduler)) {
+        goto TERMINATE;
+    }
+
+    status = FMIOK;
+
+TERMINATE:
+    free(instanceEdges);
+    free(partitionEdges);
+    free(instanceRank);
+    free(partitionRank);
+
+    return status;
+}
+
+size_t SchedulerGetNumberOfInstances(const Scheduler *scheduler) {
+    return scheduler->nInstances;
+}
+
+FMIInstance* SchedulerGetInstance(const Scheduler *scheduler, size_t instance) {
+    return scheduler->instances[instance].instance;
+}
+
+size_t SchedulerGetNumberOfConnections(const Scheduler *scheduler) {
+    return scheduler->nConnections;
+}
+
+const Connection* SchedulerGetConnection(const Scheduler *scheduler, size_t connection) {
+    return &scheduler->connections[connection];
+}
+
+bool SchedulerIsClockedConnection(const Connection *connection) {
+    return connection->from->type == ModelVariableClock || connection->from->nClocks > 0;
+}
+
+bool SchedulerFindClock(const Scheduler *scheduler, const char *name, size_t *clock) {
+
+    size_t instance = NOT_FOUND;
+
+    const ModelVariable *variable = findVariable(scheduler, name, &instance);
+
+    if (!variable || variable->type != ModelVariableClock) {
+        return false;
+    }
+
+    *clock = findPartition(scheduler, instance, variable->valueReference);
+
+    return true;
+}
+
+FMIStatus SchedulerActivateClock(Scheduler *scheduler, size_t clock) {
+
+    if (clock >= scheduler->nPartitions || scheduler->partitions[clock].clock->causality != CausalityInput) {
+        return FMIError;
+    }
+
+    scheduler->partitions[clock].active = true;
+    scheduler->partitions[clock].pending = true;
+
+    return FMIOK;
+}
+
+FMIStatus SchedulerSetStateEvent(Scheduler *scheduler, FMIInstance *instance) {
+
+    for (size_t i = 0; i < scheduler->nInstances; i++) {
+        if (scheduler->instances[i].instance == instance) {
+            scheduler->instances[i].event = true;
+            return FMIOK;
+        }
+    }
+
+    return FMIError;
+}
+
+bool SchedulerNextEventTime(const Scheduler *scheduler, fmi3Float64 *time) {
+
+    bool defined = false;
+
+    for (size_t i = 0; i < scheduler->nInstances; i++) {
+
+        const SchedulerInstance *schedulerInstance = &scheduler->instances[i];
+
+        if (schedulerInstance->nextEventTimeDefined && (!defined || schedulerInstance->nextEventTime < *time)) {
+            *time = schedulerInstance->nextEventTime;
+            defined = true;
+        }
+    }
+
+    return defined;
+}
+
+bool SchedulerSetTimeEvents(Scheduler *scheduler, fmi3Float64 time) {
+
+    bool due = false;
+
+    for (size_t i = 0; i < scheduler->nInstances; i++) {
+
+        SchedulerInstance *schedulerInstance = &scheduler->instances[i];
+
+        if (schedulerInstance->nextEventTimeDefined && schedulerInstance->nextEventTime <= time) {
+            schedulerInstance->event = true;
+            due = true;
+        }
+    }
+
+    return due;
+}
+
+/* Marks the partitions that may tick and the instances they touch. */
+static void markTouched(Scheduler *scheduler) {
+
+    for (size_t i = 0; i < scheduler->nPartitions; i++) {
+
+        Partition *partition = &scheduler->partitions[i];
+
+        partition->candidate = partition->active ||
+            (scheduler->instances[partition->instance].event && partition->clock->causality == CausalityOutput);
+    }
+
+    for (size_t i = 0; i < scheduler->nInstances; i++) {
+        scheduler->instances[i].touched = scheduler->instances[i].event;
+    }
+
+    for (size_t i = 0; i < scheduler->nPartitions; i++) {
+
+        const Partition *partition = &scheduler->partitions[scheduler->partitionOrder[i]];
+
+        if (!partition->candidate) {
+            continue;
+        }
+
+        scheduler->instances[partition->instance].touched = true;
+
+        for (size_t j = 0; j < scheduler->nConnections; j++) {
+
+            const Connection *c = &scheduler->connections[j];
+
+            if (c->fromInstance != partition->instance) {
+                continue;
+            }
+
+            if (c->from == partition->clock) {
+                // Downstream partitions come later in the order, so one pass suffices
+                scheduler->partitions[findPartition(scheduler, c->toInstance, c->to->valueReference)].candidate = true;
+            } else if (isClockedBy(c->from, partition->clock)) {
+                scheduler->instances[c->toInstance].touched = true;
+            }
+        }
+    }
+}
+
+/* Propagates the clocks and the clocked variables of an active partition along the connections. */
+static FMIStatus propagatePartition(Scheduler *scheduler, const Partition *partition) {
+
+    FMIStatus status = FMIOK;
+
+    for (size_t i = 0; i < scheduler->nConnections; i++) {
+
+        const Connection *c = &scheduler->connections[i];
+
+        if (c->fromInstance != partition->instance || c->from != partition->clock) {
+            continue;
+        }
+
+        const fmi3Clock value[] = { fmi3ClockActive };
+
+        CALL(FMI3SetClock(scheduler->instances[c->toInstance].instance, &c->to->valueReference, 1, value));
+
+        scheduler->partitions[findPartition(scheduler, c->toInstance, c->to->valueReference)].active = true;
+    }
+
+    CALL(ConnectionPlanExchange(partition->plan));
+
+TERMINATE:
+    return status;
+}
+
+/* Propagates the discrete variables without clocks of the touched instances between two event iterations. */
+static FMIStatus propagateDiscreteVariables(Scheduler *scheduler) {
+
+    FMIStatus status = FMIOK;
+
+    for (size_t i = 0; i < scheduler->nConnections; i++) {
+
+        const Connection *c = &scheduler->connections[i];
+
+        if (!scheduler->instances[c->fromInstance].touched || c->from->type != ModelVariableFloat64 || c->from->continuous || c->from->nClocks > 0) {
+            continue;
+        }
+
+        fmi3Float64 value[] = { 0.0 };
+
+        CALL(FMI3GetFloat64(scheduler->instances[c->fromInstance].instance, &c->from->valueReference, 1, value, 1));
+        CALL(FMI3SetFloat64(scheduler->instances[c->toInstance].instance, &c->to->valueReference, 1, value, 1));
+    }
+
+TERMINATE:
+    return status;
+}
+
+/* Calls FMI3UpdateDiscreteStates on the touched instances until no instance requests another iteration. */
+static FMIStatus iterateDiscreteStates(Scheduler *scheduler, SchedulerEventInfo *info) {
+
+    FMIStatus status = FMIOK;
+
+    for (;;) {
+
+        bool discreteStatesNeedUpdate = false;
+
+        info->nIterations++;
+
+        for (size_t i = 0; i < scheduler->nInstances; i++) {
+
+            SchedulerInstance *schedulerInstance = &scheduler->instances[scheduler->instanceOrder[i]];
+
+            fmi3Boolean needUpdate, terminateSimulation, nominalsChanged, statesChanged, nextEventTimeDefined;
+            fmi3Float64 nextEventTime;
+
+            if (!schedulerInstance->touched) {
+                continue;
+            }
+
+            CALL(FMI3UpdateDiscreteStates(schedulerInstance->instance, &needUpdate, &terminateSimulation,
+                &nominalsChanged, &statesChanged, &nextEventTimeDefined, &nextEventTime));
+
+            discreteStatesNeedUpdate |= needUpdate;
+            info->terminateSimulation |= terminateSimulation;
+            info->valuesOfContinuousStatesChanged |= statesChanged;
+
+            // The values of the last iteration are valid
+            schedulerInstance->nextEventTimeDefined = nextEventTimeDefined;
+            schedulerInstance->nextEventTime = nextEventTime;
+        }
+
+        if (!discreteStatesNeedUpdate || info->terminateSimulation) {
+            break;
+        }
+
+        if (info->nIterations == MAX_EVENT_ITERATIONS) {
+            printf("The discrete states did not converge within %d event iterations.\n", MAX_EVENT_ITERATIONS);
+            status = FMIError;
+            goto TERMINATE;
+        }
+
+        CALL(propagateDiscreteVariables(scheduler));
+    }
+
+TERMINATE:
+    return status;
+}
+
+FMIStatus SchedulerHandleEvents(Scheduler *scheduler, SchedulerEventInfo *info) {
+
+    FMIStatus status = FMIOK;
+
+    memset(info, 0, sizeof(SchedulerEventInfo));
+
+    markTouched(scheduler);
+
+    for (size_t i = 0; i < scheduler->nInstances; i++) {
+
+        const SchedulerInstance *schedulerInstance = &scheduler->instances[scheduler->instanceOrder[i]];
+
+        if (schedulerInstance->touched) {
+            CALL(FMI3EnterEventMode(schedulerInstance->instance));
+        }
+    }
+
+    // Evaluate the active partitions
+    for (size_t i = 0; i < scheduler->nPartitions; i++) {
+
+        Partition *partition = &scheduler->partitions[scheduler->partitionOrder[i]];
+        const SchedulerInstance *schedulerInstance = &scheduler->instances[partition->instance];
+
+        if (!schedulerInstance->touched) {
+            continue;
+        }
+
+        if (partition->clock->causality == CausalityOutput) {
+
+            fmi3Clock value[] = { fmi3ClockInactive };
+
+            CALL(FMI3GetClock(schedulerInstance->instance, &partition->clock->valueReference, 1, value));
+
+            partition->active = value[0] == fmi3ClockActive;
+        }
+
+        if (!partition->active) {
+            continue;
+        }
+
+        if (partition->pending) {
+
+            const fmi3Clock value[] = { fmi3ClockActive };
+
+            CALL(FMI3SetClock(schedulerInstance->instance, &partition->clock->valueReference, 1, value));
+
+            partition->pending = false;
+        }
+
+        CALL(propagatePartition(scheduler, partition));
+    }
+
+    // Update the discrete states and leave event mode
+    CALL(iterateDiscreteStates(scheduler, info));
+
+    for (size_t i = 0; i < scheduler->nInstances; i++) {
+
+        const SchedulerInstance *schedulerInstance = &scheduler->instances[scheduler->instanceOrder[i]];
+
+        if (!schedulerInstance->touched) {
+            continue;
+        }
+
+        if (schedulerInstance->instance->interfaceType == FMIModelExchange) {
+            CALL(FMI3EnterContinuousTimeMode(schedulerInstance->instance));
+        } else {
+            CALL(FMI3EnterStepMode(schedulerInstance->instance));
+        }
+    }
+
+TERMINATE:
+
+    for (size_t i = 0; i < scheduler->nPartitions; i++) {
+        scheduler->partitions[i].candidate = false;
+        scheduler->partitions[i].active = false;
+        scheduler->partitions[i].pending = false;
+    }
+
+    for (size_t i = 0; i < scheduler->nInstances; i++) {
+        scheduler->instances[i].event = false;
+        scheduler->instances[i].touched = false;
+    }
+
+    return status;
+}
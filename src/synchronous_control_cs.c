@@ -15,35 +15,59 @@ See more details in [README.md](./README.md)
 #include <assert.h>
 
 #include "FMI3.h"
+#include "clock_calendar.h"
+#include "scheduler.h"
+#include "master_algorithm.h"
 #include "orchestration_common.h"
 
-// Define struct to hold outputs of FMI3DoStep
-typedef struct {
-    fmi3Boolean stateEvent;
-    fmi3Boolean terminateSimulation;
-    fmi3Boolean earlyReturn;
-    fmi3Float64 last_successul_time;
-} FMI3DoStepOutput;
-
 
 int main(int argc, char *argv[])
 {
     printf("Running Supervisory Control example... \n");
 
+    // Master algorithm, e.g. --master=hybrid --threads=2
+    const char* masterOption = getOption(argc, argv, "master");
+    const char* threadsOption = getOption(argc, argv, "threads");
+
+    // Locate state events within the communication steps, e.g. --event-location=rollback --event-tolerance=1e-8
+    const char* eventLocationOption = getOption(argc, argv, "event-location");
+    const char* eventToleranceOption = getOption(argc, argv, "event-tolerance");
+
+    const bool rollback = eventLocationOption ? !strcmp(eventLocationOption, "rollback") : eventToleranceOption != NULL;
+    const bool earlyReturn = eventLocationOption && !strcmp(eventLocationOption, "early-return");
+    const fmi3Float64 eventTolerance = eventToleranceOption ? atof(eventToleranceOption) : 1e-8;
+
+    if (eventLocationOption && !rollback && !earlyReturn) {
+        printf("Unknown event location: %s\n", eventLocationOption);
+        return EXIT_FAILURE;
+    }
+
+    // Without options all FMUs step from the same inputs on the main thread.
+    // For the rollback the supervisor needs the fresh output of the plant.
+    MasterAlgorithmType masterType = rollback ? MasterGaussSeidel : MasterJacobi;
+
+    if (masterOption && !MasterAlgorithmTypeFromString(masterOption, &masterType)) {
+        printf("Unknown master algorithm: %s\n", masterOption);
+        return EXIT_FAILURE;
+    }
+
+    if (rollback && masterType == MasterJacobi) {
+        printf("The Jacobi master cannot locate events.\n");
+        return EXIT_FAILURE;
+    }
+
+    const size_t nThreads = threadsOption ? (size_t)atoi(threadsOption) : masterOption ? N_INSTANCES : 0;
+
     FMIStatus status = FMIOK;
     fmi3Float64 h = FIXED_STEP;
     fmi3Float64 tNext = h;
     fmi3Float64 time = 0;
 
-    // Flags for FMI3UpdateDiscreteStates
-    FMI3UpdateDiscreteStatesOutput controller_FMI3UpdateDiscreteStatesOutput = { fmi3False, fmi3False, fmi3False, fmi3False, fmi3False, 0.0 };
-    FMI3UpdateDiscreteStatesOutput plant_FMI3UpdateDiscreteStatesOutput = { fmi3False, fmi3False, fmi3False, fmi3False, fmi3False, 0.0 };
-    FMI3UpdateDiscreteStatesOutput supervisor_FMI3UpdateDiscreteStatesOutput = { fmi3False, fmi3False, fmi3False, fmi3False, fmi3False, 0.0 };
+    // Steps the FMUs and exchanges the continuous outputs
+    MasterAlgorithm* master = NULL;
 
-    // Flags for FMI3DoStep
-    FMI3DoStepOutput controller_FMI3DoStepOutput = { fmi3False, fmi3False, fmi3False, 0.0 };
-    FMI3DoStepOutput plant_FMI3DoStepOutput = { fmi3False, fmi3False, fmi3False, 0.0 };
-    FMI3DoStepOutput supervisor_FMI3DoStepOutput = { fmi3False, fmi3False, fmi3False, 0.0 };
+    // Binary trace of the FMI calls
+    CallTrace* callTrace = NULL;
 
     // Will hold exchanged values: Controller -> Plantmodel
     fmi3Float64 controller_vals[] = { 0.0 };
@@ -51,32 +75,95 @@ int main(int argc, char *argv[])
     fmi3Float64 plantmodel_vals[] = { 0.0 };
     fmi3Float64 plantmodel_der_vals[] = { 0.0 };
 
-    // Controller's clock r timer
-    fmi3Float64 controller_r_period = 0.0;
-    fmi3Float64 controller_r_timer = 0.0;
-    // Will hold output from FMI3GetIntervalDecimal
-    fmi3Float64 controller_interval_vals[] = { 0.0 };
+    // Clocked partitions and their dependencies
+    Scheduler* scheduler = SchedulerCreate();
+    size_t controller_r_clock = 0;
+    SchedulerEventInfo eventInfo = { false, false, 0 };
+
+    // Calendar of the periodic clocks on an integer time base
+    ClockCalendar* calendar = ClockCalendarCreate();
+    size_t dueClocks[N_CLOCKS];
+    fmi3UInt64 stepTicks = 0;
+    // Will hold output from FMI3GetIntervalFraction and FMI3GetShiftFraction
+    fmi3UInt64 controller_interval_counters[] = { 0 };
+    fmi3UInt64 controller_interval_resolutions[] = { 1 };
     fmi3IntervalQualifier controller_interval_qualifiers[] = { fmi3IntervalNotYetKnown };
+    fmi3UInt64 controller_shift_counters[] = { 0 };
+    fmi3UInt64 controller_shift_resolutions[] = { 1 };
+
+    // Open the result file, e.g. --result=synchronous_control_cs.res
+    ResultSink* resultSink = initializeResultSink(argc, argv, "synchronous_control_cs_out.res");
+    if (!resultSink) {
+        return EXIT_FAILURE;
+    }
+
+    if (!scheduler || !calendar) {
+        puts("Failed to create scheduler.");
+        return EXIT_FAILURE;
+    }
 
-    // Open file
-    FILE * outputFile = initializeFile("synchronous_control_cs_out.csv");
-    if (!outputFile) {
+    // Load the FMUs from their archives, e.g. --fmu-dir=../fmus
+    if (extractFMUs(argc, argv) != FMIOK) {
         return EXIT_FAILURE;
     }
 
     // Instantiate
-    FMIInstance* controller = FMICreateInstance("controller", "Controller" BINARY_DIR "Controller" BINARY_EXT, logMessage, logFunction);
-    FMIInstance* plant = FMICreateInstance("plant", "Plant"      BINARY_DIR "Plant"      BINARY_EXT, logMessage, logFunction);
-    FMIInstance* supervisor = FMICreateInstance("supervisor", "Supervisor" BINARY_DIR "Supervisor" BINARY_EXT, logMessage, logFunction);
+    FMIInstance* controller = createInstance("controller", "Controller");
+    FMIInstance* plant      = createInstance("plant",      "Plant");
+    FMIInstance* supervisor = createInstance("supervisor", "Supervisor");
 
     if (!controller || !plant || !supervisor) {
         puts("Failed to load shared libraries.");
         return FMIError;
     }
 
+    // Value references of the exchanged variables from the modelDescription.xml files
+    CALL(resolveValueReferences());
+
+    // Tracing of the FMI calls, e.g. --trace-interval=100
+    setTraceOptions(controller, argc, argv);
+    setTraceOptions(plant,      argc, argv);
+    setTraceOptions(supervisor, argc, argv);
+
+    // Binary trace of the FMI calls, e.g. --call-trace=synchronous_control_cs.trace
+    CALL(setCallTraceOption(&callTrace, argc, argv, controller, plant, supervisor));
+
+    // Build the dependency graph of the clocked partitions
+    CALL(initializeScheduler(scheduler, controller, plant, supervisor));
+
+    // Plan the waves of the master algorithm from the connections
+    master = MasterAlgorithmCreate(scheduler, masterType, nThreads);
+
+    if (!master) {
+        puts("Failed to create master algorithm.");
+        status = FMIError;
+        goto TERMINATE;
+    }
+
+    printf("Master algorithm: %s \n", MasterAlgorithmTypeToString(masterType));
+
+    if (!SchedulerFindClock(scheduler, "controller.r", &controller_r_clock)) {
+        puts("Failed to find clock r.");
+        status = FMIError;
+        goto TERMINATE;
+    }
+
     CALL(FMI3InstantiateCoSimulation(controller, "{e1f14bf0-302d-4ef9-b11c-e01c7ed456cb}", NULL, fmi3False, fmi3True, fmi3True, fmi3False, NULL, 0, NULL));
     CALL(FMI3InstantiateCoSimulation(plant,      "{6e81b08d-97be-4de1-957f-8358a4e83184}", NULL, fmi3False, fmi3True, fmi3True, fmi3False, NULL, 0, NULL));
-    CALL(FMI3InstantiateCoSimulation(supervisor, "{64202d14-799a-4379-9fb3-79354aec17b2}", NULL, fmi3False, fmi3True, fmi3True, fmi3False, NULL, 0, NULL));
+
+    // Internal solver of the plant, e.g. --plant-max-step=1e-3 --plant-tolerance=1e-10
+    CALL(setPlantSolverOptions(plant, argc, argv));
+    // The supervisor samples x in the intermediate updates and returns early at its events
+    if (earlyReturn) {
+        CALL(MasterAlgorithmAllowEarlyReturn(master, supervisor));
+    }
+
+    CALL(FMI3InstantiateCoSimulation(supervisor, "{64202d14-799a-4379-9fb3-79354aec17b2}", NULL, fmi3False, fmi3True, fmi3True, earlyReturn, NULL, 0, earlyReturn ? MasterAlgorithmIntermediateUpdate : NULL));
+
+    // Debug logging of the FMUs, e.g. --log-categories=logStatusError
+    CALL(setLogCategoryOptions(controller, argc, argv));
+    CALL(setLogCategoryOptions(plant,      argc, argv));
+    CALL(setLogCategoryOptions(supervisor, argc, argv));
 
     // Initialize
     CALL(FMI3EnterInitializationMode(controller, fmi3False, 0.0, tStart, fmi3True, tEnd));
@@ -90,10 +177,19 @@ int main(int argc, char *argv[])
     // Exchange data Plantmodel -> Supervisor
     CALL(FMI3SetFloat64(supervisor, supervisor_in_refs, 1, plantmodel_vals, 1));
 
-    // Get clock r's interval
-    CALL(FMI3GetIntervalDecimal(controller, controller_r_refs, 1, controller_interval_vals, controller_interval_qualifiers));
-    controller_r_period = controller_interval_vals[0];
-    controller_r_timer = controller_r_period;
+    // Schedule clock r with its exact interval and shift
+    CALL(FMI3GetIntervalFraction(controller, controller_r_refs, 1, controller_interval_counters, controller_interval_resolutions, controller_interval_qualifiers));
+    CALL(FMI3GetShiftFraction(controller, controller_r_refs, 1, controller_shift_counters, controller_shift_resolutions));
+    CALL(ClockCalendarAddPeriodicClock(calendar, controller_r_clock,
+        controller_interval_counters[0], controller_interval_resolutions[0],
+        controller_shift_counters[0], controller_shift_resolutions[0]));
+
+    // The clocked partitions have been evaluated during initialization, so ticks at the start time are skipped
+    ClockCalendarPopDue(calendar, 0, dueClocks, N_CLOCKS);
+
+    // The communication step on the time base of the calendar
+    CALL(ClockCalendarAddResolution(calendar, FIXED_STEP_RESOLUTION));
+    stepTicks = FIXED_STEP_COUNTER * (ClockCalendarResolution(calendar) / FIXED_STEP_RESOLUTION);
 
     CALL(FMI3ExitInitializationMode(controller));
     CALL(FMI3ExitInitializationMode(plant));
@@ -106,163 +202,78 @@ int main(int argc, char *argv[])
     CALL(FMI3EnterStepMode(supervisor));
 
     // Record initial outputs
-    CALL(recordVariables(outputFile, controller, plant, time));
+    CALL(recordVariables(resultSink, controller, plant, time));
 
     // Get number of simulation steps to be carried out. 
     int nSteps = (int)ceil((tEnd - tStart) / h) + 1; // +1 to include tEnd
 
     // Main simulation loop
-    for (int i = 0; i < nSteps; i++) {
-        CALL(FMI3DoStep(controller, time, h, fmi3True, 
-            &controller_FMI3DoStepOutput.stateEvent, 
-            &controller_FMI3DoStepOutput.terminateSimulation, 
-            &controller_FMI3DoStepOutput.earlyReturn, 
-            &controller_FMI3DoStepOutput.last_successul_time));
-        CALL(FMI3DoStep(plant, time, h, fmi3True, 
-            &plant_FMI3DoStepOutput.stateEvent, 
-            &plant_FMI3DoStepOutput.terminateSimulation, 
-            &plant_FMI3DoStepOutput.earlyReturn, 
-            &plant_FMI3DoStepOutput.last_successul_time));
-        CALL(FMI3DoStep(supervisor, time, h, fmi3True, 
-            &supervisor_FMI3DoStepOutput.stateEvent, 
-            &supervisor_FMI3DoStepOutput.terminateSimulation, 
-            &supervisor_FMI3DoStepOutput.earlyReturn, 
-            &supervisor_FMI3DoStepOutput.last_successul_time));
-
-        // Advance time and update timers
-        time = tStart + i*h;
-        controller_r_timer -= h;
-
-        // Check for state events or time events.
-        bool timeEvent = controller_r_timer <= 0.0;
+    for (int i = 0; i < nSteps && !eventInfo.terminateSimulation; i++) {
         bool stateEvent = false;
-        // Update stateEvent
-        stateEvent = controller_FMI3DoStepOutput.stateEvent || plant_FMI3DoStepOutput.stateEvent || supervisor_FMI3DoStepOutput.stateEvent;
+        bool terminateSimulation = false;
+
+        fmi3Float64 tStep = tStart + i * h;
+        fmi3Float64 hStep = h;
+
+        // A step that ends early at a located event is completed after the event has been handled
+        for (;;) {
+            fmi3Float64 hTaken = 0.0;
+
+            if (rollback) {
+                CALL(MasterAlgorithmDoStepLocateEvents(master, tStep, hStep, eventTolerance, &hTaken, &stateEvent, &terminateSimulation));
+            } else {
+                // Step the FMUs in waves and exchange the outputs, the instances with state events are marked in the scheduler
+                CALL(MasterAlgorithmDoStep(master, tStep, hStep, &hTaken, &stateEvent, &terminateSimulation));
+            }
+
+            if (hTaken >= hStep || terminateSimulation) {
+                break;
+            }
+
+            tStep += hTaken;
+            hStep -= hTaken;
+
+            if (stateEvent) {
+                printf("Located state event at t=%.12g \n", tStep);
+                CALL(SchedulerHandleEvents(scheduler, &eventInfo));
+
+                if (eventInfo.terminateSimulation) {
+                    terminateSimulation = true;
+                    break;
+                }
+            }
+        }
+
+        if (terminateSimulation) {
+            printf("Simulation terminated by an FMU at t=%g. \n", time);
+            break;
+        }
 
-        // Exchange data Plantmodel -> Supervisor
-        CALL(FMI3GetFloat64(plant, plantmodel_y_refs, 1, plantmodel_vals, 1));
-        CALL(FMI3SetFloat64(supervisor, supervisor_in_refs, 1, plantmodel_vals, 1));
+        // Advance time
+        time = tStart + i*h;
+
+        // Check for state events or time events. A time event is due once i + 1 steps have reached it.
+        size_t nDueClocks = ClockCalendarPopDue(calendar, (i + 1) * stepTicks, dueClocks, N_CLOCKS);
+        bool timeEvent = SchedulerSetTimeEvents(scheduler, tStart + (i + 1) * h) || nDueClocks > 0;
 
         // Record data
-        CALL(recordVariables(outputFile, controller, plant, time));
+        CALL(recordVariables(resultSink, controller, plant, time));
 
         printf("Time event: %d \t State Event: %d \n", timeEvent, stateEvent);
 
         // Check if controller or supervisor need to execute
         if (timeEvent || stateEvent) {
-            if (timeEvent && !stateEvent) {
-                printf("Entering event mode for ticking clock r. \n");
-
-                // Reset timer
-                controller_r_timer = controller_r_period;
-
-                // Put Controller into event mode, as clocks are about to tick
-                CALL(FMI3EnterEventMode(controller));
-                // Put Plantmodel into event mode, as its input is a discrete time variable
-                CALL(FMI3EnterEventMode(plant));
-
-                // Handle time event in controller
-                CALL(handleTimeEventController(controller, plant));
-
-                // Update discrete states of the controller
-                CALL(FMI3UpdateDiscreteStates(controller, 
-                    &controller_FMI3UpdateDiscreteStatesOutput.discreteStatesNeedUpdate, 
-                    &controller_FMI3UpdateDiscreteStatesOutput.terminateSimulation, 
-                    &controller_FMI3UpdateDiscreteStatesOutput.nominalsChanged, 
-                    &controller_FMI3UpdateDiscreteStatesOutput.statesChanged, 
-                    &controller_FMI3UpdateDiscreteStatesOutput.nextEventTimeDefined, 
-                    &controller_FMI3UpdateDiscreteStatesOutput.nextEventTime));
-                CALL(FMI3UpdateDiscreteStates(plant, 
-                    &plant_FMI3UpdateDiscreteStatesOutput.discreteStatesNeedUpdate, 
-                    &plant_FMI3UpdateDiscreteStatesOutput.terminateSimulation, 
-                    &plant_FMI3UpdateDiscreteStatesOutput.nominalsChanged, 
-                    &plant_FMI3UpdateDiscreteStatesOutput.statesChanged, 
-                    &plant_FMI3UpdateDiscreteStatesOutput.nextEventTimeDefined, 
-                    &plant_FMI3UpdateDiscreteStatesOutput.nextEventTime));
-
-                // Exit event mode
-                CALL(FMI3EnterStepMode(controller));
-                CALL(FMI3EnterStepMode(plant));
-                printf("Exiting event mode. \n");
+            for (size_t j = 0; j < nDueClocks; j++) {
+                CALL(SchedulerActivateClock(scheduler, dueClocks[j]));
             }
-            else if (!timeEvent && stateEvent) {
-                printf("Entering event mode for ticking clock s. \n");
-
-                // Put Supervisor and Controller into event mode, as clocks are about to tick. Note the flags used.
-                CALL(FMI3EnterEventMode(supervisor));
-                CALL(FMI3EnterEventMode(controller));
-
-                // Handle state event supervisor
-                CALL(handleStateEventSupervisor(controller, supervisor));
-
-                // Update discrete states of the controller and supervisor
-                CALL(FMI3UpdateDiscreteStates(supervisor, 
-                    &supervisor_FMI3UpdateDiscreteStatesOutput.discreteStatesNeedUpdate, 
-                    &supervisor_FMI3UpdateDiscreteStatesOutput.terminateSimulation, 
-                    &supervisor_FMI3UpdateDiscreteStatesOutput.nominalsChanged, 
-                    &supervisor_FMI3UpdateDiscreteStatesOutput.statesChanged, 
-                    &supervisor_FMI3UpdateDiscreteStatesOutput.nextEventTimeDefined, 
-                    &supervisor_FMI3UpdateDiscreteStatesOutput.nextEventTime));
-                CALL(FMI3UpdateDiscreteStates(controller, 
-                    &controller_FMI3UpdateDiscreteStatesOutput.discreteStatesNeedUpdate, 
-                    &controller_FMI3UpdateDiscreteStatesOutput.terminateSimulation, 
-                    &controller_FMI3UpdateDiscreteStatesOutput.nominalsChanged, 
-                    &controller_FMI3UpdateDiscreteStatesOutput.statesChanged, 
-                    &controller_FMI3UpdateDiscreteStatesOutput.nextEventTimeDefined, 
-                    &controller_FMI3UpdateDiscreteStatesOutput.nextEventTime));
-
-                // Exit event mode
-                CALL(FMI3EnterStepMode(supervisor));
-                CALL(FMI3EnterStepMode(controller));
-                printf("Exiting event mode. \n");
-            }
-            else {
-                assert(timeEvent && stateEvent);
-
-                // Reset timer
-                controller_r_timer = controller_r_period;
-
-                // Handle both time event and state event.
-                printf("Entering event mode for ticking clocks s and r. \n");
-                // Now we must respect the dependencies. The supervisor gets priority, and then the controller.
-
-                // Put Supervisor and Controller into event mode, as clocks are about to tick.
-                CALL(FMI3EnterEventMode(supervisor));
-                CALL(FMI3EnterEventMode(controller));
-                // Put Plantmodel into event mode, as its input is a discrete time variable
-                CALL(FMI3EnterEventMode(plant));
-
-                CALL(handleStateEventSupervisor(controller, supervisor));
-                CALL(handleTimeEventController(controller, plant));
-
-                // Update discrete states of the controller and supervisor
-                CALL(FMI3UpdateDiscreteStates(supervisor, 
-                    &supervisor_FMI3UpdateDiscreteStatesOutput.discreteStatesNeedUpdate, 
-                    &supervisor_FMI3UpdateDiscreteStatesOutput.terminateSimulation, 
-                    &supervisor_FMI3UpdateDiscreteStatesOutput.nominalsChanged, 
-                    &supervisor_FMI3UpdateDiscreteStatesOutput.statesChanged, 
-                    &supervisor_FMI3UpdateDiscreteStatesOutput.nextEventTimeDefined, 
-                    &supervisor_FMI3UpdateDiscreteStatesOutput.nextEventTime));
-                CALL(FMI3UpdateDiscreteStates(controller, 
-                    &controller_FMI3UpdateDiscreteStatesOutput.discreteStatesNeedUpdate, 
-                    &controller_FMI3UpdateDiscreteStatesOutput.terminateSimulation, 
-                    &controller_FMI3UpdateDiscreteStatesOutput.nominalsChanged, 
-                    &controller_FMI3UpdateDiscreteStatesOutput.statesChanged, 
-                    &controller_FMI3UpdateDiscreteStatesOutput.nextEventTimeDefined, 
-                    &controller_FMI3UpdateDiscreteStatesOutput.nextEventTime));
-                CALL(FMI3UpdateDiscreteStates(plant, 
-                    &plant_FMI3UpdateDiscreteStatesOutput.discreteStatesNeedUpdate, 
-                    &plant_FMI3UpdateDiscreteStatesOutput.terminateSimulation, 
-                    &plant_FMI3UpdateDiscreteStatesOutput.nominalsChanged, 
-                    &plant_FMI3UpdateDiscreteStatesOutput.statesChanged, 
-                    &plant_FMI3UpdateDiscreteStatesOutput.nextEventTimeDefined, 
-                    &plant_FMI3UpdateDiscreteStatesOutput.nextEventTime));
-
-                // Exit event mode
-                CALL(FMI3EnterStepMode(supervisor));
-                CALL(FMI3EnterStepMode(controller));
-                CALL(FMI3EnterStepMode(plant));
-                printf("Exiting event mode. \n");
+
+            // Handle the active clocks in the order of their dependencies
+            printf("Entering event mode. \n");
+            CALL(SchedulerHandleEvents(scheduler, &eventInfo));
+            printf("Exiting event mode after %zu iteration(s). \n", eventInfo.nIterations);
+
+            if (eventInfo.terminateSimulation) {
+                printf("Simulation terminated by an FMU at t=%g. \n", time);
             }
         }
     }
@@ -276,13 +287,30 @@ int main(int argc, char *argv[])
     CALL(FMI3Terminate(plant));
     CALL(FMI3Terminate(supervisor));
 
+    if (rollback) {
+        const MasterAlgorithmStatistics* masterStatistics = MasterAlgorithmGetStatistics(master);
+        printf("Event location: %zu state events, %zu repeated steps \n", masterStatistics->nEvents, masterStatistics->nRollbacks);
+    }
+
+    if (earlyReturn) {
+        printf("Event location: %zu early returns \n", MasterAlgorithmGetStatistics(master)->nEarlyReturns);
+    }
+
 TERMINATE:
 
-    CALL(FMI3FreeInstance(controller));
-    CALL(FMI3FreeInstance(plant));
-    CALL(FMI3FreeInstance(supervisor));
+    // The master frees its FMU states, so it goes before the instances
+    MasterAlgorithmFree(master);
+
+    FMI3FreeInstance(controller);
+    FMI3FreeInstance(plant);
+    FMI3FreeInstance(supervisor);
+
+    CallTraceFree(callTrace);
+
+    ClockCalendarFree(calendar);
+    SchedulerFree(scheduler);
 
-    fclose(outputFile);
+    ResultSinkFree(resultSink);
 
     printf("Done! \n");
 
@@ -15,61 +15,223 @@ See more details in [README.md](./README.md)
 #include <assert.h>
 
 #include "FMI3.h"
+#include "ode_solver.h"
+#include "model_description.h"
+#include "event_locator.h"
+#include "clock_calendar.h"
+#include "scheduler.h"
+#include "connection_plan.h"
 #include "orchestration_common.h"
 
+// Width of the bracket at which the location of a state event stops, and the maximum number of refinements
+#define STATE_EVENT_TOLERANCE 1e-10
+#define STATE_EVENT_MAX_ITERATIONS 100
+
+// Everything needed to evaluate the Supervisor's event indicators within the last step of the Plantmodel
+typedef struct {
+    Solver* solver;
+    FMIInstance* plant;
+    FMIInstance* supervisor;
+    ConnectionPlan* continuousConnections;
+    fmi3Float64* plantmodel_states;
+    size_t plantmodel_nx;
+} EventIndicatorContext;
+
+// Brings the Plantmodel to time by interpolation and propagates its output to the Supervisor
+static FMIStatus getSupervisorEventIndicators(void* context, fmi3Float64 time, fmi3Float64 eventIndicators[]) {
+
+    FMIStatus status = FMIOK;
+
+    EventIndicatorContext* c = (EventIndicatorContext*)context;
+
+    SolverInterpolate(c->solver, time, c->plantmodel_states);
+
+    CALL(FMI3SetTime(c->plant, time));
+    CALL(FMI3SetContinuousStates(c->plant, c->plantmodel_states, c->plantmodel_nx));
+
+    // Exchange data Plantmodel -> Supervisor
+    CALL(FMI3SetTime(c->supervisor, time));
+    CALL(ConnectionPlanExchange(c->continuousConnections));
+
+    CALL(FMI3GetEventIndicators(c->supervisor, eventIndicators, 1));
+
+TERMINATE:
+    return status;
+}
+
+/* Reads the states, their derivatives and the non-zeros of the Jacobian of the Plantmodel for the implicit solvers. */
+static bool readJacobianStructure(const ModelDescription* modelDescription, size_t nx, fmi3ValueReference states[], fmi3ValueReference derivatives[], bool pattern[])
+{
+    if (modelDescription->nContinuousStateDerivatives != nx) {
+        return false;
+    }
+
+    for (size_t i = 0; i < nx; i++) {
+
+        const ModelVariable* derivative = ModelDescriptionFindValueReference(modelDescription, modelDescription->continuousStateDerivatives[i]);
+
+        if (!derivative || !derivative->hasDerivative) {
+            return false;
+        }
+
+        derivatives[i] = derivative->valueReference;
+        states[i] = derivative->derivative;
+    }
+
+    for (size_t i = 0; i < nx; i++) {
+
+        const ModelVariable* derivative = ModelDescriptionFindValueReference(modelDescription, derivatives[i]);
+
+        for (size_t j = 0; j < nx; j++) {
+
+            // without declared dependencies the derivative depends on all states
+            bool dependent = !derivative->hasDependencies;
+
+            for (size_t k = 0; k < derivative->nDependencies; k++) {
+                dependent = dependent || derivative->dependencies[k] == states[j];
+            }
+
+            pattern[i * nx + j] = dependent;
+        }
+    }
+
+    return true;
+}
+
 int main(int argc, char *argv[])
 {
     printf("Running Supervisory Control example... \n");
 
-    // Flags for FMI3UpdateDiscreteStates
-    FMI3UpdateDiscreteStatesOutput controller_FMI3UpdateDiscreteStatesOutput = { fmi3False, fmi3False, fmi3False, fmi3False, fmi3False, 0.0 };
-    FMI3UpdateDiscreteStatesOutput plant_FMI3UpdateDiscreteStatesOutput = { fmi3False, fmi3False, fmi3False, fmi3False, fmi3False, 0.0 };
-    FMI3UpdateDiscreteStatesOutput supervisor_FMI3UpdateDiscreteStatesOutput = { fmi3False, fmi3False, fmi3False, fmi3False, fmi3False, 0.0 };
+    // Integrator of the Plantmodel, e.g. --solver=rk45 --tolerance=1e-6
+    SolverSettings solverSettings = {
+        .type                 = SolverEuler,
+        .fixedStep            = FIXED_STEP,
+        .tolerance            = 1e-6,
+        .minStep              = 1e-12,
+        .maxStep              = STOP_TIME,
+        .stateReferences      = NULL,
+        .derivativeReferences = NULL,
+        .jacobianPattern      = NULL
+    };
+    Solver* solver = NULL;
+    ModelDescription* plantDescription = NULL;
+    fmi3ValueReference* plantmodel_state_refs = NULL;
+    fmi3ValueReference* plantmodel_derivative_refs = NULL;
+    bool* plantmodel_jacobian_pattern = NULL;
+    EventLocator* locator = NULL;
+    CallTrace* callTrace = NULL;
+    ConnectionPlan* continuousConnections = NULL;
+    EventIndicatorContext eventIndicatorContext = { NULL, NULL, NULL, NULL, NULL, 0 };
+
+    const char* solverOption = getOption(argc, argv, "solver");
+    const char* toleranceOption = getOption(argc, argv, "tolerance");
+
+    if (solverOption && !SolverTypeFromString(solverOption, &solverSettings.type)) {
+        printf("Unknown solver: %s\n", solverOption);
+        return EXIT_FAILURE;
+    }
+
+    if (toleranceOption) {
+        solverSettings.tolerance = atof(toleranceOption);
+    }
+
+    const fmi3Boolean toleranceDefined = solverSettings.type != SolverEuler;
 
     FMIStatus status = FMIOK;
-    fmi3Float64 h = FIXED_STEP;
-    fmi3Float64 tNext = h;
     fmi3Float64 time = 0;
 
     // Will hold exchanged values: Controller -> Plantmodel
     fmi3Float64 controller_vals[] = { 0.0 };
     // Will hold exchanged values: Plantmodel -> Controller
     fmi3Float64 plantmodel_vals[] = { 0.0 };
-    fmi3Float64 plantmodel_der_vals[] = { 0.0 };
+    size_t plantmodel_nx = 0;
     // Will hold event indicator values of supervisor;
     fmi3Float64 supervisor_evt_vals[1] = { 0.0 };
     fmi3Float64 supervisor_event_indicator = 0.0;
 
-    // Controller's clock r timer
-    fmi3Float64 controller_r_period = 0.0;
-    fmi3Float64 controller_r_timer = 0.0;
-    // Will hold output from FMI3GetIntervalDecimal
-    fmi3Float64 controller_interval_vals[] = { 0.0 };
+    // Clocked partitions and their dependencies
+    Scheduler* scheduler = SchedulerCreate();
+    size_t controller_r_clock = 0;
+    SchedulerEventInfo eventInfo = { false, false, 0 };
+
+    // Calendar of the periodic clocks on an integer time base
+    ClockCalendar* calendar = ClockCalendarCreate();
+    fmi3UInt64 nextTick = 0;
+    size_t dueClocks[N_CLOCKS];
+    // Will hold output from FMI3GetIntervalFraction and FMI3GetShiftFraction
+    fmi3UInt64 controller_interval_counters[] = { 0 };
+    fmi3UInt64 controller_interval_resolutions[] = { 1 };
     fmi3IntervalQualifier controller_interval_qualifiers[] = { fmi3IntervalNotYetKnown };
+    fmi3UInt64 controller_shift_counters[] = { 0 };
+    fmi3UInt64 controller_shift_resolutions[] = { 1 };
+
+    // Open the result file, e.g. --result=synchronous_control_me.res
+    ResultSink* resultSink = initializeResultSink(argc, argv, "synchronous_control_me_out.res");
+    if (!resultSink) {
+        return EXIT_FAILURE;
+    }
+
+    if (!scheduler || !calendar) {
+        puts("Failed to create scheduler.");
+        return EXIT_FAILURE;
+    }
 
-    // Open file
-    FILE * outputFile = initializeFile("synchronous_control_me_out.csv");
-    if (!outputFile) {
+    // Load the FMUs from their archives, e.g. --fmu-dir=../fmus
+    if (extractFMUs(argc, argv) != FMIOK) {
         return EXIT_FAILURE;
     }
 
     // Instantiate
-    FMIInstance* controller = FMICreateInstance("controller", "Controller" BINARY_DIR "Controller" BINARY_EXT, logMessage, logFunction);
-    FMIInstance* plant = FMICreateInstance("plant", "Plant"      BINARY_DIR "Plant"      BINARY_EXT, logMessage, logFunction);
-    FMIInstance* supervisor = FMICreateInstance("supervisor", "Supervisor" BINARY_DIR "Supervisor" BINARY_EXT, logMessage, logFunction);
+    FMIInstance* controller = createInstance("controller", "Controller");
+    FMIInstance* plant      = createInstance("plant",      "Plant");
+    FMIInstance* supervisor = createInstance("supervisor", "Supervisor");
 
     if (!controller || !plant || !supervisor) {
         puts("Failed to load shared libraries.");
         return FMIError;
     }
 
+    // Value references of the exchanged variables from the modelDescription.xml files
+    CALL(resolveValueReferences());
+
+    // Tracing of the FMI calls, e.g. --trace-interval=100
+    setTraceOptions(controller, argc, argv);
+    setTraceOptions(plant,      argc, argv);
+    setTraceOptions(supervisor, argc, argv);
+
+    // Binary trace of the FMI calls, e.g. --call-trace=synchronous_control_me.trace
+    CALL(setCallTraceOption(&callTrace, argc, argv, controller, plant, supervisor));
+
+    // Build the dependency graph of the clocked partitions
+    CALL(initializeScheduler(scheduler, controller, plant, supervisor));
+
+    if (!SchedulerFindClock(scheduler, "controller.r", &controller_r_clock)) {
+        puts("Failed to find clock r.");
+        status = FMIError;
+        goto TERMINATE;
+    }
+
+    // The continuous outputs are exchanged with one get and one set call per FMU
+    continuousConnections = ConnectionPlanCreateContinuous(scheduler);
+
+    if (!continuousConnections) {
+        puts("Failed to compile the connections.");
+        status = FMIError;
+        goto TERMINATE;
+    }
+
     CALL(FMI3InstantiateModelExchange(controller, "{e1f14bf0-302d-4ef9-b11c-e01c7ed456cb}", NULL, fmi3False, fmi3True));
     CALL(FMI3InstantiateModelExchange(plant,      "{6e81b08d-97be-4de1-957f-8358a4e83184}", NULL, fmi3False, fmi3True));
     CALL(FMI3InstantiateModelExchange(supervisor, "{64202d14-799a-4379-9fb3-79354aec17b2}", NULL, fmi3False, fmi3True));
 
+    // Debug logging of the FMUs, e.g. --log-categories=logStatusError
+    CALL(setLogCategoryOptions(controller, argc, argv));
+    CALL(setLogCategoryOptions(plant,      argc, argv));
+    CALL(setLogCategoryOptions(supervisor, argc, argv));
+
     // Initialize
     CALL(FMI3EnterInitializationMode(controller, fmi3False, 0.0, tStart, fmi3True, tEnd));
-    CALL(FMI3EnterInitializationMode(plant,      fmi3False, 0.0, tStart, fmi3True, tEnd));
+    CALL(FMI3EnterInitializationMode(plant,      toleranceDefined, solverSettings.tolerance, tStart, fmi3True, tEnd));
     CALL(FMI3EnterInitializationMode(supervisor, fmi3False, 0.0, tStart, fmi3True, tEnd));
 
     // Exchange data Controller -> Plantmodel
@@ -79,10 +241,15 @@ int main(int argc, char *argv[])
     // Exchange data Plantmodel -> Supervisor
     CALL(FMI3SetFloat64(supervisor, supervisor_in_refs, 1, plantmodel_vals, 1));
 
-    // Get clock r's interval
-    CALL(FMI3GetIntervalDecimal(controller, controller_r_refs, 1, controller_interval_vals, controller_interval_qualifiers));
-    controller_r_period = controller_interval_vals[0];
-    controller_r_timer = controller_r_period;
+    // Schedule clock r with its exact interval and shift
+    CALL(FMI3GetIntervalFraction(controller, controller_r_refs, 1, controller_interval_counters, controller_interval_resolutions, controller_interval_qualifiers));
+    CALL(FMI3GetShiftFraction(controller, controller_r_refs, 1, controller_shift_counters, controller_shift_resolutions));
+    CALL(ClockCalendarAddPeriodicClock(calendar, controller_r_clock,
+        controller_interval_counters[0], controller_interval_resolutions[0],
+        controller_shift_counters[0], controller_shift_resolutions[0]));
+
+    // The clocked partitions have been evaluated during initialization, so ticks at the start time are skipped
+    ClockCalendarPopDue(calendar, 0, dueClocks, N_CLOCKS);
 
     // Initialize event indicators
     CALL(FMI3GetEventIndicators(supervisor, supervisor_evt_vals, 1));
@@ -98,164 +265,133 @@ int main(int argc, char *argv[])
     CALL(FMI3EnterContinuousTimeMode(plant));
     CALL(FMI3EnterContinuousTimeMode(supervisor));
 
-    // Record initial outputs
-    CALL(recordVariables(outputFile, controller, plant, time));
+    // Create the integrator for the continuous states of the Plantmodel
+    CALL(FMI3GetNumberOfContinuousStates(plant, &plantmodel_nx));
+
+    plantDescription = readModelDescription("Plant");
+    plantmodel_state_refs = (fmi3ValueReference*)calloc(plantmodel_nx + 1, sizeof(fmi3ValueReference));
+    plantmodel_derivative_refs = (fmi3ValueReference*)calloc(plantmodel_nx + 1, sizeof(fmi3ValueReference));
+    plantmodel_jacobian_pattern = (bool*)calloc(plantmodel_nx * plantmodel_nx + 1, sizeof(bool));
+
+    if (!plantDescription || !plantmodel_state_refs || !plantmodel_derivative_refs || !plantmodel_jacobian_pattern ||
+        !readJacobianStructure(plantDescription, plantmodel_nx, plantmodel_state_refs, plantmodel_derivative_refs, plantmodel_jacobian_pattern)) {
+        puts("Failed to read the continuous states of the Plantmodel.");
+        status = FMIError;
+        goto TERMINATE;
+    }
+
+    // The implicit solvers use the directional derivatives of the Plantmodel, or finite differences otherwise
+    if (plantDescription->modelExchange.providesDirectionalDerivatives) {
+        solverSettings.stateReferences = plantmodel_state_refs;
+        solverSettings.derivativeReferences = plantmodel_derivative_refs;
+    }
 
-    // Get number of simulation steps to be carried out. 
-    int nSteps = (int)ceil((tEnd - tStart) / h) + 1; // +1 to include tEnd
+    solverSettings.jacobianPattern = plantmodel_jacobian_pattern;
+
+    solver = SolverCreate(plant, plantmodel_nx, &solverSettings);
+
+    if (!solver) {
+        puts("Failed to create solver.");
+        status = FMIError;
+        goto TERMINATE;
+    }
+
+    CALL(SolverReset(solver, time));
+
+    // Create the locator for the zero crossings of the Supervisor's event indicator
+    locator = EventLocatorCreate(1, STATE_EVENT_TOLERANCE, STATE_EVENT_MAX_ITERATIONS);
+    eventIndicatorContext.plantmodel_states = (fmi3Float64*)calloc(plantmodel_nx + 1, sizeof(fmi3Float64));
+
+    if (!locator || !eventIndicatorContext.plantmodel_states) {
+        puts("Failed to create event locator.");
+        status = FMIError;
+        goto TERMINATE;
+    }
+
+    eventIndicatorContext.solver = solver;
+    eventIndicatorContext.plant = plant;
+    eventIndicatorContext.supervisor = supervisor;
+    eventIndicatorContext.continuousConnections = continuousConnections;
+    eventIndicatorContext.plantmodel_nx = plantmodel_nx;
+
+    // Record initial outputs
+    CALL(recordVariables(resultSink, controller, plant, time));
 
     // Main simulation loop
-    for (int i = 0; i < nSteps; i++) {
-        // Advance time and update timers
-        time = tStart + i*h;
-        controller_r_timer -= h;
+    while (time < tEnd && !eventInfo.terminateSimulation) {
+        // Integrate the Plantmodel until the next tick of clock r or the next time event of an FMU at most
+        fmi3Float64 tReached = time;
+        ClockCalendarNextTick(calendar, &nextTick);
+        const fmi3Float64 tNextTick = ClockCalendarToTime(calendar, nextTick);
+
+        fmi3Float64 tNextEvent = tNextTick;
+        fmi3Float64 tNextInstanceEvent = 0.0;
 
-        // Check for state events or time events.
-        bool timeEvent = controller_r_timer <= 0.0;
+        if (SchedulerNextEventTime(scheduler, &tNextInstanceEvent)) {
+            tNextEvent = fmin(tNextEvent, tNextInstanceEvent);
+        }
 
+        CALL(SolverStep(solver, fmin(tNextEvent, tEnd), &tReached));
+
+        // Set FMU time. The solver has already set the time of the Plantmodel.
+        CALL(FMI3SetTime(supervisor, tReached));
+
+        // Exchange data Plantmodel -> Supervisor
+        CALL(ConnectionPlanExchange(continuousConnections));
+
+        // Check for state events
         CALL(FMI3GetEventIndicators(supervisor, supervisor_evt_vals, 1));
-        bool stateEvent = supervisor_event_indicator * supervisor_evt_vals[0] < 0.0;
+        bool stateEvent = EventLocatorCrossed(locator, &supervisor_event_indicator, supervisor_evt_vals);
+
+        if (stateEvent) {
+            // Locate the zero crossing within the step and truncate the step there
+            CALL(EventLocatorFind(locator, getSupervisorEventIndicators, &eventIndicatorContext,
+                time, &supervisor_event_indicator, tReached, supervisor_evt_vals, &tReached, supervisor_evt_vals));
+
+            // Leave the Plantmodel and the Supervisor at the located event
+            CALL(getSupervisorEventIndicators(&eventIndicatorContext, tReached, supervisor_evt_vals));
+
+            printf("Located state event at t=%.12g \n", tReached);
+        }
+
         supervisor_event_indicator = supervisor_evt_vals[0];
 
+        // Advance time
+        time = tReached;
+
+        CALL(FMI3SetTime(controller, time));
+
+        // Check for time events. The solver stops exactly at the next tick or time event.
+        size_t nDueClocks = time >= tNextTick ? ClockCalendarPopDue(calendar, nextTick, dueClocks, N_CLOCKS) : 0;
+        bool timeEvent = SchedulerSetTimeEvents(scheduler, time) || nDueClocks > 0;
+
         printf("Time event: %d \t State Event: %d \n", timeEvent, stateEvent);
 
         // Check if controller or supervisor need to execute
         if (timeEvent || stateEvent) {
-            if (timeEvent && !stateEvent) {
-                printf("Entering event mode for ticking clock r. \n");
-
-                // Reset timer
-                controller_r_timer = controller_r_period;
-
-                // Put Controller into event mode, as clocks are about to tick
-                CALL(FMI3EnterEventMode(controller));
-                // Put Plantmodel into event mode, as its input is a discrete time variable
-                CALL(FMI3EnterEventMode(plant));
-
-                // Handle time event in controller
-                CALL(handleTimeEventController(controller, plant));
-
-                // Update discrete states of the controller
-                CALL(FMI3UpdateDiscreteStates(controller, 
-                    &controller_FMI3UpdateDiscreteStatesOutput.discreteStatesNeedUpdate, 
-                    &controller_FMI3UpdateDiscreteStatesOutput.terminateSimulation, 
-                    &controller_FMI3UpdateDiscreteStatesOutput.nominalsChanged, 
-                    &controller_FMI3UpdateDiscreteStatesOutput.statesChanged, 
-                    &controller_FMI3UpdateDiscreteStatesOutput.nextEventTimeDefined, 
-                    &controller_FMI3UpdateDiscreteStatesOutput.nextEventTime));
-                CALL(FMI3UpdateDiscreteStates(plant, 
-                    &plant_FMI3UpdateDiscreteStatesOutput.discreteStatesNeedUpdate, 
-                    &plant_FMI3UpdateDiscreteStatesOutput.terminateSimulation, 
-                    &plant_FMI3UpdateDiscreteStatesOutput.nominalsChanged, 
-                    &plant_FMI3UpdateDiscreteStatesOutput.statesChanged, 
-                    &plant_FMI3UpdateDiscreteStatesOutput.nextEventTimeDefined, 
-                    &plant_FMI3UpdateDiscreteStatesOutput.nextEventTime));
-
-                // Exit event mode
-                CALL(FMI3EnterContinuousTimeMode(controller));
-                CALL(FMI3EnterContinuousTimeMode(plant));
-                printf("Exiting event mode. \n");
-            }
-            else if (!timeEvent && stateEvent) {
-                printf("Entering event mode for ticking clock s. \n");
-
-                // Put Supervisor and Controller into event mode, as clocks are about to tick. Note the flags used.
-                CALL(FMI3EnterEventMode(supervisor));
-                CALL(FMI3EnterEventMode(controller));
-
-                // Handle state event supervisor
-                CALL(handleStateEventSupervisor(controller, supervisor));
-
-                // Update discrete states of the controller and supervisor
-                CALL(FMI3UpdateDiscreteStates(supervisor, 
-                    &supervisor_FMI3UpdateDiscreteStatesOutput.discreteStatesNeedUpdate, 
-                    &supervisor_FMI3UpdateDiscreteStatesOutput.terminateSimulation, 
-                    &supervisor_FMI3UpdateDiscreteStatesOutput.nominalsChanged, 
-                    &supervisor_FMI3UpdateDiscreteStatesOutput.statesChanged, 
-                    &supervisor_FMI3UpdateDiscreteStatesOutput.nextEventTimeDefined, 
-                    &supervisor_FMI3UpdateDiscreteStatesOutput.nextEventTime));
-                CALL(FMI3UpdateDiscreteStates(controller, 
-                    &controller_FMI3UpdateDiscreteStatesOutput.discreteStatesNeedUpdate, 
-                    &controller_FMI3UpdateDiscreteStatesOutput.terminateSimulation, 
-                    &controller_FMI3UpdateDiscreteStatesOutput.nominalsChanged, 
-                    &controller_FMI3UpdateDiscreteStatesOutput.statesChanged, 
-                    &controller_FMI3UpdateDiscreteStatesOutput.nextEventTimeDefined, 
-                    &controller_FMI3UpdateDiscreteStatesOutput.nextEventTime));
-
-                // Exit event mode
-                CALL(FMI3EnterContinuousTimeMode(supervisor));
-                CALL(FMI3EnterContinuousTimeMode(controller));
-                printf("Exiting event mode. \n");
+            for (size_t i = 0; i < nDueClocks; i++) {
+                CALL(SchedulerActivateClock(scheduler, dueClocks[i]));
             }
-            else {
-                assert(timeEvent && stateEvent);
-
-                // Reset timer
-                controller_r_timer = controller_r_period;
-
-                // Handle both time event and state event.
-                printf("Entering event mode for ticking clocks s and r. \n");
-                // Now we must respect the dependencies. The supervisor gets priority, and then the controller.
-
-                // Put Supervisor and Controller into event mode, as clocks are about to tick.
-                CALL(FMI3EnterEventMode(supervisor));
-                CALL(FMI3EnterEventMode(controller));
-                // Put Plantmodel into event mode, as its input is a discrete time variable
-                CALL(FMI3EnterEventMode(plant));
-
-                CALL(handleStateEventSupervisor(controller, supervisor));
-                CALL(handleTimeEventController(controller, plant));
-
-                // Update discrete states of the controller and supervisor
-                CALL(FMI3UpdateDiscreteStates(supervisor, 
-                    &supervisor_FMI3UpdateDiscreteStatesOutput.discreteStatesNeedUpdate, 
-                    &supervisor_FMI3UpdateDiscreteStatesOutput.terminateSimulation, 
-                    &supervisor_FMI3UpdateDiscreteStatesOutput.nominalsChanged, 
-                    &supervisor_FMI3UpdateDiscreteStatesOutput.statesChanged, 
-                    &supervisor_FMI3UpdateDiscreteStatesOutput.nextEventTimeDefined, 
-                    &supervisor_FMI3UpdateDiscreteStatesOutput.nextEventTime));
-                CALL(FMI3UpdateDiscreteStates(controller, 
-                    &controller_FMI3UpdateDiscreteStatesOutput.discreteStatesNeedUpdate, 
-                    &controller_FMI3UpdateDiscreteStatesOutput.terminateSimulation, 
-                    &controller_FMI3UpdateDiscreteStatesOutput.nominalsChanged, 
-                    &controller_FMI3UpdateDiscreteStatesOutput.statesChanged, 
-                    &controller_FMI3UpdateDiscreteStatesOutput.nextEventTimeDefined, 
-                    &controller_FMI3UpdateDiscreteStatesOutput.nextEventTime));
-                CALL(FMI3UpdateDiscreteStates(plant, 
-                    &plant_FMI3UpdateDiscreteStatesOutput.discreteStatesNeedUpdate, 
-                    &plant_FMI3UpdateDiscreteStatesOutput.terminateSimulation, 
-                    &plant_FMI3UpdateDiscreteStatesOutput.nominalsChanged, 
-                    &plant_FMI3UpdateDiscreteStatesOutput.statesChanged, 
-                    &plant_FMI3UpdateDiscreteStatesOutput.nextEventTimeDefined, 
-                    &plant_FMI3UpdateDiscreteStatesOutput.nextEventTime));
-
-                // Exit event mode
-                CALL(FMI3EnterContinuousTimeMode(supervisor));
-                CALL(FMI3EnterContinuousTimeMode(controller));
-                CALL(FMI3EnterContinuousTimeMode(plant));
-                printf("Exiting event mode. \n");
+
+            if (stateEvent) {
+                CALL(SchedulerSetStateEvent(scheduler, supervisor));
             }
-        }
 
-        // Estimate next Plantmodel state
-        CALL(FMI3GetContinuousStates(plant, plantmodel_vals, 1));
-        CALL(FMI3GetContinuousStateDerivatives(plant, plantmodel_der_vals, 1));
-        plantmodel_vals[0] += h * plantmodel_der_vals[0];
+            // Handle the active clocks in the order of their dependencies
+            printf("Entering event mode. \n");
+            CALL(SchedulerHandleEvents(scheduler, &eventInfo));
+            printf("Exiting event mode after %zu iteration(s). \n", eventInfo.nIterations);
 
-        // Set FMU time
-        CALL(FMI3SetTime(plant, time));
-        CALL(FMI3SetTime(controller, time));
-        CALL(FMI3SetTime(supervisor, time));
+            if (eventInfo.terminateSimulation) {
+                printf("Simulation terminated by an FMU at t=%g. \n", time);
+            }
 
-        // Update Plantmodel state
-        CALL(FMI3SetContinuousStates(plant, plantmodel_vals, 1));
+            // The input of the Plantmodel may have changed, so the integration restarts at the event
+            CALL(SolverReset(solver, time));
+        }
 
-        // Exchange data Plantmodel -> Supervisor
-        CALL(FMI3GetFloat64(plant, plantmodel_y_refs, 1, plantmodel_vals, 1));
-        CALL(FMI3SetFloat64(supervisor, supervisor_in_refs, 1, plantmodel_vals, 1));
-        
         // Record data
-        CALL(recordVariables(outputFile, controller, plant, time));
+        CALL(recordVariables(resultSink, controller, plant, time));
     }
 
     // Trigger reset just for testing purposes
@@ -267,13 +403,34 @@ int main(int argc, char *argv[])
     CALL(FMI3Terminate(plant));
     CALL(FMI3Terminate(supervisor));
 
+    const SolverStatistics* statistics = SolverGetStatistics(solver);
+    printf("Solver %s: %zu steps, %zu rejected steps, %zu derivative evaluations, %zu Jacobian evaluations, %zu decompositions \n",
+        SolverTypeToString(solverSettings.type), statistics->nSteps, statistics->nRejectedSteps, statistics->nDerivativeEvaluations,
+        statistics->nJacobianEvaluations, statistics->nDecompositions);
+
+    const EventLocatorStatistics* locatorStatistics = EventLocatorGetStatistics(locator);
+    printf("Event locator: %zu state events, %zu event indicator evaluations \n", locatorStatistics->nEvents, locatorStatistics->nEvaluations);
+
 TERMINATE:
 
-    CALL(FMI3FreeInstance(controller));
-    CALL(FMI3FreeInstance(plant));
-    CALL(FMI3FreeInstance(supervisor));
+    SolverFree(solver);
+    ModelDescriptionFree(plantDescription);
+    free(plantmodel_state_refs);
+    free(plantmodel_derivative_refs);
+    free(plantmodel_jacobian_pattern);
+    EventLocatorFree(locator);
+    ClockCalendarFree(calendar);
+    ConnectionPlanFree(continuousConnections);
+    SchedulerFree(scheduler);
+    free(eventIndicatorContext.plantmodel_states);
+
+    FMI3FreeInstance(controller);
+    FMI3FreeInstance(plant);
+    FMI3FreeInstance(supervisor);
+
+    CallTraceFree(callTrace);
 
-    fclose(outputFile);
+    ResultSinkFree(resultSink);
 
     printf("Done! \n");
 
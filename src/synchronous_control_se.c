@@ -0,0 +1,302 @@
+/*
+The example consists of a controller and a plant, and a supervisor FMU.
+The plant and the supervisor use co-simulation, the controller uses scheduled execution in FMI3.0.
+The model partitions of the input clocks r and s of the controller run on the worker threads
+of a task runtime, ordered by the priorities of the clocks.
+
+See more details in [README.md](./README.md)
+*/
+
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <math.h>
+#include <stdbool.h>
+#include <assert.h>
+
+#include "FMI3.h"
+#include "clock_calendar.h"
+#include "model_description.h"
+#include "task_runtime.h"
+#include "orchestration_common.h"
+
+
+int main(int argc, char *argv[])
+{
+    printf("Running Supervisory Control example... \n");
+
+    // Worker threads for the model partitions, e.g. --threads=2
+    const char* threadsOption = getOption(argc, argv, "threads");
+
+    const size_t nThreads = threadsOption ? (size_t)atoi(threadsOption) : 1;
+
+    FMIStatus status = FMIOK;
+    fmi3Float64 h = FIXED_STEP;
+    fmi3Float64 time = 0;
+
+    // Runs the activated partitions of the controller
+    TaskRuntime* runtime = NULL;
+
+    // Binary trace of the FMI calls
+    CallTrace* callTrace = NULL;
+
+    // The priorities of the clocks of the controller
+    ModelDescription* controllerDescription = NULL;
+    fmi3UInt32 controller_r_priority = 0;
+    fmi3UInt32 controller_s_priority = 0;
+
+    // Will hold exchanged values: Controller -> Plantmodel
+    fmi3Float64 controller_vals[] = { 0.0 };
+    // Will hold exchanged values: Plantmodel -> Supervisor
+    fmi3Float64 plantmodel_vals[] = { 0.0 };
+    // Will hold exchanged values: Supervisor -> Controller
+    fmi3Float64 supervisor_vals[] = { 0.0 };
+    fmi3Clock supervisor_s[] = { fmi3ClockInactive };
+
+    // Calendar of the periodic clocks on an integer time base
+    ClockCalendar* calendar = ClockCalendarCreate();
+    const size_t controller_r_clock = 0;
+    size_t dueClocks[N_CLOCKS];
+    fmi3UInt64 stepTicks = 0;
+    // Will hold output from FMI3GetIntervalFraction and FMI3GetShiftFraction
+    fmi3UInt64 controller_interval_counters[] = { 0 };
+    fmi3UInt64 controller_interval_resolutions[] = { 1 };
+    fmi3IntervalQualifier controller_interval_qualifiers[] = { fmi3IntervalNotYetKnown };
+    fmi3UInt64 controller_shift_counters[] = { 0 };
+    fmi3UInt64 controller_shift_resolutions[] = { 1 };
+
+    // Open the result file, e.g. --result=synchronous_control_se.res
+    ResultSink* resultSink = initializeResultSink(argc, argv, "synchronous_control_se_out.res");
+    if (!resultSink) {
+        return EXIT_FAILURE;
+    }
+
+    if (!calendar) {
+        puts("Failed to create clock calendar.");
+        return EXIT_FAILURE;
+    }
+
+    // Load the FMUs from their archives, e.g. --fmu-dir=../fmus
+    if (extractFMUs(argc, argv) != FMIOK) {
+        return EXIT_FAILURE;
+    }
+
+    // Instantiate
+    FMIInstance* controller = createInstance("controller", "Controller");
+    FMIInstance* plant      = createInstance("plant",      "Plant");
+    FMIInstance* supervisor = createInstance("supervisor", "Supervisor");
+
+    if (!controller || !plant || !supervisor) {
+        puts("Failed to load shared libraries.");
+        return FMIError;
+    }
+
+    // Value references of the exchanged variables from the modelDescription.xml files
+    CALL(resolveValueReferences());
+
+    // Tracing of the FMI calls, e.g. --trace-interval=100
+    setTraceOptions(controller, argc, argv);
+    setTraceOptions(plant,      argc, argv);
+    setTraceOptions(supervisor, argc, argv);
+
+    // Binary trace of the FMI calls, e.g. --call-trace=synchronous_control_se.trace
+    CALL(setCallTraceOption(&callTrace, argc, argv, controller, plant, supervisor));
+
+    controllerDescription = readModelDescription("Controller");
+
+    if (!controllerDescription) {
+        puts("Failed to read the model description of the controller.");
+        status = FMIError;
+        goto TERMINATE;
+    }
+
+    const ModelVariable* r = ModelDescriptionFindVariable(controllerDescription, "r");
+    const ModelVariable* s = ModelDescriptionFindVariable(controllerDescription, "s");
+
+    if (!r || !s) {
+        puts("Failed to find the clocks r and s.");
+        status = FMIError;
+        goto TERMINATE;
+    }
+
+    controller_r_priority = r->priority;
+    controller_s_priority = s->priority;
+
+    runtime = TaskRuntimeCreate(nThreads);
+
+    if (!runtime) {
+        puts("Failed to create task runtime.");
+        status = FMIError;
+        goto TERMINATE;
+    }
+
+    printf("Task runtime: %zu thread(s) \n", nThreads);
+
+    CALL(FMI3InstantiateScheduledExecution(controller, "{e1f14bf0-302d-4ef9-b11c-e01c7ed456cb}", NULL, fmi3False, fmi3True, NULL, NULL,
+        TaskRuntimeClockUpdate, TaskRuntimeLockPreemption, TaskRuntimeUnlockPreemption));
+    CALL(FMI3InstantiateCoSimulation(plant,      "{6e81b08d-97be-4de1-957f-8358a4e83184}", NULL, fmi3False, fmi3True, fmi3True, fmi3False, NULL, 0, NULL));
+
+    // Internal solver of the plant, e.g. --plant-max-step=1e-3 --plant-tolerance=1e-10
+    CALL(setPlantSolverOptions(plant, argc, argv));
+    CALL(FMI3InstantiateCoSimulation(supervisor, "{64202d14-799a-4379-9fb3-79354aec17b2}", NULL, fmi3False, fmi3True, fmi3True, fmi3False, NULL, 0, NULL));
+
+    // Debug logging of the FMUs, e.g. --log-categories=logStatusError
+    CALL(setLogCategoryOptions(controller, argc, argv));
+    CALL(setLogCategoryOptions(plant,      argc, argv));
+    CALL(setLogCategoryOptions(supervisor, argc, argv));
+
+    // Initialize
+    CALL(FMI3EnterInitializationMode(controller, fmi3False, 0.0, tStart, fmi3True, tEnd));
+    CALL(FMI3EnterInitializationMode(plant,      fmi3False, 0.0, tStart, fmi3True, tEnd));
+    CALL(FMI3EnterInitializationMode(supervisor, fmi3False, 0.0, tStart, fmi3True, tEnd));
+
+    // Exchange data Controller -> Plantmodel
+    CALL(FMI3GetFloat64(controller, controller_y_refs, 1, controller_vals, 1));
+    CALL(FMI3SetFloat64(plant,      plantmodel_u_refs, 1, controller_vals, 1));
+
+    // Exchange data Plantmodel -> Supervisor
+    CALL(FMI3SetFloat64(supervisor, supervisor_in_refs, 1, plantmodel_vals, 1));
+
+    // Schedule clock r with its exact interval and shift
+    CALL(FMI3GetIntervalFraction(controller, controller_r_refs, 1, controller_interval_counters, controller_interval_resolutions, controller_interval_qualifiers));
+    CALL(FMI3GetShiftFraction(controller, controller_r_refs, 1, controller_shift_counters, controller_shift_resolutions));
+    CALL(ClockCalendarAddPeriodicClock(calendar, controller_r_clock,
+        controller_interval_counters[0], controller_interval_resolutions[0],
+        controller_shift_counters[0], controller_shift_resolutions[0]));
+
+    // The partitions have been evaluated during initialization, so ticks at the start time are skipped
+    ClockCalendarPopDue(calendar, 0, dueClocks, N_CLOCKS);
+
+    // The communication step on the time base of the calendar
+    CALL(ClockCalendarAddResolution(calendar, FIXED_STEP_RESOLUTION));
+    stepTicks = FIXED_STEP_COUNTER * (ClockCalendarResolution(calendar) / FIXED_STEP_RESOLUTION);
+
+    // The controller enters clock activation mode
+    CALL(FMI3ExitInitializationMode(controller));
+    CALL(FMI3ExitInitializationMode(plant));
+    CALL(FMI3ExitInitializationMode(supervisor));
+
+    time = tStart;
+
+    CALL(FMI3EnterStepMode(plant));
+    CALL(FMI3EnterStepMode(supervisor));
+
+    // Record initial outputs
+    CALL(recordVariables(resultSink, controller, plant, time));
+
+    // Get number of simulation steps to be carried out.
+    int nSteps = (int)ceil((tEnd - tStart) / h) + 1; // +1 to include tEnd
+
+    // Main simulation loop
+    for (int i = 0; i < nSteps; i++) {
+        fmi3Boolean stateEvent = fmi3False;
+        fmi3Boolean eventHandlingNeeded = fmi3False;
+        fmi3Boolean terminateSimulation = fmi3False;
+        fmi3Boolean earlyReturn = fmi3False;
+        fmi3Float64 lastSuccessfulTime = 0.0;
+
+        const fmi3Float64 tStep = tStart + i * h;
+
+        // Step the co-simulation FMUs from the same inputs
+        CALL(FMI3DoStep(plant, tStep, h, fmi3True, &eventHandlingNeeded, &terminateSimulation, &earlyReturn, &lastSuccessfulTime));
+
+        if (terminateSimulation) {
+            printf("Simulation terminated by an FMU at t=%g. \n", time);
+            break;
+        }
+
+        CALL(FMI3DoStep(supervisor, tStep, h, fmi3True, &stateEvent, &terminateSimulation, &earlyReturn, &lastSuccessfulTime));
+
+        if (terminateSimulation) {
+            printf("Simulation terminated by an FMU at t=%g. \n", time);
+            break;
+        }
+
+        // Exchange data Plantmodel -> Supervisor
+        CALL(FMI3GetFloat64(plant,      plantmodel_y_refs,  1, plantmodel_vals, 1));
+        CALL(FMI3SetFloat64(supervisor, supervisor_in_refs, 1, plantmodel_vals, 1));
+
+        // Advance time
+        time = tStart + i*h;
+
+        // Check for time events. A time event is due once i + 1 steps have reached it.
+        size_t nDueClocks = ClockCalendarPopDue(calendar, (i + 1) * stepTicks, dueClocks, N_CLOCKS);
+        bool timeEvent = nDueClocks > 0;
+
+        // Record data
+        CALL(recordVariables(resultSink, controller, plant, time));
+
+        printf("Time event: %d \t State Event: %d \n", timeEvent, stateEvent);
+
+        // The supervisor ticks clock s at its state events and sets as before the partition of s is activated
+        if (stateEvent) {
+            fmi3Boolean discreteStatesNeedUpdate = fmi3False;
+            fmi3Boolean nominalsOfContinuousStatesChanged = fmi3False;
+            fmi3Boolean valuesOfContinuousStatesChanged = fmi3False;
+            fmi3Boolean nextEventTimeDefined = fmi3False;
+            fmi3Float64 nextEventTime = 0.0;
+
+            CALL(FMI3EnterEventMode(supervisor));
+            CALL(FMI3GetClock(supervisor, supervisor_s_refs, 1, supervisor_s));
+
+            if (supervisor_s[0]) {
+                CALL(FMI3GetFloat64(supervisor, supervisor_as_refs, 1, supervisor_vals, 1));
+                CALL(FMI3SetFloat64(controller, controller_as_refs, 1, supervisor_vals, 1));
+                CALL(TaskRuntimeActivate(runtime, controller, controller_s_refs[0], controller_s_priority, tStart + (i + 1) * h));
+            }
+
+            CALL(FMI3UpdateDiscreteStates(supervisor, &discreteStatesNeedUpdate, &terminateSimulation,
+                &nominalsOfContinuousStatesChanged, &valuesOfContinuousStatesChanged, &nextEventTimeDefined, &nextEventTime));
+            CALL(FMI3EnterStepMode(supervisor));
+
+            if (terminateSimulation) {
+                printf("Simulation terminated by an FMU at t=%g. \n", time);
+                break;
+            }
+        }
+
+        for (size_t j = 0; j < nDueClocks; j++) {
+            CALL(TaskRuntimeActivate(runtime, controller, controller_r_refs[0], controller_r_priority, tStart + (i + 1) * h));
+        }
+
+        // The outputs of the partitions are read once all of them have finished
+        if (timeEvent || stateEvent) {
+            CALL(TaskRuntimeWait(runtime));
+
+            // Exchange data Controller -> Plantmodel
+            CALL(FMI3GetFloat64(controller, controller_y_refs, 1, controller_vals, 1));
+            CALL(FMI3SetFloat64(plant,      plantmodel_u_refs, 1, controller_vals, 1));
+        }
+    }
+
+    // Trigger reset just for testing purposes
+    CALL(FMI3Reset(controller));
+    CALL(FMI3Reset(plant));
+    CALL(FMI3Reset(supervisor));
+
+    CALL(FMI3Terminate(controller));
+    CALL(FMI3Terminate(plant));
+    CALL(FMI3Terminate(supervisor));
+
+    printf("Task runtime: %zu partition activations \n", TaskRuntimeGetStatistics(runtime)->nActivations);
+
+TERMINATE:
+
+    // Let running partitions finish before the instances are freed
+    TaskRuntimeFree(runtime);
+
+    FMI3FreeInstance(controller);
+    FMI3FreeInstance(plant);
+    FMI3FreeInstance(supervisor);
+
+    CallTraceFree(callTrace);
+
+    ModelDescriptionFree(controllerDescription);
+    ClockCalendarFree(calendar);
+
+    ResultSinkFree(resultSink);
+
+    printf("Done! \n");
+
+    return status == FMIOK ? EXIT_SUCCESS : EXIT_FAILURE;
+}
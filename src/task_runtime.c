@@ -0,0 +1,312 @@
+#include <stdlib.h>
+#include <stdbool.h>
+
+#include "task_runtime.h"
+#include "threading.h"
+
+typedef struct {
+    FMIInstance *instance;
+    fmi3ValueReference clockReference;
+    fmi3UInt32 priority;
+    fmi3Float64 activationTime;
+    size_t sequence;  // order of activation among equal priorities
+} Activation;
+
+struct TaskRuntime_ {
+
+    size_t nThreads;
+    Thread *threads;
+
+    Mutex mutex;
+    Condition workAvailable;
+    Condition workDone;
+
+    // queue, guarded by mutex
+    Activation *queue;
+    size_t nQueued;
+    size_t capacity;
+    size_t nextSequence;
+    size_t nRunning;
+    FMIStatus status;
+
+    // instances of the running activations, guarded by mutex
+    FMIInstance **runningInstances;
+
+    TaskRuntimeStatistics statistics;
+
+    bool shutdown;
+
+    // lockPreemption() / unlockPreemption()
+    Mutex preemptionMutex;
+};
+
+// The preemption callbacks have no arguments
+static TaskRuntime *activeRuntime = NULL;
+
+static bool isRunning(const TaskRuntime *runtime, const FMIInstance *instance) {
+
+    for (size_t i = 0; i < runtime->nRunning; i++) {
+        if (runtime->runningInstances[i] == instance) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/* Removes the activation with the highest priority from the queue whose instance
+   is not running. Returns false if there is no such activation. */
+static bool popActivation(TaskRuntime *runtime, Activation *activation) {
+
+    size_t next = runtime->nQueued;
+
+    for (size_t i = 0; i < runtime->nQueued; i++) {
+
+        const Activation *a = &runtime->queue[i];
+
+        if (isRunning(runtime, a->instance)) {
+            continue;
+        }
+
+        const Activation *b = &runtime->queue[next];
+
+        if (next == runtime->nQueued || a->priority < b->priority || (a->priority == b->priority && a->sequence < b->sequence)) {
+            next = i;
+        }
+    }
+
+    if (next == runtime->nQueued) {
+        return false;
+    }
+
+    *activation = runtime->queue[next];
+
+    // the order is kept by the sequence numbers
+    runtime->queue[next] = runtime->queue[--runtime->nQueued];
+
+    return true;
+}
+
+/* Runs an activation that has been popped with runtime->mutex locked. */
+static void runActivation(TaskRuntime *runtime, const Activation *activation) {
+
+    runtime->runningInstances[runtime->nRunning++] = activation->instance;
+
+    MUTEX_UNLOCK(&runtime->mutex);
+
+    const FMIStatus status = FMI3ActivateModelPartition(activation->instance, activation->clockReference, activation->activationTime);
+
+    MUTEX_LOCK(&runtime->mutex);
+
+    for (size_t i = 0; i < runtime->nRunning; i++) {
+        if (runtime->runningInstances[i] == activation->instance) {
+            runtime->runningInstances[i] = runtime->runningInstances[--runtime->nRunning];
+            break;
+        }
+    }
+
+    runtime->statistics.nActivations++;
+
+    if (status > runtime->status) {
+        runtime->status = status;
+    }
+
+    if (runtime->nQueued == 0 && runtime->nRunning == 0) {
+        COND_BROADCAST(&runtime->workDone);
+    } else if (runtime->nQueued > 0) {
+        // activations of this instance may have been held back
+        COND_BROADCAST(&runtime->workAvailable);
+    }
+}
+
+static void work(TaskRuntime *runtime) {
+
+    MUTEX_LOCK(&runtime->mutex);
+
+    Activation activation;
+
+    for (;;) {
+
+        while (!runtime->shutdown && !popActivation(runtime, &activation)) {
+            COND_WAIT(&runtime->workAvailable, &runtime->mutex);
+        }
+
+        if (runtime->shutdown) {
+            break;
+        }
+
+        runActivation(runtime, &activation);
+    }
+
+    MUTEX_UNLOCK(&runtime->mutex);
+}
+
+static ThreadResult THREAD_CALL threadMain(void *argument) {
+    work((TaskRuntime*)argument);
+    return 0;
+}
+
+TaskRuntime* TaskRuntimeCreate(size_t nThreads) {
+
+    if (activeRuntime) {
+        return NULL;
+    }
+
+    TaskRuntime *runtime = (TaskRuntime*)calloc(1, sizeof(TaskRuntime));
+
+    if (!runtime) {
+        return NULL;
+    }
+
+    runtime->threads = (Thread*)calloc(nThreads + 1, sizeof(Thread));
+    runtime->runningInstances = (FMIInstance**)calloc(nThreads + 1, sizeof(FMIInstance*));
+
+    if (!runtime->threads || !runtime->runningInstances) {
+        free(runtime->runningInstances);
+        free(runtime->threads);
+        free(runtime);
+        return NULL;
+    }
+
+    MUTEX_INIT(&runtime->mutex);
+    MUTEX_INIT(&runtime->preemptionMutex);
+    COND_INIT(&runtime->workAvailable);
+    COND_INIT(&runtime->workDone);
+
+    activeRuntime = runtime;
+
+    for (size_t i = 0; i < nThreads; i++) {
+        if (!THREAD_CREATE(&runtime->threads[i], threadMain, runtime)) {
+            TaskRuntimeFree(runtime);
+            return NULL;
+        }
+
+        runtime->nThreads++;
+    }
+
+    return runtime;
+}
+
+void TaskRuntimeFree(TaskRuntime *runtime) {
+
+    if (!runtime) {
+        return;
+    }
+
+    MUTEX_LOCK(&runtime->mutex);
+    runtime->shutdown = true;
+    COND_BROADCAST(&runtime->workAvailable);
+    MUTEX_UNLOCK(&runtime->mutex);
+
+    for (size_t i = 0; i < runtime->nThreads; i++) {
+        THREAD_JOIN(runtime->threads[i]);
+    }
+
+    if (activeRuntime == runtime) {
+        activeRuntime = NULL;
+    }
+
+    COND_DESTROY(&runtime->workAvailable);
+    COND_DESTROY(&runtime->workDone);
+    MUTEX_DESTROY(&runtime->preemptionMutex);
+    MUTEX_DESTROY(&runtime->mutex);
+
+    free(runtime->queue);
+    free(runtime->runningInstances);
+    free(runtime->threads);
+    free(runtime);
+}
+
+FMIStatus TaskRuntimeActivate(TaskRuntime *runtime, FMIInstance *instance, fmi3ValueReference clockReference, fmi3UInt32 priority, fmi3Float64 activationTime) {
+
+    if (instance->interfaceType != FMIScheduledExecution) {
+        if (instance->logMessage) {
+            instance->logMessage(instance, FMIError, "logStatusError", "Partitions can only be activated in Scheduled Execution.");
+        }
+        return FMIError;
+    }
+
+    MUTEX_LOCK(&runtime->mutex);
+
+    if (runtime->nQueued == runtime->capacity) {
+
+        const size_t capacity = runtime->capacity ? 2 * runtime->capacity : 8;
+
+        Activation *queue = (Activation*)realloc(runtime->queue, capacity * sizeof(Activation));
+
+        if (!queue) {
+            MUTEX_UNLOCK(&runtime->mutex);
+            return FMIError;
+        }
+
+        runtime->queue = queue;
+        runtime->capacity = capacity;
+    }
+
+    Activation *activation = &runtime->queue[runtime->nQueued++];
+
+    activation->instance       = instance;
+    activation->clockReference = clockReference;
+    activation->priority       = priority;
+    activation->activationTime = activationTime;
+    activation->sequence       = runtime->nextSequence++;
+
+    COND_BROADCAST(&runtime->workAvailable);
+
+    MUTEX_UNLOCK(&runtime->mutex);
+
+    return FMIOK;
+}
+
+FMIStatus TaskRuntimeWait(TaskRuntime *runtime) {
+
+    MUTEX_LOCK(&runtime->mutex);
+
+    // Without workers the partitions run on the calling thread
+    if (runtime->nThreads == 0) {
+        Activation activation;
+
+        while (popActivation(runtime, &activation)) {
+            runActivation(runtime, &activation);
+        }
+    }
+
+    // barrier
+    while (runtime->nQueued > 0 || runtime->nRunning > 0) {
+        COND_WAIT(&runtime->workDone, &runtime->mutex);
+    }
+
+    const FMIStatus status = runtime->status;
+
+    runtime->status = FMIOK;
+
+    MUTEX_UNLOCK(&runtime->mutex);
+
+    return status;
+}
+
+const TaskRuntimeStatistics* TaskRuntimeGetStatistics(const TaskRuntime *runtime) {
+    return &runtime->statistics;
+}
+
+void TaskRuntimeClockUpdate(fmi3InstanceEnvironment instanceEnvironment) {
+
+    // The output clocks are not queried yet, the update is only counted
+    if (activeRuntime) {
+        MUTEX_LOCK(&activeRuntime->mutex);
+        activeRuntime->statistics.nClockUpdates++;
+        MUTEX_UNLOCK(&activeRuntime->mutex);
+    }
+}
+
+void TaskRuntimeLockPreemption(void) {
+    if (activeRuntime) {
+        MUTEX_LOCK(&activeRuntime->preemptionMutex);
+    }
+}
+
+void TaskRuntimeUnlockPreemption(void) {
+    if (activeRuntime) {
+        MUTEX_UNLOCK(&activeRuntime->preemptionMutex);
+    }
+}
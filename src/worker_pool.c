@@ -0,0 +1,162 @@
+#include <stdlib.h>
+#include <stdbool.h>
+
+#include "worker_pool.h"
+#include "threading.h"
+
+struct WorkerPool_ {
+
+    size_t nThreads;
+    Thread *threads;
+
+    Mutex mutex;
+    Condition workAvailable;
+    Condition workDone;
+
+    // current batch, guarded by mutex
+    WorkerTask *task;
+    void **arguments;
+    size_t nTasks;
+    size_t nextTask;
+    size_t nCompleted;
+    FMIStatus status;
+
+    bool shutdown;
+};
+
+static void work(WorkerPool *pool) {
+
+    MUTEX_LOCK(&pool->mutex);
+
+    for (;;) {
+
+        while (!pool->shutdown && pool->nextTask >= pool->nTasks) {
+            COND_WAIT(&pool->workAvailable, &pool->mutex);
+        }
+
+        if (pool->shutdown) {
+            break;
+        }
+
+        const size_t i = pool->nextTask++;
+
+        MUTEX_UNLOCK(&pool->mutex);
+
+        const FMIStatus status = pool->task(pool->arguments[i]);
+
+        MUTEX_LOCK(&pool->mutex);
+
+        if (status > pool->status) {
+            pool->status = status;
+        }
+
+        if (++pool->nCompleted == pool->nTasks) {
+            COND_BROADCAST(&pool->workDone);
+        }
+    }
+
+    MUTEX_UNLOCK(&pool->mutex);
+}
+
+static ThreadResult THREAD_CALL threadMain(void *argument) {
+    work((WorkerPool*)argument);
+    return 0;
+}
+
+WorkerPool* WorkerPoolCreate(size_t nThreads) {
+
+    WorkerPool *pool = (WorkerPool*)calloc(1, sizeof(WorkerPool));
+
+    if (!pool) {
+        return NULL;
+    }
+
+    pool->threads = (Thread*)calloc(nThreads + 1, sizeof(Thread));
+
+    if (!pool->threads) {
+        free(pool);
+        return NULL;
+    }
+
+    MUTEX_INIT(&pool->mutex);
+    COND_INIT(&pool->workAvailable);
+    COND_INIT(&pool->workDone);
+
+    for (size_t i = 0; i < nThreads; i++) {
+        if (!THREAD_CREATE(&pool->threads[i], threadMain, pool)) {
+            WorkerPoolFree(pool);
+            return NULL;
+        }
+
+        pool->nThreads++;
+    }
+
+    return pool;
+}
+
+void WorkerPoolFree(WorkerPool *pool) {
+
+    if (!pool) {
+        return;
+    }
+
+    MUTEX_LOCK(&pool->mutex);
+    pool->shutdown = true;
+    COND_BROADCAST(&pool->workAvailable);
+    MUTEX_UNLOCK(&pool->mutex);
+
+    for (size_t i = 0; i < pool->nThreads; i++) {
+        THREAD_JOIN(pool->threads[i]);
+    }
+
+    COND_DESTROY(&pool->workAvailable);
+    COND_DESTROY(&pool->workDone);
+    MUTEX_DESTROY(&pool->mutex);
+
+    free(pool->threads);
+    free(pool);
+}
+
+FMIStatus WorkerPoolRun(WorkerPool *pool, WorkerTask *task, void *arguments[], size_t nTasks) {
+
+    if (nTasks == 0) {
+        return FMIOK;
+    }
+
+    // Without workers the tasks run on the calling thread
+    if (pool->nThreads == 0) {
+
+        FMIStatus status = FMIOK;
+
+        for (size_t i = 0; i < nTasks; i++) {
+            const FMIStatus s = task(arguments[i]);
+            if (s > status) {
+                status = s;
+            }
+        }
+
+        return status;
+    }
+
+    MUTEX_LOCK(&pool->mutex);
+
+    pool->task       = task;
+    pool->arguments  = arguments;
+    pool->nTasks     = nTasks;
+    pool->nextTask   = 0;
+    pool->nCompleted = 0;
+    pool->status     = FMIOK;
+
+    COND_BROADCAST(&pool->workAvailable);
+
+    // barrier
+    while (pool->nCompleted < pool->nTasks) {
+        COND_WAIT(&pool->workDone, &pool->mutex);
+    }
+
+    const FMIStatus status = pool->status;
+
+    MUTEX_UNLOCK(&pool->mutex);
+
+    return status;
+}
@@ -0,0 +1,257 @@
+/*
+Checks the extraction of an FMU archive by FMUArchiveExtract(), see fmu_archive.h.
+
+    fmu_archive_test <archive> <unpacked FMU> <cache directory> <file>...
+
+The files of the extracted archive are compared byte for byte with those of the
+unpacked FMU of the build tree, and a second extraction must reuse the cached
+directory. A truncated copy and a copy with corrupted CRC-32s of the archive
+must be rejected with FMIError. The corrupt copy has the name, size and
+modification time of the archive, so it must not reuse its cached extraction.
+*/
+
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#include <sys/utime.h>
+#else
+#include <utime.h>
+#endif
+
+#include "fmu_archive.h"
+
+#define MAX_PATH_LENGTH 1024
+
+#define CENTRAL_DIRECTORY_SIGNATURE        0x02014b50
+#define END_OF_CENTRAL_DIRECTORY_SIGNATURE 0x06054b50
+
+static uint32_t read32(const uint8_t *p) {
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+static uint16_t read16(const uint8_t *p) {
+    return (uint16_t)(p[0] | p[1] << 8);
+}
+
+static uint8_t* readFile(const char *path, size_t *size) {
+
+    FILE *file = fopen(path, "rb");
+    uint8_t *data = NULL;
+
+    if (!file) {
+        return NULL;
+    }
+
+    if (!fseek(file, 0, SEEK_END)) {
+
+        const long length = ftell(file);
+
+        if (length >= 0 && !fseek(file, 0, SEEK_SET)) {
+
+            data = (uint8_t*)malloc((size_t)length + 1);
+
+            if (data && fread(data, 1, (size_t)length, file) != (size_t)length) {
+                free(data);
+                data = NULL;
+            }
+
+            *size = (size_t)length;
+        }
+    }
+
+    fclose(file);
+
+    return data;
+}
+
+static bool writeFile(const char *path, const uint8_t *data, size_t size) {
+
+    FILE *file = fopen(path, "wb");
+
+    if (!file) {
+        return false;
+    }
+
+    const bool success = fwrite(data, 1, size, file) == size;
+
+    return !fclose(file) && success;
+}
+
+static bool compareFiles(const char *expectedPath, const char *actualPath) {
+
+    size_t expectedSize = 0;
+    size_t actualSize = 0;
+
+    uint8_t *expected = readFile(expectedPath, &expectedSize);
+    uint8_t *actual = readFile(actualPath, &actualSize);
+
+    bool equal = expected && actual && expectedSize == actualSize && !memcmp(expected, actual, actualSize);
+
+    if (!expected) {
+        printf("Failed to read %s.\n", expectedPath);
+    } else if (!actual) {
+        printf("Failed to read %s.\n", actualPath);
+    } else if (!equal) {
+        printf("%s differs from %s.\n", actualPath, expectedPath);
+    }
+
+    free(expected);
+    free(actual);
+
+    return equal;
+}
+
+// Inverts the CRC-32 of every entry of the central directory and of its local file header
+static bool corruptChecksums(uint8_t *archive, size_t size) {
+
+    size_t end = size >= 22 ? size - 22 : 0;
+
+    while (end > 0 && read32(&archive[end]) != END_OF_CENTRAL_DIRECTORY_SIGNATURE) {
+        end--;
+    }
+
+    if (size < 22 || read32(&archive[end]) != END_OF_CENTRAL_DIRECTORY_SIGNATURE) {
+        return false;
+    }
+
+    const size_t nEntries = read16(&archive[end + 10]);
+    size_t offset = read32(&archive[end + 16]);
+
+    for (size_t i = 0; i < nEntries; i++) {
+
+        if (offset + 46 > end || read32(&archive[offset]) != CENTRAL_DIRECTORY_SIGNATURE) {
+            return false;
+        }
+
+        const size_t localHeader = read32(&archive[offset + 42]);
+
+        if (localHeader + 30 > end) {
+            return false;
+        }
+
+        for (size_t j = 0; j < 4; j++) {
+            archive[offset + 16 + j] ^= 0xFF;
+            archive[localHeader + 14 + j] ^= 0xFF;
+        }
+
+        offset += 46 + (size_t)read16(&archive[offset + 28]) + read16(&archive[offset + 30]) + read16(&archive[offset + 32]);
+    }
+
+    return nEntries > 0;
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 5) {
+        printf("Usage: fmu_archive_test <archive> <unpacked FMU> <cache directory> <file>...\n");
+        return EXIT_FAILURE;
+    }
+
+    const char *archivePath = argv[1];
+    const char *unpackedDirectory = argv[2];
+    const char *cacheDirectory = argv[3];
+
+    char unzipdir[MAX_PATH_LENGTH] = "";
+    char cachedUnzipdir[MAX_PATH_LENGTH] = "";
+    char expectedPath[2 * MAX_PATH_LENGTH] = "";
+    char actualPath[2 * MAX_PATH_LENGTH] = "";
+    char copyPath[2 * MAX_PATH_LENGTH] = "";
+    size_t size = 0;
+    uint8_t *archive = NULL;
+    int exitCode = EXIT_FAILURE;
+
+    // Extract the archive and compare the files with the unpacked FMU
+    if (FMUArchiveExtract(archivePath, cacheDirectory, unzipdir, sizeof(unzipdir)) != FMIOK) {
+        printf("Failed to extract %s.\n", archivePath);
+        goto TERMINATE;
+    }
+
+    for (int i = 4; i < argc; i++) {
+
+        snprintf(expectedPath, sizeof(expectedPath), "%s/%s", unpackedDirectory, argv[i]);
+        snprintf(actualPath, sizeof(actualPath), "%s/%s", unzipdir, argv[i]);
+
+        if (!compareFiles(expectedPath, actualPath)) {
+            goto TERMINATE;
+        }
+    }
+
+    // The second extraction reuses the cached directory
+    if (FMUArchiveExtract(archivePath, cacheDirectory, cachedUnzipdir, sizeof(cachedUnzipdir)) != FMIOK || strcmp(unzipdir, cachedUnzipdir)) {
+        printf("The cached extraction of %s has not been reused.\n", archivePath);
+        goto TERMINATE;
+    }
+
+    archive = readFile(archivePath, &size);
+
+    if (!archive) {
+        printf("Failed to read %s.\n", archivePath);
+        goto TERMINATE;
+    }
+
+    const char *name = strrchr(archivePath, '/');
+    const char *backslash = strrchr(archivePath, '\\');
+
+    if (backslash > name) {
+        name = backslash;
+    }
+
+    name = name ? name + 1 : archivePath;
+
+    // A truncated archive is rejected
+    snprintf(copyPath, sizeof(copyPath), "%s/truncated_%s", cacheDirectory, name);
+
+    if (!writeFile(copyPath, archive, size / 2)) {
+        printf("Failed to write %s.\n", copyPath);
+        goto TERMINATE;
+    }
+
+    if (FMUArchiveExtract(copyPath, cacheDirectory, unzipdir, sizeof(unzipdir)) != FMIError) {
+        printf("The truncated archive %s has not been rejected.\n", copyPath);
+        goto TERMINATE;
+    }
+
+    // An archive with wrong checksums is rejected, even if it looks like the cached one
+    snprintf(copyPath, sizeof(copyPath), "%s/%s", cacheDirectory, name);
+
+    if (!corruptChecksums(archive, size)) {
+        printf("Failed to find the central directory of %s.\n", archivePath);
+        goto TERMINATE;
+    }
+
+    struct stat status;
+    struct utimbuf times;
+
+    if (stat(archivePath, &status)) {
+        printf("Failed to get the modification time of %s.\n", archivePath);
+        goto TERMINATE;
+    }
+
+    times.actime = status.st_atime;
+    times.modtime = status.st_mtime;
+
+    if (!writeFile(copyPath, archive, size) || utime(copyPath, &times)) {
+        printf("Failed to write %s.\n", copyPath);
+        goto TERMINATE;
+    }
+
+    if (FMUArchiveExtract(copyPath, cacheDirectory, unzipdir, sizeof(unzipdir)) != FMIError) {
+        printf("The archive %s with wrong checksums has not been rejected.\n", copyPath);
+        goto TERMINATE;
+    }
+
+    printf("Extracted %s and rejected the truncated and corrupt copies.\n", archivePath);
+
+    exitCode = EXIT_SUCCESS;
+
+TERMINATE:
+    free(archive);
+
+    return exitCode;
+}